@@ -0,0 +1,67 @@
+#include "bench.hpp"
+#include "Expression.hpp"
+#include <cstdio>
+
+using namespace std;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+static void compare(const char* str, const VariableMap& vars){
+	const Expression expr = Expression::parse(str, nullptr);
+	if (!expr){
+		printf("  %-40s parse error\n", str);
+		return;
+	}
+	
+	volatile bool sink;
+	const double tree = measure([&](){ sink = expr.evalTree(vars).getBool(); });
+	const double vm = measure([&](){ sink = expr.eval(vars).getBool(); });
+	(void)sink;
+	
+	printf("  %-40s tree %10.3f M/s   vm %10.3f M/s   %5.2fx\n", str, tree / 1e6, vm / 1e6, vm / tree);
+}
+
+
+REGISTER_BENCH("expression: tree walker vs bytecode", bench_expression_eval);
+void bench_expression_eval(){
+	VariableMap vars;
+	vars.insert("i", 42L);
+	vars.insert("x", 1.5);
+	vars.insert("s", "text");
+	
+	compare("1 + 2 * 3", vars);
+	compare("i * 2 + i / 3 - 1", vars);
+	compare("(i % 7 == 0) || (i > 10 && i <= 100)", vars);
+	compare("x * x + 2.0 * x + 1.0", vars);
+	compare("s + '-' + i", vars);
+	compare("[1, 2, i][2] + ['a': i]['a']", vars);
+	compare("len(s) + i", vars);
+}
+
+
+REGISTER_BENCH("expression: parse", bench_expression_parse);
+void bench_expression_parse(){
+	const char* exprs[] = {
+		"1 + 2 * 3",
+		"i * 2 + i / 3 - 1",
+		"(i % 7 == 0) || (i > 10 && i <= 100)",
+		"s + '-' + i",
+		"[1, 2, i][2] + ['a': i]['a']",
+		"len(s) + i",
+		"['title': s, 'items': [i, i + 1, i + 2], 'sum': i * 3 + 3]",
+	};
+	
+	for (const char* str : exprs){
+		const string_view sv = str;
+		volatile bool sink;
+		const double rate = measure([&](){ sink = bool(Expression::parse(sv, nullptr)); });
+		(void)sink;
+		printf("  %-60s %10.3f M/s %10.1f MB/s\n", str, rate / 1e6, rate * double(sv.length()) / 1e6);
+	}
+
+}
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -0,0 +1,117 @@
+#include "bench.hpp"
+#include "str_map.hpp"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+
+// ----------------------------------- [ Structures ] --------------------------------------- //
+
+
+/**
+ * @brief Previous implementation of `str_map`, one allocated entry per key behind `std::unordered_map`.
+ */
+template<typename T>
+class node_str_map {
+	struct entry {
+		T value;
+		char key[];
+	};
+	
+	unordered_map<string_view,unique_ptr<entry>> map;
+
+public:
+	T& insert(string_view key, T value){
+		auto p = map.try_emplace(key);
+		if (p.second){
+			entry* e = (entry*)::operator new(sizeof(entry) + key.length() + 1, align_val_t(alignof(entry)));
+			copy(key.begin(), key.end(), e->key);
+			e->key[key.length()] = 0;
+			new (&e->value) T(move(value));
+			const_cast<string_view&>(p.first->first) = string_view(e->key, key.length());
+			p.first->second = unique_ptr<entry>(e);
+		} else {
+			p.first->second->value = move(value);
+		}
+		return p.first->second->value;
+	}
+	
+	const T* get(string_view key) const {
+		auto p = map.find(key);
+		return (p != map.end()) ? &p->second->value : nullptr;
+	}
+
+};
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+static vector<string> keys(size_t n, const char* prefix){
+	vector<string> v;
+	for (size_t i = 0 ; i < n ; i++)
+		v.push_back(prefix + to_string(i * 7919));
+	return v;
+}
+
+
+template<typename MAP>
+static void fill(MAP& map, const vector<string>& k){
+	for (size_t i = 0 ; i < k.size() ; i++)
+		map.insert(k[i], long(i));
+}
+
+
+template<typename MAP>
+static long lookup(const MAP& map, const vector<string>& k){
+	long sum = 0;
+	for (const string& s : k){
+		const long* v = map.get(s);
+		sum += (v != nullptr) ? *v : 0;
+	}
+	return sum;
+}
+
+
+static void compare(size_t n, const char* prefix){
+	const vector<string> k = keys(n, prefix);
+	const vector<string> miss = keys(n, "missing/");
+	volatile long sink;
+	
+	const double insert_old = measure([&](){ node_str_map<long> m; fill(m, k); sink = 0; }, 0.1) * n;
+	const double insert_new = measure([&](){ str_map<long> m; fill(m, k); sink = 0; }, 0.1) * n;
+	
+	node_str_map<long> m_old;
+	str_map<long> m_new;
+	fill(m_old, k);
+	fill(m_new, k);
+	
+	const double hit_old = measure([&](){ sink = lookup(m_old, k); }, 0.1) * n;
+	const double hit_new = measure([&](){ sink = lookup(m_new, k); }, 0.1) * n;
+	const double miss_old = measure([&](){ sink = lookup(m_old, miss); }, 0.1) * n;
+	const double miss_new = measure([&](){ sink = lookup(m_new, miss); }, 0.1) * n;
+	(void)sink;
+	
+	printf("  %6zu keys %-24s insert %7.1f -> %7.1f M/s   hit %7.1f -> %7.1f M/s   miss %7.1f -> %7.1f M/s\n",
+		n, prefix,
+		insert_old / 1e6, insert_new / 1e6,
+		hit_old / 1e6, hit_new / 1e6,
+		miss_old / 1e6, miss_new / 1e6
+	);
+}
+
+
+REGISTER_BENCH("str_map: node based vs flat", bench_str_map);
+void bench_str_map(){
+	compare(16, "k");
+	compare(1024, "k");
+	compare(1024, "/usr/share/html-macro/");
+	compare(8192, "k");
+}
+
+
+// ------------------------------------------------------------------------------------------ //
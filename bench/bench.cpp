@@ -0,0 +1,45 @@
+#include "bench.hpp"
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+
+// ----------------------------------- [ Variables ] ---------------------------------------- //
+
+
+/**
+ * @brief Linked list of benchmark function handles.
+ *        It is constructed at start time.
+ */
+BenchList* benchmarks;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+int main(int argc, char const* const* argv){
+	// Reverse list to run benchmarks in registration order
+	BenchList* list = nullptr;
+	while (benchmarks != nullptr){
+		BenchList* b = benchmarks;
+		benchmarks = b->next;
+		b->next = list;
+		list = b;
+	}
+	
+	for (BenchList* b = list ; b != nullptr ; b = b->next){
+		// Optional filter by name
+		if (argc > 1 && strstr(b->name, argv[1]) == nullptr)
+			continue;
+		
+		printf("%s\n", b->name);
+		b->func();
+		printf("\n");
+	}
+	
+	return 0;
+}
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -0,0 +1,60 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+
+
+// ----------------------------------- [ Structures ] --------------------------------------- //
+
+
+using bench_func = void(*)();
+
+struct BenchList {
+	BenchList* next = nullptr;
+	const char* name;
+	bench_func func = nullptr;
+};
+
+
+extern BenchList* benchmarks;
+
+
+#define REGISTER_BENCH(bench_name, f)   \
+	void f();                           \
+	struct _bench_register_t_##f {      \
+		_bench_register_t_##f(){        \
+			benchmarks = new BenchList {\
+				.next = benchmarks,     \
+				.name = bench_name,     \
+				.func = f,              \
+			};                          \
+		}                               \
+	} _bench_register_##f;              \
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+/**
+ * @brief Repeatedly call `f` for roughly `seconds` of wall time.
+ * @return Number of calls per second.
+ */
+template<typename F>
+double measure(F&& f, double seconds = 0.25){
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	const auto end = start + std::chrono::duration<double>(seconds);
+	
+	size_t n = 0;
+	auto now = start;
+	while (now < end){
+		for (int i = 0 ; i < 1024 ; i++)
+			f();
+		n += 1024;
+		now = clock::now();
+	}
+	
+	return double(n) / std::chrono::duration<double>(now - start).count();
+}
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -12,6 +12,7 @@ using namespace html;
 
 bool stderr_isTTY = false;
 bool stdout_isTTY = false;
+constinit thread_local size_t diagnostics = 0;
 
 
 // ----------------------------------- [ Functions ] ---------------------------------------- //
@@ -250,6 +251,13 @@ void warn_unknown_attribute_macro(const Macro& macro, const Attr& attr){
 	printCodeView(pos, attr.name(), ANSI_YELLOW);
 }
 
+void warn_element_written(const Macro& macro, const Node& op, const Node& element){
+	linepos pos = findLine(macro, op.value_p);
+	print_warn_pfx(pos);
+	LOG_STDERR("Element " PURPLE("<%.*s>") " was already written while streaming. " PURPLE("<%.*s>") " ignored.\n", VA_STRV(element.name()), VA_STRV(op.name()));
+	printCodeView(pos, op.name(), ANSI_YELLOW);
+}
+
 
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
@@ -32,6 +32,7 @@
 
 extern bool stderr_isTTY;
 extern bool stdout_isTTY;
+extern constinit thread_local size_t diagnostics;		// Number of messages reported at a source location by the current thread, see `print(linepos)`.
 
 // Switch between ANSI text and plain text: `stderr_isTTY`
 #define LOG_STDERR(format, ...) do {                              \
@@ -145,6 +146,8 @@ void warn_unsupported_type(const Macro& macro, const html::Node& node);
 void warn_unknown_element_macro(const Macro& macro, const html::Node& node);
 // Attribute macro `ATTR` is unknown.
 void warn_unknown_attribute_macro(const Macro& macro, const html::Attr& attr);
+// Element <tag> was already written while streaming and can't be changed by <OP>.
+void warn_element_written(const Macro& macro, const html::Node& op, const html::Node& element);
 
 // ---------------------------------------------------------------- //
 
@@ -18,6 +18,7 @@ struct linepos {
 
 
 inline void print(const linepos& lp){
+	diagnostics++;
 	if (lp.file != nullptr && lp.file[0] != 0){
 		if (lp.row > 0 && lp.col > 0)
 			LOG_STDERR(BOLD("%s:%ld:%ld: "), lp.file, lp.row, lp.col);
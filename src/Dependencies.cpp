@@ -3,14 +3,21 @@
 #include <queue>
 #include <regex>
 #include <fstream>
+#include <algorithm>
 
-#include "fs.hpp"
+#include "Dependencies.hpp"
 #include "Paths.hpp"
 #include "Debug.hpp"
 
 using namespace std;
 
 
+// ----------------------------------- [ Variables ] ---------------------------------------- //
+
+
+constinit thread_local Dependencies* Dependencies::current = nullptr;
+
+
 // ----------------------------------- [ Constants ] ---------------------------------------- //
 
 
@@ -126,4 +133,100 @@ bool printDependencies(const char* mainPath){
 }
 
 
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+// Same file is loaded by every include of it, so lists stay short.
+template<typename T, typename V>
+static void add(vector<T>& list, const V& val){
+	if (find(list.begin(), list.end(), val) == list.end())
+		list.emplace_back(val);
+}
+
+
+void Dependencies::addFile(const filepath& path){
+	add(files, path);
+}
+
+
+void Dependencies::addMissing(const filepath& path){
+	add(missing, path);
+}
+
+
+void Dependencies::addCommand(string_view cmd){
+	add(commands, cmd);
+}
+
+
+bool Dependencies::contains(const filepath& path) const noexcept {
+	return find(files.begin(), files.end(), path) != files.end() || find(missing.begin(), missing.end(), path) != missing.end();
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+// Escape characters with special meaning in make rules.
+static void writePath(ostream& out, const filepath& path){
+	const string& s = path.native();
+	if (s.empty()){
+		out << '.';
+		return;
+	}
+	
+	for (char c : s){
+		switch (c){
+			case ' ':
+			case '#':
+				out << '\\' << c;
+				break;
+			case '$':
+				out << "$$";
+				break;
+			default:
+				out << c;
+				break;
+		}
+	}
+
+}
+
+
+void Dependencies::writeRule(ostream& out, const filepath& target, const filepath& input) const {
+	// Creating a missing file changes modification time of its directory.
+	vector<filepath> prereqs = files;
+	for (const filepath& path : missing){
+		add(prereqs, path.parent_path());
+	}
+	
+	for (const string& cmd : commands){
+		out << "# Shell: ";
+		for (char c : cmd){
+			out << c;
+			if (c == '\n')
+				out << "#        ";
+		}
+		out << '\n';
+	}
+	
+	writePath(out, target);
+	out << ':';
+	for (const filepath& path : prereqs){
+		out << " \\\n  ";
+		writePath(out, path);
+	}
+	out << "\n";
+	
+	for (const filepath& path : prereqs){
+		if (path != input){
+			writePath(out, path);
+			out << ":\n";
+		}
+	}
+	
+	out << '\n';
+}
+
+
 // ------------------------------------------------------------------------------------------ //
\ No newline at end of file
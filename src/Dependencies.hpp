@@ -0,0 +1,75 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "fs.hpp"
+
+
+/**
+ * @brief Files and commands on which the output of a rendered file depends, recorded during evaluation.
+ *        Unlike `printDependencies()`, this also covers paths from expressions and included files which failed to load.
+ */
+struct Dependencies {
+// ------------------------------------[ Properties ] --------------------------------------- //
+public:
+	std::vector<filepath> files;		// Files resolved by `MacroCache::load()`, including files that failed to load.
+	std::vector<filepath> missing;		// Paths probed by `Paths::resolve()` which didn't exist. Creating one changes the resolved file.
+	std::vector<std::string> commands;	// Commands run by `<SHELL>`.
+
+private:
+	static thread_local Dependencies* current;
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	/**
+	 * @brief Record dependencies of the current thread into `deps`.
+	 * @param deps Dependencies to append to, or `nullptr` to stop recording.
+	 */
+	static void record(Dependencies* deps) noexcept {
+		current = deps;
+	}
+	
+	/**
+	 * @brief Get dependencies recorded by the current thread, or `nullptr` if not recording.
+	 */
+	static Dependencies* recording() noexcept {
+		return current;
+	}
+	
+	void addFile(const filepath& path);
+	void addMissing(const filepath& path);
+	void addCommand(std::string_view cmd);
+	
+	/**
+	 * @brief Check if `path` is among the recorded files or missing paths.
+	 */
+	bool contains(const filepath& path) const noexcept;
+	
+	void clear() noexcept {
+		files.clear();
+		missing.clear();
+		commands.clear();
+	}
+	
+	/**
+	 * @brief Write make rule of `target` with recorded files and directories of missing paths as prerequisites.
+	 *        Other prerequisites get empty rules, so make doesn't fail after they are removed.
+	 *        Commands are written as comments, since make can't track them.
+	 * @param input Input file of the target, which doesn't get an empty rule.
+	 */
+	void writeRule(std::ostream& out, const filepath& target, const filepath& input) const;
+
+// ------------------------------------------------------------------------------------------ //
+};
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+/**
+ * @brief Print files referenced by static `SRC` attributes of `<INCLUDE>` macros, without evaluating the file.
+ */
+bool printDependencies(const char* mainPath);
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -1,5 +1,9 @@
 #include "Macro.hpp"
+#include "MacroEngine.hpp"
+#include "ExpressionCache.hpp"
+#include "MacroMemo.hpp"
 #include "str_map.hpp"
+#include "Dependencies.hpp"
 #include "Debug.hpp"
 #include "DebugSource.hpp"
 
@@ -21,8 +25,18 @@ This means that all raw pointers remain valid, since at least 1 macro (root) kee
 // ----------------------------------- [ Variables ] ---------------------------------------- //
 
 
-static str_map<shared_ptr<Macro>> macroFileCache;
-static str_map<shared_ptr<Macro>> macroNameCache;
+// Each thread has its own cache, so macros and their lazily filled caches are never shared between threads.
+static thread_local str_map<shared_ptr<Macro>> macroFileCache;
+static thread_local str_map<shared_ptr<Macro>> macroNameCache;
+static thread_local uint64_t macroNameGeneration = 1;	// Incremented on each change of `macroNameCache`.
+static thread_local uint64_t macroScope = 1;			// Incremented on each `MacroCache::reset()`.
+
+
+// ---------------------------------- [ Constructors ] -------------------------------------- //
+
+
+Macro::Macro() = default;
+Macro::~Macro() = default;
 
 
 // ----------------------------------- [ Functions ] ---------------------------------------- //
@@ -83,7 +97,7 @@ static unique_ptr<Document> split(Node* node){
 }
 
 
-static bool registerChildMacro(const Macro& srcMacro, unique_ptr<Document>&& doc){
+static bool registerChildMacro(Macro& srcMacro, unique_ptr<Document>&& doc){
 	assert(doc != nullptr);
 	const Attr* name_attr = nullptr;
 	
@@ -108,7 +122,7 @@ static bool registerChildMacro(const Macro& srcMacro, unique_ptr<Document>&& doc
 		HERE(warn_expected_attr_double_quote(srcMacro, *name_attr));
 	}
 	
-	unique_ptr<Macro> m = make_unique<Macro>();
+	shared_ptr<Macro> m = make_shared<Macro>();
 	m->name = name_attr->value();
 	m->srcFile = shared_ptr(srcMacro.srcFile);
 	m->srcDir = shared_ptr(srcMacro.srcDir);
@@ -116,7 +130,9 @@ static bool registerChildMacro(const Macro& srcMacro, unique_ptr<Document>&& doc
 	m->html = move(doc);
 	
 	// Register new macro
+	srcMacro.macros.push_back(m);
 	macroNameCache.insert(m->name, move(m));
+	macroNameGeneration++;
 	return true;
 }
 
@@ -153,6 +169,9 @@ bool Macro::parseHTML(){
 		
 	}
 	
+	// Resolve macro opcodes once, before evaluation.
+	MacroEngine::compile(*doc);
+	
 	// Extract and register all child <MACRO> nodes.
 	for (Node* mnode : res.macros){
 		assert(mnode != nullptr && mnode->parent != nullptr);
@@ -186,9 +205,21 @@ shared_ptr<Macro> MacroCache::get(string_view name) noexcept {
 }
 
 
+const shared_ptr<Macro>* MacroCache::find(string_view name) noexcept {
+	return macroNameCache.get(name);
+}
+
+
+uint64_t MacroCache::generation() noexcept {
+	return macroNameGeneration;
+}
+
+
 shared_ptr<Macro> MacroCache::load(filepath& path){
 	if (!Paths::resolve(path)){
 		return nullptr;
+	} else if (Dependencies* deps = Dependencies::recording()){
+		deps->addFile(path);
 	}
 	
 	const string_view path_sv = path.c_str();
@@ -196,6 +227,17 @@ shared_ptr<Macro> MacroCache::load(filepath& path){
 	// Check if cached files.
 	const shared_ptr<Macro>* p = macroFileCache.get(path_sv);
 	if (p != nullptr){
+		Macro& macro = **p;
+		
+		// First use in this scope, register named macros again.
+		if (macro.scope != macroScope){
+			macro.scope = macroScope;
+			for (const shared_ptr<Macro>& m : macro.macros){
+				macroNameCache.insert(m->name, m);
+			}
+			macroNameGeneration++;
+		}
+		
 		return *p;
 	}
 	
@@ -211,6 +253,7 @@ shared_ptr<Macro> MacroCache::load(filepath& path){
 	macro->srcDir = make_shared<filepath>(path.parent_path());
 	macro->type = Macro::getType(path);
 	macro->txt = move(txt);
+	macro->scope = macroScope;
 	
 	// Store macro
 	string_view key = string_view(macro->srcFile->c_str());
@@ -221,9 +264,34 @@ shared_ptr<Macro> MacroCache::load(filepath& path){
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
+void MacroCache::unload(const Macro& macro){
+	if (macro.srcFile != nullptr){
+		unload(*macro.srcFile);
+	}
+}
+
+
+bool MacroCache::unload(const filepath& path){
+	return macroFileCache.remove(string_view(path.c_str()));
+}
+
+
+void MacroCache::reset(){
+	macroNameCache.clear();
+	macroNameGeneration++;
+	macroScope++;
+}
+
+
+uint64_t MacroCache::scope() noexcept {
+	return macroScope;
+}
+
+
 void MacroCache::clear(){
 	macroFileCache.clear();
 	macroNameCache.clear();
+	macroNameGeneration++;
 }
 
 
@@ -3,6 +3,10 @@
 #include "Paths.hpp"
 
 
+class ExpressionCache;
+class MacroMemo;
+
+
 class Macro {
 // ----------------------------------- [ Structures ] --------------------------------------- //
 public:
@@ -20,6 +24,17 @@ public:
 	std::shared_ptr<const std::string> txt;		// `Type::TXT`
 	std::shared_ptr<html::Document> html;		// `Type::HTML`
 	
+	std::unique_ptr<ExpressionCache> expressions;	// Parsed expressions from `html`, created on first use.
+	std::unique_ptr<MacroMemo> memo;				// Recorded calls of the macro, created on first call.
+	
+	std::vector<std::shared_ptr<Macro>> macros;		// Named `<MACRO>` children of the file, registered when the file is used.
+	uint64_t scope = 0;								// `MacroCache::scope()` in which `macros` were last registered.
+	
+// ---------------------------------- [ Constructors ] -------------------------------------- //
+public:
+	Macro();
+	~Macro();
+	
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 public:
 	/**
@@ -41,6 +56,9 @@ public:
 
 
 
+/**
+ * @brief Cache of macro files and named macros. Each thread has its own cache.
+ */
 namespace MacroCache {
 	/**
 	 * @brief Get macro from cache.
@@ -49,6 +67,19 @@ namespace MacroCache {
 	 */
 	std::shared_ptr<Macro> get(std::string_view name) noexcept;
 	
+	/**
+	 * @brief Get macro from cache without copying the handle.
+	 * @param name Name of the macro.
+	 * @return Pointer to the cached handle, valid until `generation()` changes. `nullptr` if it is not cached.
+	 */
+	const std::shared_ptr<Macro>* find(std::string_view name) noexcept;
+	
+	/**
+	 * @brief Counter incremented whenever named macros are added, shadowed or cleared.
+	 *        Used for validating results of `find()` kept by callers.
+	 */
+	uint64_t generation() noexcept;
+	
 	/**
 	 * @brief Get cached macro file or load new one into the cache.
 	 * @param filePath File path of the macro. If macro is not cached, this file is parsed and the new macro is cached.
@@ -57,6 +88,31 @@ namespace MacroCache {
 	 */
 	std::shared_ptr<Macro> load(filepath& filePath);
 	
+	/**
+	 * @brief Remove a macro file from the cache, e.g. a page which is not needed anymore.
+	 *        Named macros of the file remain registered until the next `reset()`.
+	 */
+	void unload(const Macro& macro);
+	
+	/**
+	 * @brief Remove a macro file from the cache, e.g. after the file changed.
+	 * @param filePath Path of the file as resolved by `load()`.
+	 * @return `false` if the file is not cached.
+	 */
+	bool unload(const filepath& filePath);
+	
+	/**
+	 * @brief Start a new scope for processing another input file.
+	 *        Named macros are forgotten, but files stay cached with their parsed documents.
+	 *        Named macros of a cached file are registered again when it is loaded in the new scope.
+	 */
+	void reset();
+	
+	/**
+	 * @brief Counter incremented by `reset()`.
+	 */
+	uint64_t scope() noexcept;
+	
 	/**
 	 * @brief Clear cache. This can be dangerous since a lot of `html` objects use raw pointers.
 	 *        This should be done at the end of the program or when deleting all `html` objects.
@@ -13,18 +13,17 @@ void MacroEngine::branch_if(const Node& op, Node& dst){
 	
 	// Chain of `&&` statements
 	for (const Attr* attr = op.attribute ; attr != nullptr ; attr = attr->next){
-		string_view name = attr->name();
-		assert(!name.empty());
+		assert(!attr->name().empty());
 		
 		// Check if expression evaluates to `true`
-		if (name == "TRUE"){
+		if (opcode(*attr) == Opcode::TRUE){
 			if (!eval_attr_true(op, *attr))
 				goto fail;
 			continue;
 		}
 		
 		// Check if expression evaluates to `false`
-		else if (name == "FALSE"){
+		else if (opcode(*attr) == Opcode::FALSE){
 			if (!eval_attr_false(op, *attr))
 				goto fail;
 			continue;
@@ -43,9 +42,9 @@ void MacroEngine::branch_if(const Node& op, Node& dst){
 	
 	// pass:
 	{
-		Node* _last = dst.child;
+		const Node* _last = enter_parent_space(op, dst);
 		evalChildren(op, dst);
-		transfer_parent_space(op, dst, _last);
+		leave_parent_space(op, dst, _last);
 		
 		MacroEngine::currentBranch_block = Branch::PASSED;
 		return;
@@ -107,8 +106,6 @@ long MacroEngine::loop_for(const Node& op, Node& dst){
 	const Attr* attr_inc = nullptr;
 	
 	for (const Attr* attr = op.attribute ; attr != nullptr ; attr = attr->next){
-		string_view name = attr->name();
-		
 		// Check IF, ELIF, ELSE
 		switch (try_eval_attr_if_elif_else(op, *attr)){
 			case Branch::FAILED: return 0;
@@ -117,8 +114,9 @@ long MacroEngine::loop_for(const Node& op, Node& dst){
 		}
 		
 		// Second argument: condition
-		if (name == "TRUE" || name == "FALSE"){
-			cond_expected = (name[0] != 'F');
+		const Opcode code = opcode(*attr);
+		if (code == Opcode::TRUE || code == Opcode::FALSE){
+			cond_expected = (code == Opcode::TRUE);
 			
 			if (attr_cond != nullptr){
 				HERE(error_duplicate_attr(*macro, *attr_cond, *attr));
@@ -150,17 +148,17 @@ long MacroEngine::loop_for(const Node& op, Node& dst){
 	}
 	
 	// Parse expressions
-	Expression expr_setup = {};
-	Expression expr_cond = {};
-	Expression expr_inc = {};
+	const Expression* expr_setup = nullptr;
+	const Expression* expr_cond = nullptr;
+	const Expression* expr_inc = nullptr;
 	
 	if (attr_setup != nullptr){
 		if (attr_setup->options % NodeOptions::SINGLE_QUOTE == false){
 			HERE(warn_expected_attr_single_quote(*macro, *attr_setup));
 		}
 		
-		expr_setup = Expression::parse(attr_setup->value(), macro);
-		if (!expr_setup){
+		expr_setup = &expression(attr_setup->value());
+		if (!*expr_setup){
 			return 0;
 		}
 	}
@@ -170,8 +168,8 @@ long MacroEngine::loop_for(const Node& op, Node& dst){
 			HERE(warn_expected_attr_single_quote(*macro, *attr_cond));
 		}
 		
-		expr_cond = Expression::parse(attr_cond->value(), macro);
-		if (!expr_cond){
+		expr_cond = &expression(attr_cond->value());
+		if (!*expr_cond){
 			return 0;
 		}
 		
@@ -185,26 +183,28 @@ long MacroEngine::loop_for(const Node& op, Node& dst){
 			HERE(warn_expected_attr_single_quote(*macro, *attr_inc));
 		}
 		
-		expr_inc = Expression::parse(attr_inc->value(), macro);
-		if (!expr_inc){
+		expr_inc = &expression(attr_inc->value());
+		if (!*expr_inc){
 			return 0;
 		}
 		
 	}
 	
 	// Run setup
-	if (expr_setup){
-		variables->insert(attr_setup->name(), expr_setup.eval(*variables));
+	if (expr_setup != nullptr){
+		variables->insert(symbol(attr_setup->name()), expr_setup->eval(*variables));
 	}
 	
+	const Symbol sym_inc = (expr_inc != nullptr) ? symbol(attr_inc->name()) : Symbols::NONE;
+	
 	// Run loop
 	long i = 0;
-	while (expr_cond.eval(*variables).getBool() == cond_expected){
+	while (expr_cond->eval(*variables).getBool() == cond_expected){
 		evalChildren(op, dst);
 		
 		// Increment
-		if (expr_inc){
-			variables->insert(attr_inc->name(), expr_inc.eval(*variables));
+		if (expr_inc != nullptr){
+			variables->insert(sym_inc, expr_inc->eval(*variables));
 		}
 		
 		i++;
@@ -224,8 +224,6 @@ long MacroEngine::loop_while(const Node& op, Node& dst){
 	
 	// Parse attributes
 	for (const Attr* attr = op.attribute ; attr != nullptr ; attr = attr->next){
-		string_view name = attr->name();
-		
 		// Check IF, ELIF, ELSE
 		switch (try_eval_attr_if_elif_else(op, *attr)){
 			case Branch::FAILED: return 0;
@@ -233,8 +231,9 @@ long MacroEngine::loop_while(const Node& op, Node& dst){
 			case Branch::NONE: break;
 		}
 		
-		if (name == "TRUE" || name == "FALSE"){
-			cond_expected = (name[0] == 'T');
+		const Opcode code = opcode(*attr);
+		if (code == Opcode::TRUE || code == Opcode::FALSE){
+			cond_expected = (code == Opcode::TRUE);
 			
 			if (attr_cond != nullptr){
 				HERE(error_duplicate_attr(*macro, *attr_cond, *attr));
@@ -252,15 +251,15 @@ long MacroEngine::loop_while(const Node& op, Node& dst){
 	}
 	
 	// Parse expressions
-	Expression expr_cond = {};
+	const Expression* expr_cond = nullptr;
 	
 	if (attr_cond != nullptr){
 		if (attr_cond->options % NodeOptions::SINGLE_QUOTE == false){
 			HERE(warn_expected_attr_single_quote(*macro, *attr_cond));
 		}
 		
-		expr_cond = Expression::parse(attr_cond->value(), macro);
-		if (!expr_cond){
+		expr_cond = &expression(attr_cond->value());
+		if (!*expr_cond){
 			return 0;
 		}
 		
@@ -271,7 +270,7 @@ long MacroEngine::loop_while(const Node& op, Node& dst){
 	
 	// Run
 	long i = 0;
-	while (expr_cond.eval(*variables).getBool() == cond_expected){
+	while (expr_cond->eval(*variables).getBool() == cond_expected){
 		evalChildren(op, dst);
 		i++;
 	}
@@ -31,21 +31,46 @@ void MacroEngine::transfer_parent_space(const Node& op, Node& dst, const Node* d
 }
 
 
+const Node* MacroEngine::enter_parent_space(const Node& op, Node& dst){
+	if (stream != nullptr){
+		stream->spaces.push_back(ParentSpace{&op, &dst, dst.child, false});
+	}
+	return dst.child;
+}
+
+
+void MacroEngine::leave_parent_space(const Node& op, Node& dst, const Node* prev_last_child){
+	if (stream == nullptr){
+		transfer_parent_space(op, dst, prev_last_child);
+		return;
+	}
+	
+	const ParentSpace space = stream->spaces.back();
+	stream->spaces.pop_back();
+	assert(space.op == &op && space.dst == &dst);
+	
+	// First new child was already written and original last child may be freed,
+	// only trailing space remains.
+	if (space.before){
+		dst.child->options |= (op.options & NodeOptions::SPACE_AFTER);
+		return;
+	}
+	
+	transfer_parent_space(op, dst, prev_last_child);
+}
+
+
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
 Branch MacroEngine::try_eval_attr_if_elif_else(const Node& op, const Attr& attr){
 	assert(macro != nullptr);
-	string_view name = attr.name();
-	
-	if (name == "IF"){
-		goto _if;
-	} else if (name == "ELIF"){
-		goto _elif;
-	} else if (name == "ELSE"){
-		goto _else;
-	} else {
-		return Branch::NONE;
+	
+	switch (opcode(attr)){
+		case Opcode::IF: goto _if;
+		case Opcode::ELIF: goto _elif;
+		case Opcode::ELSE: goto _else;
+		default: return Branch::NONE;
 	}
 	
 	// -------------------------------- //
@@ -90,7 +115,7 @@ Branch MacroEngine::try_eval_attr_if_elif_else(const Node& op, const Attr& attr)
 		HERE(warn_expected_attr_single_quote(*macro, attr));
 	}
 	
-	const Expression expr = Expression::parse(expr_str, macro);
+	const Expression& expr = expression(expr_str);
 	if (!expr){
 		return MacroEngine::currentBranch_inline = Branch::FAILED;
 	}
@@ -114,7 +139,7 @@ bool MacroEngine::eval_attr_bool(const Node& op, const Attr& attr, bool& value){
 		HERE(warn_expected_attr_single_quote(*macro, attr));
 	}
 	
-	Expression expr = Expression::parse(expr_str, macro);
+	const Expression& expr = expression(expr_str);
 	if (!expr){
 		return false;
 	}
@@ -144,7 +169,7 @@ bool MacroEngine::eval_attr_value(const Node& op, const Attr& attr, Value& out_r
 	
 	// Evaluate expression
 	else if (attr.options % NodeOptions::SINGLE_QUOTE){
-		Expression expr = Expression::parse(attr.value(), macro);
+		const Expression& expr = expression(attr.value());
 		if (!expr){
 			return false;
 		}
@@ -178,12 +203,15 @@ bool MacroEngine::eval_attr_value(const Node& op, const Attr& attr, string& buff
 	
 	// Evaluate expression
 	else if (attr.options % NodeOptions::SINGLE_QUOTE){
-		Expression expr = Expression::parse(attr.value(), macro);
+		const Expression& expr = expression(attr.value());
 		if (!expr){
 			return false;
 		}
 		
-		expr.eval(*variables).toStr(buff);
+		if (expr.isConstant())
+			expr.constantValue().toStr(buff);
+		else
+			expr.eval(*variables).toStr(buff);
 		result = buff;
 	}
 	
@@ -208,60 +236,7 @@ bool MacroEngine::eval_attr_value(const Node& op, const Attr& attr, string& buff
 
 bool MacroEngine::eval_string_interpolate(string_view str, string& buff){
 	assert(macro != nullptr);
-	
-	bool res = true;
-	const char* const end = str.end();
-	const char* beg = str.begin();
-	
-	while (beg != end){
-		const char* a;	// expr begin
-		const char* b;	// expr end
-		
-		// Find starting point '{'
-		a = beg;
-		while (a != end){
-			if (*a == '{'){
-				break;
-			} else if (a[0] == '\\' && a+1 != end){
-				if (a[1] == '{' || a[1] == '\\'){
-					buff.append(beg, a);
-					beg = ++a;
-				}
-			}
-			a++;
-		}
-		
-		// Find end point '}'
-		b = a;
-		while (b != end){
-			if (*b == '}')
-				break;
-			b++;
-		}
-		
-		// Append prefix
-		if (b == end){
-			buff.append(beg, b);
-			break;
-		} else {
-			buff.append(beg, a);
-		}
-		
-		// Evaluate expression
-		assert(*a == '{' && *b == '}');
-		Expression expr = Expression::parse(string_view(a+1, b), macro);
-		
-		if (expr){
-			expr.eval(*variables).toStr(buff);
-		} else {
-			res = false;
-			buff.append(a, b+1);
-		}
-		
-		beg = b+1;
-	}
-	
-	return res;
+	return interpolation(str).eval(*variables, buff);
 }
 
 
@@ -280,7 +255,7 @@ Branch MacroEngine::attr_equals_variable(const Node& op, const Attr& attr){
 	
 	// Evaluate expression
 	else if (attr.options % NodeOptions::SINGLE_QUOTE){
-		Expression expr = Expression::parse(attr.value(), macro);
+		const Expression& expr = expression(attr.value());
 		if (!expr){
 			return MacroEngine::Branch::NONE;
 		}
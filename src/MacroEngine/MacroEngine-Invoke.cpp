@@ -1,7 +1,10 @@
 #include "MacroEngine.hpp"
+#include "MacroMemo.hpp"
 #include "stack_vector.hpp"
 #include "fs.hpp"
 #include "Debug.hpp"
+#include <algorithm>
+#include <chrono>
 
 using namespace std;
 using namespace html;
@@ -11,7 +14,7 @@ using namespace html;
 
 
 struct var_copy {
-	string_view name;
+	Symbol sym;
 	Value value;
 	bool defined = false;
 };
@@ -20,6 +23,174 @@ struct var_copy {
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
+/**
+ * @brief Get recorded calls of `macro`, or `nullptr` if calls of the macro can't be memoized.
+ */
+static MacroMemo* _memo(Macro& macro, const Document& doc){
+	if (macro.memo == nullptr){
+		macro.memo = make_unique<MacroMemo>();
+		macro.memo->purity = MacroMemo::pure(macro) ? MacroMemo::Purity::PURE : MacroMemo::Purity::IMPURE;
+	}
+	
+	MacroMemo& memo = *macro.memo;
+	if (memo.purity != MacroMemo::Purity::PURE){
+		return nullptr;
+	}
+	
+	// Macros called by the recorded calls may have been shadowed,
+	// and outputs of previous renders are freed with their documents.
+	const uint64_t generation = MacroCache::generation();
+	if (memo.generation != generation || memo.document != &doc){
+		memo.shapes.clear();
+		memo.entries.clear();
+		memo.generation = generation;
+		memo.document = &doc;
+	}
+	
+	return &memo;
+}
+
+
+static size_t _hash(const stack_vector<var_copy,2>& args){
+	size_t hash = 0;
+	for (const var_copy& arg : args)
+		hash += MacroMemo::hash(arg.sym, arg.value);
+	return hash;
+}
+
+
+static bool _matches(const MacroMemo::Entry& entry, const stack_vector<var_copy,2>& args, const VariableMap& vars){
+	if (entry.args.size() != size_t(args.size())){
+		return false;
+	}
+	
+	for (const MacroMemo::Input& in : entry.args){
+		const var_copy* arg = args.begin();
+		while (arg != args.end() && arg->sym != in.sym)
+			arg++;
+		if (arg == args.end() || !MacroMemo::same(arg->value, in.value))
+			return false;
+	}
+	
+	for (const MacroMemo::Input& in : entry.reads){
+		const Value* var = vars.get(in.sym);
+		if ((var != nullptr) != in.defined || (var != nullptr && !MacroMemo::same(*var, in.value)))
+			return false;
+	}
+	
+	return true;
+}
+
+
+/**
+ * @brief Find recorded call with the same arguments, whose other inputs equal current variables.
+ * @param hash Hash of the arguments.
+ */
+static const MacroMemo::Entry* _find(const MacroMemo& memo, size_t hash, const stack_vector<var_copy,2>& args, const VariableMap& vars){
+	static const Value undefined = Value();
+	
+	for (const vector<Symbol>& shape : memo.shapes){
+		size_t h = hash;
+		for (Symbol sym : shape){
+			const Value* var = vars.get(sym);
+			h += MacroMemo::hash(sym, (var != nullptr) ? *var : undefined);
+		}
+		
+		auto [beg, end] = memo.entries.equal_range(h);
+		for (auto it = beg ; it != end ; it++){
+			if (_matches(it->second, args, vars))
+				return &it->second;
+		}
+	
+	}
+	
+	return nullptr;
+}
+
+
+/**
+ * @brief Store recorded call, unless the macro already has too many different read lists.
+ * @param hash Hash of the arguments.
+ */
+static void _store(MacroMemo& memo, size_t hash, MacroMemo::Entry&& entry){
+	vector<Symbol> shape;
+	shape.reserve(entry.reads.size());
+	for (const MacroMemo::Input& in : entry.reads){
+		shape.push_back(in.sym);
+		hash += MacroMemo::hash(in.sym, in.value);
+	}
+	
+	if (find(memo.shapes.begin(), memo.shapes.end(), shape) == memo.shapes.end()){
+		if (memo.shapes.size() >= MacroMemo::MAX_SHAPES)
+			return;
+		memo.shapes.emplace_back(move(shape));
+	}
+	
+	memo.entries.emplace(hash, move(entry));
+}
+
+
+/**
+ * @brief Borrow recorded output of a call.
+ */
+static void _replay(MacroEngine& self, const Node& output, Node& dst){
+	for (const Node* child = output.child ; child != nullptr ; child = child->next){
+		Node& node = *dst.appendChild(self.newNode(NodeType::BORROWED));
+		node.borrowed = (child->type == NodeType::BORROWED) ? child->borrowed : child;
+		node.options = child->options & ~(NodeOptions::OWNED_NAME | NodeOptions::OWNED_VALUE);
+	}
+}
+
+
+/**
+ * @brief Execute macro while tracing read variables and store the output in `memo`.
+ *        The call is not stored if it evaluated an impure macro or reported any diagnostics.
+ * @param hash Hash of the arguments.
+ * @param entry Entry with arguments of the call, which are already applied to the variables.
+ */
+static void _record(MacroEngine& self, const shared_ptr<Macro>& macro, MacroMemo& memo, size_t hash, MacroMemo::Entry&& entry, Node& dst){
+	assert(self.variables->trace == nullptr);
+	
+	Node& output = *self.document().nodeAlloc->create();
+	VariableMap::Trace trace;
+	const size_t reported = diagnostics;
+	const uint64_t generation = MacroCache::generation();
+	const auto t = chrono::steady_clock::now();
+	
+	// Recorded output is replayed by later calls, so it is not streamed and freed.
+	// Its shell commands are joined before it is replayed.
+	MacroEngine::Stream* const stream = self.stream;
+	MacroEngine::Shells* const shells = self.shells;
+	self.stream = nullptr;
+	self.shells = nullptr;
+	self.variables->trace = &trace;
+	self.exec(macro, output);
+	self.variables->trace = nullptr;
+	self.stream = stream;
+	self.shells = shells;
+	
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - t).count();
+	MacroMemo::normalize(output);
+	
+	if (trace.valid && diagnostics == reported && MacroCache::generation() == generation){
+		memo.seconds = memo.entries.empty() ? seconds : min(memo.seconds, seconds);
+		for (VariableMap::Trace::Read& read : trace.reads){
+			auto p = find_if(entry.args.begin(), entry.args.end(), [&](const MacroMemo::Input& arg){ return arg.sym == read.sym; });
+			if (p == entry.args.end())
+				entry.reads.emplace_back(move(read));
+		}
+		
+		entry.output = &output;
+		_store(memo, hash, move(entry));
+	}
+	
+	_replay(self, output, dst);
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
 static void _invoke_macro(MacroEngine& self, const Node& op, shared_ptr<Macro>&& macro, stack_vector<var_copy,2>& args, Node& dst){
 	assert(macro != nullptr);
 	assert(self.variables != nullptr);
@@ -33,29 +204,30 @@ static void _invoke_macro(MacroEngine& self, const Node& op, shared_ptr<Macro>&&
 		string_view name = param->name();
 		assert(!name.empty());
 		
-		if (name == "NAME"){
+		if (MacroEngine::opcode(*param) == MacroEngine::Opcode::NAME){
 			continue;
 		}
 		
 		// Check if default value needed
+		const Symbol sym = MacroEngine::symbol(*macro, name);
 		for (var_copy& v : args){
-			if (v.name == name)
+			if (v.sym == sym)
 				goto next;
 		}
 		
 		// Clone variable
 		if (param->value_p == nullptr){
-			Value* var = self.variables->get(name);
+			Value* var = self.variables->get(sym);
 			
 			if (var != nullptr)
-				args.emplace_back(name, *var, true);
+				args.emplace_back(sym, *var, true);
 			else
-				args.emplace_back(name);
+				args.emplace_back(sym);
 		}
 		
 		// Evaluate default value
 		else {
-			Value& arg = args.emplace_back(name).value;
+			Value& arg = args.emplace_back(sym).value;
 			if (!self.eval_attr_value(op, *param, arg))
 				return;
 		}
@@ -63,43 +235,83 @@ static void _invoke_macro(MacroEngine& self, const Node& op, shared_ptr<Macro>&&
 		next: continue;
 	}
 	
+	// Replay recorded call of a pure macro
+	MacroMemo* const memo = _memo(*macro, self.document());
+	VariableMap::Trace* const trace = self.variables->trace;
+	size_t hash = 0;
+	
+	if (memo == nullptr){
+		if (trace != nullptr)
+			trace->valid = false;
+	} else if (!memo->disabled){
+		hash = _hash(args);
+		if (const MacroMemo::Entry* entry = _find(*memo, hash, args, *self.variables)){
+			memo->hits++;
+			Stats::memo.hits++;
+			Stats::memoSeconds += memo->seconds;
+			_replay(self, *entry->output, dst);
+			return;
+		}
+		
+		memo->misses++;
+		Stats::memo.misses++;
+		
+		// Stop memoizing calls which rarely repeat.
+		if (memo->misses >= MacroMemo::MAX_ENTRIES && memo->hits < memo->misses){
+			memo->disabled = true;
+			memo->shapes.clear();
+			memo->entries.clear();
+		}
+	
+	}
+	
+	// Calls within a recorded call are not recorded separately.
+	const bool record = (memo != nullptr && !memo->disabled && trace == nullptr && memo->entries.size() < MacroMemo::MAX_ENTRIES);
+	MacroMemo::Entry entry;
+	if (record){
+		for (const var_copy& arg : args)
+			entry.args.emplace_back(arg.sym, true, arg.value);
+	}
+	
 	// Apply arguments to variable list
 	for (var_copy& arg : args){
-		Value* var = self.variables->get(arg.name);
+		Value* var = self.variables->get(arg.sym);
 		
 		if (var != nullptr){
 			swap(arg.value, *var);
 			arg.defined = true;
 		} else {
-			self.variables->insert(arg.name, move(arg.value));
+			self.variables->insert(arg.sym, move(arg.value));
 		}
-		
+	
 	}
 	
-	self.exec(move(macro), dst);
+	if (record)
+		_record(self, macro, *memo, hash, move(entry), dst);
+	else
+		self.exec(move(macro), dst);
 	
 	// Restore argument list
 	for (var_copy& arg : args){
 		if (arg.defined)
-			self.variables->insert(arg.name, move(arg.value));
+			self.variables->insert(arg.sym, move(arg.value));
 		else
-			self.variables->remove(arg.name);
+			self.variables->remove(arg.sym);
 	}
-	
+
 }
 
 
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
-bool MacroEngine::call_userElementMacro(const Node& op, Node& dst){
+bool MacroEngine::call_userElementMacro(const Node& op, const shared_ptr<Macro>& target, Node& dst){
 	assert(macro != nullptr);
+	assert(target != nullptr);
 	
-	// Verify macro existance
-	shared_ptr<Macro> target_macro = MacroCache::get(op.name());
-	if (target_macro == nullptr){
-		return false;
-	} else if (target_macro->html == nullptr){
+	// Keep the macro alive even if it is shadowed during the call.
+	shared_ptr<Macro> target_macro = target;
+	if (target_macro->html == nullptr){
 		HERE(warn_macro_not_invokable(*macro, op.name(), op.name()));
 		return false;
 	}
@@ -117,17 +329,17 @@ bool MacroEngine::call_userElementMacro(const Node& op, Node& dst){
 			case Branch::NONE: break;
 		}
 		
-		var_copy& var = args.emplace_back(name);
+		var_copy& var = args.emplace_back(symbol(name));
 		
 		// Clone global variable or evaluate new local
 		if (attr->value_p == nullptr){
-			Value* gvar = variables->get(name);
+			Value* gvar = variables->get(var.sym);
 			if (gvar != nullptr)
 				var.value = *gvar;
 		} else if (!eval_attr_value(op, *attr, var.value)){
 			return true;
 		}
-		
+	
 	}
 	
 	_invoke_macro(*this, op, move(target_macro), args, dst);
@@ -138,10 +350,14 @@ bool MacroEngine::call_userElementMacro(const Node& op, Node& dst){
 bool MacroEngine::call_userAttrMacro(const Node& op, const Attr& attr, Node& dst){
 	assert(!attr.name().empty());
 	
-	shared_ptr<Macro> target_macro = MacroCache::get(attr.name());
-	if (target_macro == nullptr ){
+	const shared_ptr<Macro>* target = userMacro(attr.name());
+	if (target == nullptr){
 		return false;
-	} else if (target_macro->html == nullptr){
+	}
+	
+	// Keep the macro alive even if it is shadowed during the call.
+	shared_ptr<Macro> target_macro = *target;
+	if (target_macro->html == nullptr){
 		HERE(warn_macro_not_invokable(*macro, attr.name(), attr.name()));
 		return false;
 	}
@@ -150,7 +366,8 @@ bool MacroEngine::call_userAttrMacro(const Node& op, const Attr& attr, Node& dst
 	
 	// Store attribute value as argument `VALUE`
 	if (attr.value_p != nullptr){
-		var_copy& arg = args.emplace_back("VALUE");
+		static const Symbol VALUE = Symbols::intern("VALUE");
+		var_copy& arg = args.emplace_back(VALUE);
 		if (!eval_attr_value(op, attr, arg.value))
 			return true;
 	}
@@ -174,7 +391,7 @@ void MacroEngine::call(const Node& op, Node& dst){
 	for (const Attr* attr = op.attribute ; attr != nullptr ; attr = attr->next){
 		string_view name = attr->name();
 		
-		if (name == "NAME"){
+		if (opcode(*attr) == Opcode::NAME){
 			if (name_attr == nullptr)
 				name_attr = attr;
 			else
@@ -189,17 +406,17 @@ void MacroEngine::call(const Node& op, Node& dst){
 			case Branch::NONE: break;
 		}
 		
-		var_copy& var = args.emplace_back(name);
+		var_copy& var = args.emplace_back(symbol(name));
 		
 		// Clone global variable or evaluate new local
 		if (attr->value_p == nullptr){
-			Value* gvar = variables->get(name);
+			Value* gvar = variables->get(var.sym);
 			if (gvar != nullptr)
 				var.value = *gvar;
 		} else if (!eval_attr_value(op, *attr, var.value)){
 			return;
 		}
-		
+	
 	}
 	
 	// Eval macro name
@@ -295,7 +512,7 @@ static void _include_header(MacroEngine& self, const Node& op, const Attr& src){
 			if (file_macro->txt == nullptr)
 				HERE(error_include_file_fail(*self.macro, path.c_str(), src.value()));
 		} break;
-		
+	
 	}
 	
 	return;
@@ -329,7 +546,7 @@ static void _include_macro(MacroEngine& self, const Node& op, const Attr& src, s
 		return;
 	}
 	
-	Node* const original_first = dst.child;
+	const Node* const original_first = self.enter_parent_space(op, dst);
 	
 	switch (file_macro->type){
 		case Macro::Type::HTML: {
@@ -340,28 +557,28 @@ static void _include_macro(MacroEngine& self, const Node& op, const Attr& src, s
 			
 			// Apply arguments to variable list
 			for (var_copy& arg : args){
-				Value* var = self.variables->get(arg.name);
+				Value* var = self.variables->get(arg.sym);
 				
 				if (var != nullptr){
 					swap(arg.value, *var);
 					arg.defined = true;
 				} else {
-					self.variables->insert(arg.name, move(arg.value));
+					self.variables->insert(arg.sym, move(arg.value));
 				}
-				
+			
 			}
-
+			
 			assert(file_macro->html != nullptr);
 			self.exec(file_macro, dst);
-
+			
 			// Restore argument list
 			for (var_copy& arg : args){
 				if (arg.defined)
-					self.variables->insert(arg.name, move(arg.value));
+					self.variables->insert(arg.sym, move(arg.value));
 				else
-					self.variables->remove(arg.name);
+					self.variables->remove(arg.sym);
 			}
-			
+		
 		} break;
 		
 		case Macro::Type::CSS: {
@@ -373,7 +590,7 @@ static void _include_macro(MacroEngine& self, const Node& op, const Attr& src, s
 			Node* parent = &dst;
 			if (wrap){
 				parent = dst.appendChild(self.newNode(NodeType::TAG));
-				parent->name(*self.macro->html, string_view("style"));
+				parent->name(self.document(), string_view("style"));
 			}
 			
 			Node& txt = *parent->appendChild(self.newNode(NodeType::TEXT));
@@ -390,7 +607,7 @@ static void _include_macro(MacroEngine& self, const Node& op, const Attr& src, s
 			Node* parent = &dst;
 			if (wrap){
 				parent = dst.appendChild(self.newNode(NodeType::TAG));
-				parent->name(*self.macro->html, string_view("script"));
+				parent->name(self.document(), string_view("script"));
 			}
 			
 			Node& txt = *parent->appendChild(self.newNode(NodeType::TEXT));
@@ -412,12 +629,11 @@ static void _include_macro(MacroEngine& self, const Node& op, const Attr& src, s
 		_fail:
 		default: {
 			HERE(error_include_file_fail(*self.macro, path.c_str(), src.value()));
-			return;
-		};
-		
+		} break;
+	
 	}
 	
-	MacroEngine::transfer_parent_space(op, dst, original_first);
+	self.leave_parent_space(op, dst, original_first);
 }
 
 
@@ -433,7 +649,7 @@ void MacroEngine::include(const Node& op, Node& dst){
 	for (const Attr* attr = op.attribute ; attr != nullptr ; attr = attr->next){
 		string_view name = attr->name();
 		
-		if (name == "SRC"){
+		if (opcode(*attr) == Opcode::SRC){
 			if (src_attr == nullptr)
 				src_attr = attr;
 			else
@@ -441,7 +657,7 @@ void MacroEngine::include(const Node& op, Node& dst){
 			continue;
 		}
 		
-		else if (name == "HEADER"){
+		else if (opcode(*attr) == Opcode::HEADER){
 			if (attr->value_p != nullptr)
 				HERE(warn_ignored_attr_value(*macro, *attr));
 			header = true;
@@ -461,7 +677,7 @@ void MacroEngine::include(const Node& op, Node& dst){
 			continue;
 		}
 		
-		else if (name == "NO-WRAP"){
+		else if (opcode(*attr) == Opcode::NO_WRAP){
 			if (attr->value_p != nullptr)
 				HERE(warn_ignored_attr_value(*macro, *attr));
 			wrap = false;
@@ -469,16 +685,16 @@ void MacroEngine::include(const Node& op, Node& dst){
 		}
 		
 		// Push argument
-		var_copy& var = args.emplace_back(name);
+		var_copy& var = args.emplace_back(symbol(name));
 		
 		if (attr->value_p == nullptr){
-			Value* gvar = variables->get(name);
+			Value* gvar = variables->get(var.sym);
 			if (gvar != nullptr)
 				var.value = *gvar;
 		} else if (!eval_attr_value(op, *attr, var.value)){
 			return;
 		}
-		
+	
 	}
 	
 	if (src_attr == nullptr){
@@ -488,7 +704,7 @@ void MacroEngine::include(const Node& op, Node& dst){
 	} else {
 		_include_macro(*this, op, *src_attr, args, wrap, dst);
 	}
-	
+
 }
 
 
@@ -45,24 +45,25 @@ void MacroEngine::set(const Node& op){
 		
 		// Expression
 		if (attr->options % NodeOptions::SINGLE_QUOTE){
-			Expression expr = Expression::parse(value, macro);
+			const Expression& expr = expression(value);
 			if (!expr){
 				return;
 			}
 			
-			variables->insert(name, expr.eval(*variables));
+			const Symbol sym = symbol(name);
+			variables->insert(sym, expr.evalAssign(*variables, sym));
 		}
 		
 		// Interpolate
 		else if (attr->options % NodeOptions::INTERPOLATE){
 			buff.clear();
 			if (eval_string_interpolate(value, buff))
-				variables->insert(name, move(buff));
+				variables->insert(symbol(name), move(buff));
 		}
 		
 		// Plain text
 		else {
-			variables->insert(name, value);
+			variables->insert(symbol(name), value);
 		}
 		
 	}
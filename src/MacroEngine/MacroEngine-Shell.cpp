@@ -1,9 +1,14 @@
 #include "MacroEngine.hpp"
 #include <thread>
+#include <charconv>
+#include <unistd.h>
 #include <sys/wait.h>
 
 #include "fd.hpp"
 #include "Paths.hpp"
+#include "Dependencies.hpp"
+#include "ShellCache.hpp"
+#include "Stats.hpp"
 #include "Debug.hpp"
 
 using namespace std;
@@ -24,8 +29,8 @@ struct str_chunks {
 
 struct ShellCmd {
 	string_view cmd;
-	const VariableMap* vars = nullptr;
-	const vector<string_view>* env = nullptr;
+	const filepath* cwd = nullptr;							// Working directory, empty for the working directory of the process.
+	const vector<pair<const char*,string>>* env = nullptr;	// Environment variables of the child process.
 	str_chunks* capture = nullptr;
 };
 
@@ -90,17 +95,19 @@ constexpr string_view trim(string_view s) noexcept {
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
-// Called from child process
-static void _setEnv(const VariableMap& vars, const vector<string_view>& env){
+// Called before fork, since the child process of a multithreaded program must not take locks.
+static void _getEnv(const VariableMap& vars, const vector<string_view>& names, vector<pair<const char*,string>>& env){
 	char buff[96];
 	
-	for (string_view name : env){
-		const auto* keyval = vars.find(name);
-		if (keyval == nullptr){
+	for (string_view name : names){
+		const Symbol sym = Symbols::find(name);
+		const Value* var = vars.get(sym);
+		if (var == nullptr){
 			continue;
 		}
 		
-		const Value& val = keyval->value;
+		const char* key = Symbols::name(sym).data();
+		const Value& val = *var;
 		
 		switch (val.type){
 			case Value::Type::NONE: {
@@ -109,21 +116,20 @@ static void _setEnv(const VariableMap& vars, const vector<string_view>& env){
 			
 			case Value::Type::LONG: {
 				if (snprintf(buff, sizeof(buff), "%ld", val.data.l) >= 0)
-					setenv(keyval->key, buff, 1);
+					env.emplace_back(key, buff);
 				else
 					assert(false);
 			} break;
 			
 			case Value::Type::DOUBLE: {
 				if (snprintf(buff, sizeof(buff), "%lf", val.data.d) >= 0)
-					setenv(keyval->key, buff, 1);
+					env.emplace_back(key, buff);
 				else
 					assert(false);
 			} break;
 			
 			case Value::Type::STRING: {
-				assert(*val.data.s->end() == '\0');
-				setenv(keyval->key, val.data.s->str, 1);
+				env.emplace_back(key, val.c_str());
 			} break;
 			
 			case Value::Type::OBJECT: {
@@ -137,9 +143,74 @@ static void _setEnv(const VariableMap& vars, const vector<string_view>& env){
 }
 
 
+/**
+ * @brief Build environment of the child process: environment of this process with `vars` set.
+ * @param strs Receives `key=value` strings, which `envp` points to.
+ * @param envp Receives null terminated array for `execve()`.
+ */
+static void _buildEnv(const vector<pair<const char*,string>>* vars, vector<string>& strs, vector<char*>& envp){
+	auto isSet = [&](string_view entry){
+		const string_view name = entry.substr(0, entry.find('='));
+		if (vars != nullptr){
+			for (const auto& [key, val] : *vars)
+				if (name == key) return true;
+		}
+		return false;
+	};
+	
+	for (char** e = environ ; *e != nullptr ; e++){
+		if (!isSet(*e))
+			strs.emplace_back(*e);
+	}
+	
+	if (vars != nullptr){
+		for (const auto& [key, val] : *vars)
+			strs.emplace_back(string(key) + '=' + val);
+	}
+	
+	envp.reserve(strs.size() + 1);
+	for (string& str : strs){
+		envp.push_back(str.data());
+	}
+	
+	envp.push_back(nullptr);
+}
+
+
+/**
+ * @brief Find executable `name` in directories of `PATH` from environment `envp`, as `execvp()` would.
+ * @return Path of the executable, or `name` if it is not found.
+ */
+static string _findExecutable(string_view name, const vector<char*>& envp){
+	string_view path = "/usr/local/bin:/usr/bin:/bin";
+	for (const char* e : envp){
+		if (e != nullptr && string_view(e).starts_with("PATH=")){
+			path = string_view(e).substr(5);
+			break;
+		}
+	}
+	
+	while (true){
+		const size_t n = path.find(':');
+		const string_view dir = path.substr(0, n);
+		
+		string file = string(dir.empty() ? "." : dir) + '/' + string(name);
+		if (access(file.c_str(), X_OK) == 0){
+			return file;
+		} else if (n == string_view::npos){
+			break;
+		}
+		
+		path.remove_prefix(n + 1);
+	}
+	
+	return string(name);
+}
+
+
 static int _shell(const ShellCmd& cmd){
-	assert(Paths::cwd != nullptr);
-	assert(fs::is_dir(*Paths::cwd));
+	assert(cmd.cwd != nullptr);
+	assert(cmd.cwd->empty() || fs::is_dir(*cmd.cwd));
 	
 	if (cmd.cmd.empty()){
 		assert(!cmd.cmd.empty());
@@ -156,37 +227,39 @@ static int _shell(const ShellCmd& cmd){
 		return 100;
 	}
 	
+	// Everything the child needs is prepared before fork, since the child of a
+	// multithreaded process may only make async-signal-safe calls.
+	vector<string> envStrs;
+	vector<char*> envp;
+	_buildEnv(cmd.env, envStrs, envp);
+	
+	const string bash = _findExecutable("bash", envp);
+	char* const argv[] = { const_cast<char*>("bash"), nullptr };
+	
+	// Current directory, empty for files in the working directory of the process.
+	error_code err;
+	const string cwd = cmd.cwd->empty() ? string() : filesystem::absolute(*cmd.cwd, err).native();
+	
 	const pid_t pid = fork();
 	
 	// Child
 	if (pid == 0){
 		if (dup2(in0, 0) < 0){
-			exit(101);
+			_exit(101);
 		} else if (cmd.capture == nullptr){
 			close(1);
 			close(2);
 		} else if (dup2(out1, 1) < 0){
-			exit(101);
+			_exit(101);
 		}
 		
-		in0.close();
-		in1.close();
-		out0.close();
-		out1.close();
-		
-		// Set current directory
-		if (!fs::cwd(*Paths::cwd)){
-			exit(102);
+		if (!cwd.empty() && chdir(cwd.c_str()) != 0){
+			_exit(102);
 		}
 		
-		// Set environment variables
-		if (cmd.env != nullptr && cmd.vars != nullptr){
-			_setEnv(*cmd.vars, *cmd.env);
-		}
-		
-		// Input comes on stdin
-		execlp("bash", "bash", NULL);
-		exit(1);
+		// Input comes on stdin, pipes are closed on exec.
+		execve(bash.c_str(), argv, envp.data());
+		_exit(1);
 	}
 	
 	// Parent
@@ -240,6 +313,56 @@ static int _shell(const ShellCmd& cmd){
 }
 
 
+/**
+ * @brief Run command and collect its output.
+ * @param output Receives output of the command, `nullptr` to discard it.
+ * @return Exit status of the command, `-1` if it failed to start.
+ */
+static int _run(string_view cmdtxt, const filepath& cwd, const vector<pair<const char*,string>>& env, string* output){
+	str_chunks result;
+	ShellCmd cmd = {
+		.cmd = cmdtxt,
+		.cwd = &cwd,
+		.env = &env,
+		.capture = (output != nullptr) ? &result : nullptr
+	};
+	
+	int status;
+	try {
+		status = _shell(cmd);
+	} catch (...){
+		return -1;
+	}
+	
+	if (output != nullptr){
+		output->resize(result.total);
+		output->resize(concat(result.chunks, output->data(), output->size()));
+	}
+	
+	return status;
+}
+
+
+/**
+ * @brief Set value of a text node to the output, without its last newline.
+ */
+static void _text(Document& doc, Node& txt, string_view output){
+	size_t n = output.size();
+	
+	// Trim last newline
+	if (n > 0 && output[n-1] == '\n'){
+		n--;
+	}
+	
+	char* s = doc.charAlloc->alloc(n + 1);
+	memcpy(s, output.data(), n);
+	s[n] = 0;
+	
+	txt.value_len = n;
+	txt.value_p = s;
+}
+
+
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
@@ -270,6 +393,47 @@ static void _extractVars(string_view csv, vector<string_view>& vars){
 }
 
 
+/**
+ * @brief Get lifetime of output from the `CACHE` attribute.
+ * @return Number of seconds, or `0` for `BUILD` and no value, which keep the output for the current build.
+ */
+static long _cacheSeconds(const Macro& macro, const Attr& attr){
+	const string_view val = attr.value();
+	if (val.empty() || val == "BUILD"){
+		return 0;
+	}
+	
+	long n = 0;
+	auto res = from_chars(val.begin(), val.end(), n);
+	if (res.ec != errc() || res.ptr != val.end() || n <= 0){
+		HERE(warn_ignored_attr_value(macro, attr));
+		return 0;
+	}
+	
+	return n;
+}
+
+
+/**
+ * @brief Key of cached output: command, environment variables, working directory and whether the output is captured.
+ */
+static string _cacheKey(string_view cmd, const vector<pair<const char*,string>>& env, bool capture){
+	string key = string(cmd);
+	key += '\0';
+	
+	for (const auto& [name, val] : env){
+		key.append(name) += '=';
+		key.append(val) += '\0';
+	}
+	
+	error_code err;
+	key += '\0';
+	key += Paths::cwd->empty() ? fs::cwd().native() : filesystem::absolute(*Paths::cwd, err).native();
+	key += capture ? "\0TEXT" : "\0VOID";
+	return key;
+}
+
+
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
@@ -299,14 +463,16 @@ void MacroEngine::shell(const Node& op, Node& dst){
 	
 	vector<string_view> vars = {};
 	string_view captureVar = {};
+	long cacheSeconds = -1;		// Lifetime of cached output, see `_cacheSeconds()`. Negative if not cached.
 	
 	for (const Attr* attr = op.attribute ; attr != nullptr ; attr = attr->next){
-		string_view name = attr->name();
-		
-		if (name == "VARS"){
+		if (opcode(*attr) == Opcode::VARS){
 			_extractVars(attr->value(), vars);
 			continue;
-		} else if (name == "STDOUT"){
+		} else if (opcode(*attr) == Opcode::CACHE){
+			cacheSeconds = _cacheSeconds(*macro, *attr);
+			continue;
+		} else if (opcode(*attr) == Opcode::STDOUT){
 			string_view val = attr->value();
 			
 			if (val == "" || val == "VOID"){
@@ -331,60 +497,123 @@ void MacroEngine::shell(const Node& op, Node& dst){
 		HERE(warn_ignored_attr(*macro, *attr));
 	}
 	
+	if (Dependencies* deps = Dependencies::recording()){
+		deps->addCommand(cmdtxt);
+	}
+	
 	// Run command
-	str_chunks result;
-	ShellCmd cmd = {
-		.cmd = cmdtxt,
-		.vars = variables.get(),
-		.env = &vars,
-		.capture = (capture != Capture::VOID) ? &result : nullptr
-	};
+	vector<pair<const char*,string>> env;
+	_getEnv(*variables, vars, env);
 	
-	try {
-		int status = _shell(cmd);
+	string output;
+	string key;
+	const Shell* same = nullptr;	// Identical command started earlier, its output is not cached until `join()`.
+	
+	if (cacheSeconds >= 0){
+		key = _cacheKey(cmdtxt, env, capture != Capture::VOID);
+		
+		if (shells != nullptr){
+			auto p = shells->cached.find(key);
+			if (p != shells->cached.end())
+				same = p->second;
+		}
+		
+		if (same == nullptr && ShellCache::find(key, cacheSeconds, output))
+			goto apply;
+	}
+	
+	// Output inserted as text doesn't affect evaluation, so the command runs while evaluation continues.
+	// Streamed nodes may be written at any time, so their commands complete immediately.
+	if (capture == Capture::TEXT && stream == nullptr && shells != nullptr){
+		wait(Shells::MAX_RUNNING - 1);
+		
+		Node& txt = *dst.appendChild(newNode(NodeType::TEXT));
+		txt.options = op.options & (NodeOptions::SPACE_BEFORE | NodeOptions::SPACE_AFTER);
+		
+		Shell& sh = *shells->list.emplace_back(make_unique<Shell>());
+		sh.macro = macro;
+		sh.op = &op;
+		sh.node = &txt;
+		sh.cmd = cmdtxt;
+		sh.cwd = Paths::cwd;
+		
+		// Reuse output of the identical command once it exits.
+		if (same != nullptr){
+			sh.same = same;
+			Stats::shell.hits++;
+			return;
+		}
+		
+		sh.env = move(env);
+		sh.key = move(key);
+		sh.cacheSeconds = cacheSeconds;
+		
+		if (!sh.key.empty()){
+			shells->cached.emplace(sh.key, &sh);
+		}
+		
+		auto run = [&sh](){
+			sh.status = _run(sh.cmd, *sh.cwd, sh.env, &sh.output);
+		};
+		
+		try {
+			sh.thread = thread(run);
+		} catch (const system_error&){
+			run();
+		}
+		
+		return;
+	}
+	
+	// Commands with other effects run after previous commands, in order of the document.
+	wait();
+	
+	if (same != nullptr){
+		if (same->status == 0){
+			output = same->output;
+			Stats::shell.hits++;
+			goto apply;
+		}
+		Stats::shell.misses++;
+	}
+	
+	{
+		const int status = _run(cmdtxt, *Paths::cwd, env, (capture != Capture::VOID) ? &output : nullptr);
 		if (status != 0){
 			HERE(warn_shell_exit(*macro, op, status));
 			return;
 		}
-	} catch (...){
-		HERE(warn_shell_exit(*macro, op, -1));
-		return;
+		
+		if (cacheSeconds >= 0){
+			ShellCache::store(key, cacheSeconds, output);
+		}
+	
 	}
 	
 	// Apply result
+	apply:
 	switch (capture){
 		case Capture::VOID:
 			break;
 		
 		case Capture::TEXT: {
-			if (result.total > 0){
-				char* s = newStr(result.total + 1);
-				size_t n = concat(result.chunks, s, result.total);
-				s[n] = 0;
-				
-				// Trim last newline
-				if (n > 0 && s[n-1] == '\n'){
-					s[--n] = 0;
-				}
-				
+			if (!output.empty()){
 				Node& txt = *dst.appendChild(newNode(NodeType::TEXT));
 				txt.options = op.options & (NodeOptions::SPACE_BEFORE | NodeOptions::SPACE_AFTER);
-				txt.value_len = n;
-				txt.value_p = s;
+				_text(document(), txt, output);
 			}
 		} break;
 		
 		case Capture::VAR: {
-			uint32_t len = uint32_t(min(result.total, size_t(UINT32_MAX)));
-			
-			unique_ptr<Value::String> s = Value::String::create(len);
-			len = uint32_t(concat(result.chunks, s->str, s->len));
+			uint32_t len = uint32_t(min(output.size(), size_t(UINT32_MAX)));
 			
 			// Trim last newline
-			if (len > 0 && s->str[len-1] == '\n'){
+			if (len > 0 && output[len-1] == '\n'){
 				len--;
 			}
 			
+			unique_ptr<Value::String> s = Value::String::create(len);
+			memcpy(s->str, output.data(), len);
 			s->len = len;
 			s->str[s->len] = 0;
 			
@@ -396,4 +625,74 @@ void MacroEngine::shell(const Node& op, Node& dst){
 }
 
 
+void MacroEngine::wait(size_t running){
+	if (shells == nullptr){
+		return;
+	}
+	
+	// Oldest commands are awaited first.
+	while (shells->list.size() - shells->done > running){
+		Shell& sh = *shells->list[shells->done++];
+		if (sh.thread.joinable())
+			sh.thread.join();
+	}
+
+}
+
+
+void MacroEngine::join(){
+	assert(shells != nullptr);
+	wait();
+	
+	for (unique_ptr<Shell>& p : shells->list){
+		Shell& sh = *p;
+		assert(sh.macro != nullptr);
+		
+		if (sh.same != nullptr){
+			sh.status = sh.same->status;
+			sh.output = sh.same->output;
+		}
+		
+		if (sh.status != 0){
+			HERE(warn_shell_exit(*sh.macro, *sh.op, sh.status));
+		} else if (sh.cacheSeconds >= 0){
+			ShellCache::store(sh.key, sh.cacheSeconds, sh.output);
+		}
+		
+		if (sh.node == nullptr){
+			continue;
+		} else if (sh.status != 0 || sh.output.empty()){
+			sh.node->remove(document());
+		} else {
+			_text(document(), *sh.node, sh.output);
+		}
+	
+	}
+	
+	shells->list.clear();
+	shells->cached.clear();
+	shells->done = 0;
+}
+
+
+void MacroEngine::detach(const Node& node){
+	if (shells == nullptr){
+		return;
+	}
+	
+	for (unique_ptr<Shell>& sh : shells->list){
+		const Node* p = sh->node;
+		while (p != nullptr && p != &node){
+			p = p->parent;
+		}
+		
+		if (p != nullptr){
+			sh->node = nullptr;
+		}
+	
+	}
+
+}
+
+
 // ------------------------------------------------------------------------------------------ //
\ No newline at end of file
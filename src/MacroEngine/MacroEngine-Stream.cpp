@@ -0,0 +1,166 @@
+#include "MacroEngine.hpp"
+#include "output/Write.hpp"
+#include "Debug.hpp"
+
+using namespace std;
+using namespace html;
+
+using Stream = MacroEngine::Stream;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+/**
+ * @brief Write completed children of an open element and free them.
+ *        Only the last child remains, since it may still be under construction.
+ */
+static void write(Stream& stream, Node& parent){
+	assert(stream.writer.isOpen(parent));
+	
+	// First new child of an unfinished `<IF>` or `<INCLUDE>` may be written now,
+	// so its leading whitespace is transferred early.
+	for (MacroEngine::ParentSpace& space : stream.spaces){
+		if (space.dst != &parent || space.before || parent.child == space.last){
+			continue;
+		}
+		
+		for (Node* child = parent.child ; child != nullptr ; child = child->next){
+			if (child->next == space.last){
+				child->options |= (space.op->options & NodeOptions::SPACE_BEFORE);
+				break;
+			}
+		}
+		
+		space.before = true;
+	}
+	
+	stream.writer.write(parent);
+	
+	// Free written nodes
+	Node* last = parent.child;
+	if (last != nullptr && last->next != nullptr){
+		Node written;
+		written.child = last->next;
+		last->next = nullptr;
+		written.removeChildren(stream.doc);
+	}
+
+}
+
+
+/**
+ * @brief Check if evaluating children of `op` may change name or attributes of their parent.
+ *        Bodies of user macros called by name are checked as well.
+ *        Other calls and includes are not, such changes are reported when they are evaluated.
+ * @param depth Nesting of checked macro bodies.
+ */
+static bool changesParent(const Node& op, int depth = 0){
+	using Opcode = MacroEngine::Opcode;
+	
+	for (const Node* child = op.child ; child != nullptr ; child = child->next){
+		if (child->type != NodeType::TAG){
+			continue;
+		}
+		
+		switch (MacroEngine::opcode(*child)){
+			case Opcode::SET_TAG:
+			case Opcode::SET_ATTR:
+			case Opcode::DEL_ATTR:
+				return true;
+			
+			case Opcode::IF:
+			case Opcode::ELIF:
+			case Opcode::ELSE:
+			case Opcode::FOR:
+			case Opcode::WHILE:
+				if (changesParent(*child, depth))
+					return true;
+				break;
+			
+			case Opcode::USER: {
+				if (depth >= 8)
+					return true;
+				
+				const shared_ptr<Macro>* target = MacroCache::find(child->name());
+				if (target != nullptr && (*target)->html != nullptr && changesParent(*(*target)->html, depth + 1))
+					return true;
+			} break;
+			
+			default:
+				break;
+		}
+	
+	}
+	
+	return false;
+}
+
+
+/**
+ * @brief Write start tag of `node` and all preceding nodes, unless they are already written.
+ * @return `false` if `node` is not an element under construction in the streamed document,
+ *         or its start tag can't be written yet.
+ */
+static bool open(Stream& stream, Node& node){
+	if (stream.writer.isOpen(node)){
+		return true;
+	}
+	
+	// Element under construction is the last child of its parent.
+	Node* parent = node.parent;
+	if (parent == nullptr || parent->child != &node){
+		return false;
+	}
+	
+	auto it = stream.elements.rbegin();
+	while (it != stream.elements.rend() && it->node != &node){
+		it++;
+	}
+	
+	if (it == stream.elements.rend() || changesParent(*it->op)){
+		return false;
+	} else if (!open(stream, *parent)){
+		return false;
+	}
+	
+	write(stream, *parent);
+	return stream.writer.open(node);
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+void MacroEngine::flush(Node& dst){
+	assert(stream != nullptr);
+	
+	if (stream->created < Stream::FLUSH_NODES){
+		return;
+	}
+	
+	stream->created = 0;
+	
+	for (Node* node = &dst ; node != nullptr ; node = node->parent){
+		if (open(*stream, *node)){
+			write(*stream, *node);
+			return;
+		}
+	}
+
+}
+
+
+void MacroEngine::exec(const shared_ptr<Macro>& macro, Document& doc, HtmlWriter& writer){
+	Stream s = {doc, writer};
+	
+	Stream* const _stream = this->stream;
+	this->stream = &s;
+	exec(macro, doc);
+	this->stream = _stream;
+	
+	assert(s.spaces.empty());
+}
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -1,4 +1,5 @@
 #include "MacroEngine.hpp"
+#include "output/Write.hpp"
 #include "Debug.hpp"
 
 using namespace std;
@@ -13,6 +14,59 @@ constexpr bool isMacroChar(char c){
 }
 
 
+/**
+ * @brief Check if start tag of `node` was already written while streaming, so its name and attributes are final.
+ */
+static bool isWritten(const MacroEngine& self, const Node& node){
+	return self.stream != nullptr && &node != &self.stream->doc && self.stream->writer.isOpen(node);
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+MacroEngine::Opcode MacroEngine::resolve(const Attr& attr) noexcept {
+	string_view name = attr.name();
+	if (name.empty()){
+		return Opcode::NONE;
+	} else if (!isMacroChar(name[0])){
+		return Opcode::REGULAR;
+	} else if (name.starts_with("INCLUDE")){
+		return Opcode::INCLUDE;
+	}
+	
+	switch (name.length()){
+		case 2:
+			if (name == "IF") return Opcode::IF;
+			break;
+		case 3:
+			if (name == "SRC") return Opcode::SRC;
+			break;
+		case 4:
+			if (name == "CALL") return Opcode::CALL;
+			if (name == "ELIF") return Opcode::ELIF;
+			if (name == "ELSE") return Opcode::ELSE;
+			if (name == "NAME") return Opcode::NAME;
+			if (name == "TRUE") return Opcode::TRUE;
+			if (name == "VARS") return Opcode::VARS;
+			break;
+		case 5:
+			if (name == "FALSE") return Opcode::FALSE;
+			if (name == "CACHE") return Opcode::CACHE;
+			break;
+		case 6:
+			if (name == "HEADER") return Opcode::HEADER;
+			if (name == "STDOUT") return Opcode::STDOUT;
+			break;
+		case 7:
+			if (name == "NO-WRAP") return Opcode::NO_WRAP;
+			break;
+	}
+	
+	return Opcode::USER;
+}
+
+
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
@@ -36,6 +90,20 @@ void MacroEngine::text(const Node& src, Node& dst){
 }
 
 
+void MacroEngine::borrow(const Node& src, Node& dst){
+	assert(src.options % NodeOptions::STATIC);
+	
+	Node& node = *dst.appendChild(newNode(NodeType::BORROWED));
+	node.borrowed = &src;
+	
+	// Same options as a copy, whitespace may be added by the parent macro.
+	if (src.type == NodeType::TAG){
+		node.options = src.options & (NodeOptions::SELF_CLOSE | NodeOptions::SPACE_AFTER | NodeOptions::SPACE_BEFORE);
+	}
+	
+}
+
+
 Attr* MacroEngine::attribute(const Node& op, const Attr& op_attr){
 	assert(macro != nullptr);
 	
@@ -73,32 +141,34 @@ void MacroEngine::tag(const Node& op, Node& dst){
 	
 	// Copy attributes
 	for (const Attr* attr = op.attribute ; attr != nullptr ; attr = attr->next){
-		string_view name = attr->name();
-		assert(!name.empty());
-		
-		// Check regular attribute
-		if (!isMacroChar(name[0])){ regular_attr:
-			node.appendAttribute(attribute(op, *attr));
-			continue;
-		}
+		assert(!attr->name().empty());
 		
-		else if (name == "CALL"){
-			call(op, *attr, node);
-			continue;
-		}
-		
-		else if (name.starts_with("INCLUDE")){
-			include(op, *attr, node);
-			continue;
-		}
-		
-		// Check IF, ELIF, ELSE
-		switch (try_eval_attr_if_elif_else(op, *attr)){
-			case Branch::FAILED:
-				node.remove(*macro->html);
-				return;
-			case Branch::PASSED: continue;
-			case Branch::NONE: break;
+		switch (opcode(*attr)){
+			case Opcode::REGULAR: regular_attr:
+				node.appendAttribute(attribute(op, *attr));
+				continue;
+			
+			case Opcode::CALL:
+				call(op, *attr, node);
+				continue;
+			
+			case Opcode::INCLUDE:
+				include(op, *attr, node);
+				continue;
+			
+			// Check IF, ELIF, ELSE
+			case Opcode::IF:
+			case Opcode::ELIF:
+			case Opcode::ELSE:
+				if (try_eval_attr_if_elif_else(op, *attr) == Branch::FAILED){
+					detach(node);
+					node.remove(document());
+					return;
+				}
+				continue;
+			
+			default:
+				break;
 		}
 		
 		// User macro
@@ -114,7 +184,14 @@ void MacroEngine::tag(const Node& op, Node& dst){
 	dst.appendChild(&node);
 	
 	// Evaluate child elements
-	evalChildren(op, node);
+	if (stream != nullptr){
+		stream->elements.push_back(Element{&node, &op});
+		evalChildren(op, node);
+		stream->elements.pop_back();
+	} else {
+		evalChildren(op, node);
+	}
+
 }
 
 
@@ -130,6 +207,11 @@ void MacroEngine::setAttr(const Node& op, Node& dst){
 		HERE(warn_ignored_child(*macro, op));
 	}
 	
+	if (isWritten(*this, dst)){
+		HERE(warn_element_written(*macro, op, dst));
+		return;
+	}
+	
 	string buff;
 	string_view newValue;
 	
@@ -162,13 +244,13 @@ void MacroEngine::setAttr(const Node& op, Node& dst){
 		if (op_attr->options % (NodeOptions::SINGLE_QUOTE | NodeOptions::INTERPOLATE)){
 			buff.clear();
 			if (eval_attr_value(op, *op_attr, buff, newValue)){
-				dst_attr->value(*macro->html, newStr(newValue), newValue.length());
+				dst_attr->value(document(), newStr(newValue), newValue.length());
 				continue;
 			}
 		}
 		
 		// Value as external string
-		dst_attr->value(*macro->html, op_attr->value());
+		dst_attr->value(document(), op_attr->value());
 		continue;
 	}
 	
@@ -228,6 +310,11 @@ void MacroEngine::delAttr(const Node& op, Node& dst){
 		HERE(warn_ignored_child(*macro, op));
 	}
 	
+	if (isWritten(*this, dst)){
+		HERE(warn_element_written(*macro, op, dst));
+		return;
+	}
+	
 	for (const Attr* attr = op.attribute ; attr != nullptr ; attr = attr->next){
 		// Check IF, ELIF, ELSE
 		switch (try_eval_attr_if_elif_else(op, *attr)){
@@ -240,7 +327,7 @@ void MacroEngine::delAttr(const Node& op, Node& dst){
 			HERE(warn_ignored_attr_value(*macro, *attr));
 		}
 		
-		dst.removeAttr(*macro->html, attr->name());
+		dst.removeAttr(document(), attr->name());
 	}
 	
 }
@@ -254,11 +341,14 @@ void MacroEngine::setTag(const Node& op, Node& dst){
 		HERE(warn_ignored_child(*macro, op));
 	}
 	
+	if (isWritten(*this, dst)){
+		HERE(warn_element_written(*macro, op, dst));
+		return;
+	}
+	
 	const Attr* name_attr = nullptr;
 	
 	for (const Attr* attr = op.attribute ; attr != nullptr ; attr = attr->next){
-		string_view name = attr->name();
-		
 		// Check IF, ELIF, ELSE
 		switch (try_eval_attr_if_elif_else(op, *attr)){
 			case Branch::FAILED: return;
@@ -267,7 +357,7 @@ void MacroEngine::setTag(const Node& op, Node& dst){
 		}
 		
 		// New tag name retrieved from attribute value
-		if (name == "NAME"){
+		if (opcode(*attr) == Opcode::NAME){
 			if (attr->value_len <= 0){
 				HERE(error_missing_attr_value(*macro, *attr));
 				continue;
@@ -290,7 +380,7 @@ void MacroEngine::setTag(const Node& op, Node& dst){
 	
 	// New tag name retrieved from attribute name
 	else if (name_attr->value_len <= 0){
-		dst.name(*macro->html, name_attr->name());
+		dst.name(document(), name_attr->name());
 		return;
 	}
 	
@@ -299,13 +389,13 @@ void MacroEngine::setTag(const Node& op, Node& dst){
 		string buff;
 		string_view view;
 		if (eval_attr_value(op, *name_attr, buff, view)){
-			dst.name(*macro->html, newStr(view), view.length());
+			dst.name(document(), newStr(view), view.length());
 		}
 		return;	// Don't assign name to failed expression, tag name characters remain valid.
 	}
 	
 	// Name is an extern string
-	dst.name(*macro->html, name_attr->value());
+	dst.name(document(), name_attr->value());
 }
 
 
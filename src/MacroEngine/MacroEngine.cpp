@@ -1,4 +1,5 @@
 #include "MacroEngine.hpp"
+#include "ExpressionCache.hpp"
 #include "Debug.hpp"
 
 using namespace std;
@@ -20,34 +21,169 @@ constexpr bool isMacroChar(char c){
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
+Document& MacroEngine::document(){
+	assert(output != nullptr);
+	return *output;
+}
+
 Node* MacroEngine::newNode(NodeType type){
-	assert(macro != nullptr);
-	assert(macro->html != nullptr);
-	assert(macro->html->nodeAlloc != nullptr);
-	Node* node = macro->html->nodeAlloc->create();
+	Document& doc = document();
+	assert(doc.nodeAlloc != nullptr);
+	Node* node = doc.nodeAlloc->create();
 	node->type = type;
+	
+	if (stream != nullptr){
+		stream->created++;
+	}
+	
 	return node;
 }
 
 Attr* MacroEngine::newAttr(){
-	assert(macro != nullptr);
-	assert(macro->html != nullptr);
-	assert(macro->html->attrAlloc != nullptr);
-	return macro->html->attrAlloc->create();
+	Document& doc = document();
+	assert(doc.attrAlloc != nullptr);
+	return doc.attrAlloc->create();
 }
 
 char* MacroEngine::newStr(size_t len){
-	assert(macro != nullptr);
-	assert(macro->html != nullptr);
-	assert(macro->html->charAlloc != nullptr);
-	return macro->html->charAlloc->alloc(len);
+	Document& doc = document();
+	assert(doc.charAlloc != nullptr);
+	return doc.charAlloc->alloc(len);
 }
 
 char* MacroEngine::newStr(string_view str){
+	Document& doc = document();
+	assert(doc.charAlloc != nullptr);
+	return doc.charAlloc->create(str);
+}
+
+const Expression& MacroEngine::expression(string_view str){
 	assert(macro != nullptr);
-	assert(macro->html != nullptr);
-	assert(macro->html->charAlloc != nullptr);
-	return macro->html->charAlloc->create(str);
+	if (macro->expressions == nullptr){
+		macro->expressions = make_unique<ExpressionCache>(macro.get());
+	}
+	return macro->expressions->expression(str);
+}
+
+const Interpolation& MacroEngine::interpolation(string_view str){
+	assert(macro != nullptr);
+	if (macro->expressions == nullptr){
+		macro->expressions = make_unique<ExpressionCache>(macro.get());
+	}
+	return macro->expressions->interpolation(str);
+}
+
+Symbol MacroEngine::symbol(Macro& macro, string_view name){
+	if (macro.expressions == nullptr){
+		macro.expressions = make_unique<ExpressionCache>(&macro);
+	}
+	return macro.expressions->symbol(name);
+}
+
+const shared_ptr<Macro>* MacroEngine::userMacro(string_view name){
+	assert(macro != nullptr);
+	if (macro->expressions == nullptr){
+		macro->expressions = make_unique<ExpressionCache>(macro.get());
+	}
+	return macro->expressions->macro(name);
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+MacroEngine::Opcode MacroEngine::resolve(const Node& op) noexcept {
+	if (op.type != NodeType::TAG){
+		return Opcode::NONE;
+	}
+	
+	string_view name = op.name();
+	if (name.empty()){
+		return Opcode::NONE;
+	} else if (!isMacroChar(name[0])){
+		return Opcode::REGULAR;
+	}
+	
+	switch (name.length()){
+		case 2:
+			if (name == "IF") return Opcode::IF;
+			break;
+		case 3:
+			if (name == "SET") return Opcode::SET;
+			if (name == "FOR") return Opcode::FOR;
+			break;
+		case 4:
+			if (name == "CALL") return Opcode::CALL;
+			if (name == "ELIF") return Opcode::ELIF;
+			if (name == "ELSE") return Opcode::ELSE;
+			if (name == "INFO") return Opcode::INFO;
+			if (name == "WARN") return Opcode::WARN;
+			break;
+		case 5:
+			if (name == "SHELL") return Opcode::SHELL;
+			if (name == "WHILE") return Opcode::WHILE;
+			if (name == "ERROR") return Opcode::ERROR;
+			break;
+		case 7:
+			if (name == "INCLUDE") return Opcode::INCLUDE;
+			if (name == "GET-TAG") return Opcode::GET_TAG;
+			if (name == "SET-TAG") return Opcode::SET_TAG;
+			break;
+		case 8:
+			if (name == "SET-ATTR") return Opcode::SET_ATTR;
+			if (name == "GET-ATTR") return Opcode::GET_ATTR;
+			if (name == "DEL-ATTR") return Opcode::DEL_ATTR;
+			break;
+	}
+	
+	return Opcode::USER;
+}
+
+
+/**
+ * @brief Resolve opcodes of `node` and its subtree, and mark static subtrees.
+ * @return `true` if `node` and its subtree contain no macros or interpolation.
+ */
+static bool compileNode(Node& node) noexcept {
+	using Opcode = MacroEngine::Opcode;
+	bool isStatic = false;
+	
+	switch (node.type){
+		case NodeType::TAG: {
+			node.op = uint8_t(MacroEngine::resolve(node));
+			isStatic = (Opcode(node.op) == Opcode::REGULAR);
+			
+			for (Attr* attr = node.attribute ; attr != nullptr ; attr = attr->next){
+				attr->op = uint8_t(MacroEngine::resolve(*attr));
+				isStatic &= (Opcode(attr->op) == Opcode::REGULAR);
+				isStatic &= !(attr->options % (NodeOptions::SINGLE_QUOTE | NodeOptions::INTERPOLATE));
+			}
+		} break;
+		
+		case NodeType::TEXT:
+		case NodeType::COMMENT:
+			isStatic = !(node.options % NodeOptions::INTERPOLATE);
+			break;
+		
+		// Copied directives don't keep whitespace options.
+		default:
+			break;
+	}
+	
+	for (Node* child = node.child ; child != nullptr ; child = child->next){
+		isStatic &= compileNode(*child);
+	}
+	
+	if (isStatic){
+		node.options |= NodeOptions::STATIC;
+	}
+	
+	return isStatic;
+}
+
+
+void MacroEngine::compile(Node& root) noexcept {
+	compileNode(root);
 }
 
 
@@ -55,9 +191,14 @@ char* MacroEngine::newStr(string_view str){
 
 
 void MacroEngine::eval(const Node& op, Node& dst){
+	if (op.options % NodeOptions::STATIC){
+		borrow(op, dst);
+		return;
+	}
+	
 	switch (op.type){
 		case NodeType::TAG:
-			goto tag;
+			break;
 		
 		case NodeType::ROOT:
 			evalChildren(op, dst);
@@ -74,102 +215,45 @@ void MacroEngine::eval(const Node& op, Node& dst){
 			return;
 	}
 	
-	tag:
-	string_view name = op.name();
-	if (name.empty()){
-		assert(!name.empty());
-		return;
-	}
-	
-	// Regular tag
-	else if (!isMacroChar(name[0])){
-		regular_tag:
-		tag(op, dst);
-		return;
-	}
-	
-	// Macro tag
-	switch (name.length()){
-		case 2: {
-			if (name == "IF")
-				branch_if(op, dst);
-			else
-				goto user_macro;
-		} break;
-		
-		case 3: {
-			if (name == "SET")
-				set(op);
-			else if (name == "FOR")
-				loop_for(op, dst);
-			else
-				goto user_macro;
-		} break;
-			
-		case 4: {
-			if (name == "CALL")
-				call(op, dst);
-			else if (name == "ELIF")
-				branch_elif(op, dst);
-			else if (name == "ELSE")
-				branch_else(op, dst);
-			else if (name == "INFO")
-				info(op);
-			else if (name == "WARN")
-				warn(op);
-			else
-				goto user_macro;
-		} break;
-		
-		case 5: {
-			if (name == "SHELL")
-				shell(op, dst);
-			else if (name == "WHILE")
-				loop_while(op, dst);
-			else if (name == "ERROR")
-				error(op);
-			else
-				goto user_macro;
-		} break;
-		
-		case 7: {
-			if (name == "INCLUDE")
-				include(op, dst);
-			else if (name == "GET-TAG")
-				getTag(op, dst);
-			else if (name == "SET-TAG")
-				setTag(op, dst);
-			else
-				goto user_macro;
-		} break;
+	switch (opcode(op)){
+		case Opcode::REGULAR:
+			tag(op, dst);
+			return;
 		
-		case 8: {
-			if (name == "SET-ATTR")
-				setAttr(op, dst);
-			else if (name == "GET-ATTR")
-				getAttr(op, dst);
-			else if (name == "DEL-ATTR")
-				delAttr(op, dst);
-			else
-				goto user_macro;
-		} break;
+		case Opcode::IF:		branch_if(op, dst);		return;
+		case Opcode::ELIF:		branch_elif(op, dst);	return;
+		case Opcode::ELSE:		branch_else(op, dst);	return;
+		case Opcode::SET:		set(op);				return;
+		case Opcode::FOR:		loop_for(op, dst);		return;
+		case Opcode::WHILE:		loop_while(op, dst);	return;
+		case Opcode::CALL:		call(op, dst);			return;
+		case Opcode::INCLUDE:	include(op, dst);		return;
+		case Opcode::SHELL:		shell(op, dst);			return;
+		case Opcode::INFO:		info(op);				return;
+		case Opcode::WARN:		warn(op);				return;
+		case Opcode::ERROR:		error(op);				return;
+		case Opcode::GET_TAG:	getTag(op, dst);		return;
+		case Opcode::SET_TAG:	setTag(op, dst);		return;
+		case Opcode::SET_ATTR:	setAttr(op, dst);		return;
+		case Opcode::GET_ATTR:	getAttr(op, dst);		return;
+		case Opcode::DEL_ATTR:	delAttr(op, dst);		return;
 		
-		default: {
-			goto user_macro;
-		} break;
+		case Opcode::NONE:
+			assert(!op.name().empty());
+			return;
 		
+		// User macro
+		default:
+			if (const shared_ptr<Macro>* target = userMacro(op.name())){
+				call_userElementMacro(op, *target, dst);
+				return;
+			}
+			
+			warn_unknown_element_macro(*macro, op);
+			tag(op, dst);
+			return;
 	}
 	
-	return;
-	
-	user_macro:
-	if (MacroCache::get(op.name()) != nullptr){
-		call_userElementMacro(op, dst);
-		return;
-	}
-	
-	warn_unknown_element_macro(*macro, op);
-	goto regular_tag;
 }
 
 
@@ -181,6 +265,8 @@ void MacroEngine::evalChildren(const Node& parent, Node& dst){
 	
 	for (const Node* child = parent.child ; child != nullptr ; child = child->next){
 		eval(*child, dst);
+		if (stream != nullptr)
+			flush(dst);
 	}
 	
 	MacroEngine::currentBranch_block = _branch_1;
@@ -197,6 +283,12 @@ void MacroEngine::exec(const shared_ptr<Macro>& macro, Node& dst){
 	MacroEngine engine = MacroEngine();
 	engine.variables = shared_ptr(this->variables);
 	engine.macro = shared_ptr(macro);
+	engine.stream = this->stream;
+	engine.output = this->output;
+	
+	// Shell commands of the whole document run until its evaluation completes.
+	Shells shells;
+	engine.shells = (this->shells != nullptr) ? this->shells : &shells;
 	
 	// Backup cwd
 	auto _cwd = Paths::cwd;
@@ -206,9 +298,21 @@ void MacroEngine::exec(const shared_ptr<Macro>& macro, Node& dst){
 	
 	engine.evalChildren(*macro->html, dst);
 	
+	if (engine.shells == &shells){
+		engine.join();
+	}
+	
 	// Resotre cwd
 	Paths::cwd = move(_cwd);
 }
 
 
+void MacroEngine::exec(const shared_ptr<Macro>& macro, Document& doc){
+	Document* const _output = this->output;
+	this->output = &doc;
+	exec(macro, static_cast<Node&>(doc));
+	this->output = _output;
+}
+
+
 // ------------------------------------------------------------------------------------------ //
\ No newline at end of file
@@ -1,7 +1,15 @@
 #pragma once
 #include "Macro.hpp"
 #include "Expression.hpp"
+#include "Interpolation.hpp"
 #include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+class HtmlWriter;
 
 
 class MacroEngine {
@@ -13,12 +21,99 @@ public:
 		FAILED
 	};
 	
+	/**
+	 * @brief Meaning of a macro source node or attribute, resolved once from its name.
+	 *        Stored in `html::Node::op` and `html::Attr::op` by `compile()`.
+	 */
+	enum class Opcode : uint8_t {
+		NONE,			// Unresolved or invalid.
+		REGULAR,		// Regular HTML tag or attribute.
+		USER,			// User macro, looked up by name during evaluation.
+		
+		IF, ELIF, ELSE,
+		SET, FOR, WHILE,
+		CALL, INCLUDE, SHELL,
+		INFO, WARN, ERROR,
+		SET_TAG, GET_TAG,
+		SET_ATTR, GET_ATTR, DEL_ATTR,
+		
+		// Attribute parameters of macros
+		NAME, SRC, HEADER, NO_WRAP,
+		TRUE, FALSE,
+		VARS, STDOUT, CACHE,
+	};
+	
+	/**
+	 * @brief Whitespace of `op` to be transferred to the children it adds to `dst`, see `transfer_parent_space()`.
+	 */
+	struct ParentSpace {
+		const html::Node* op;
+		html::Node* dst;
+		const html::Node* last;		// Last child of `dst` before `op` was evaluated.
+		bool before;				// Leading whitespace was transferred early, since the first new child was written.
+	};
+	
+	/**
+	 * @brief Output element whose children are being evaluated.
+	 */
+	struct Element {
+		html::Node* node;
+		const html::Node* op;		// Source node which created `node`.
+	};
+	
+	/**
+	 * @brief Output which is written during evaluation and then freed.
+	 */
+	struct Stream {
+		static constexpr size_t FLUSH_NODES = 1024;	// Nodes created between writes.
+		
+		html::Document& doc;					// Root of the output, allocates all created nodes.
+		HtmlWriter& writer;						// Writer of `doc`.
+		std::vector<ParentSpace> spaces = {};	// Evaluations which have not transferred their whitespace yet.
+		std::vector<Element> elements = {};		// Elements under construction, outermost first.
+		size_t created = 0;						// Nodes created since the last write.
+	};
+
+	/**
+	 * @brief Shell command whose output is inserted as text, running while evaluation continues.
+	 */
+	struct Shell {
+		std::thread thread;
+		std::shared_ptr<Macro> macro;							// Macro of `op`, for reporting errors.
+		const html::Node* op;									// Source `<SHELL>` node.
+		html::Node* node;										// Placeholder for the output, `nullptr` if it was removed.
+		std::string_view cmd;
+		std::shared_ptr<const filepath> cwd;					// Working directory of the command.
+		std::vector<std::pair<const char*,std::string>> env;	// Environment variables of the command.
+		std::string key;										// Key of the output in `ShellCache`, empty if not cached.
+		long cacheSeconds = -1;
+		const Shell* same = nullptr;							// Earlier command with the same key, whose output is used instead of running again.
+		std::string output;
+		int status = 0;
+	};
+	
+	/**
+	 * @brief Shell commands started while evaluating a document, completed by `join()`.
+	 */
+	struct Shells {
+		static constexpr size_t MAX_RUNNING = 64;	// Commands running at once, further commands wait for the oldest.
+		
+		std::vector<std::unique_ptr<Shell>> list;	// Commands in the order they were started.
+		size_t done = 0;							// Commands at the front of `list` which exited.
+		
+		// Started commands with a cache key, by key. Their outputs are stored in `ShellCache` by `join()`.
+		std::unordered_map<std::string_view,const Shell*> cached;
+	};
+
 // ----------------------------------- [ Variables ] ---------------------------------------- //
 public:
 	std::shared_ptr<Macro> macro;
 	std::shared_ptr<VariableMap> variables;
 	Branch currentBranch_block = Branch::NONE;
 	Branch currentBranch_inline = Branch::NONE;
+	Stream* stream = nullptr;
+	html::Document* output = nullptr;	// Rendered document, allocates all created nodes, attributes and strings.
+	Shells* shells = nullptr;	// Commands of the evaluated document, shared with scoped engines.
 	
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 public:
@@ -35,6 +130,29 @@ public:
 	 */
 	void exec(const std::shared_ptr<Macro>& macro, html::Node& dst);
 	
+	/**
+	 * @brief Same as `exec()`, but `doc` is the root of the rendered output and allocates all created nodes.
+	 *        Nodes live until `doc` is destroyed, so documents of cached macros don't grow with each render.
+	 * @param doc Root of the output.
+	 */
+	void exec(const std::shared_ptr<Macro>& macro, html::Document& doc);
+	
+	/**
+	 * @brief Same as `exec()`, but completed parts of the output are written with `writer` during evaluation and then freed.
+	 *        Nodes are allocated from `doc` instead of documents of the macros.
+	 *        Remaining nodes are written by `HtmlWriter::finish()`.
+	 * @param doc Root of the output, which is written by `writer`.
+	 */
+	void exec(const std::shared_ptr<Macro>& macro, html::Document& doc, HtmlWriter& writer);
+	
+	/**
+	 * @brief Write and free completed children of `dst` or its innermost ancestor
+	 *        whose start tag can be written, once enough nodes were created while streaming.
+	 *        Elements whose evaluation may still change their name or attributes are written only when complete.
+	 * @param dst Parent node which got new child elements.
+	 */
+	void flush(html::Node& dst);
+	
 public:
 	/**
 	 * @brief Evaluate single line (node) of a macro.
@@ -56,11 +174,78 @@ public:
 	
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 public:
+	/**
+	 * @brief Resolve opcodes of all tags and attributes in a parsed macro,
+	 *        so evaluation dispatches without comparing names.
+	 *        Subtrees without macros or interpolation are marked with `NodeOptions::STATIC`.
+	 * @param root Root of the macro source. Nodes are annotated in place.
+	 */
+	static void compile(html::Node& root) noexcept;
+	
+	/**
+	 * @brief Resolve opcode of a source node or attribute from its name.
+	 */
+	static Opcode resolve(const html::Node& op) noexcept;
+	static Opcode resolve(const html::Attr& attr) noexcept;
+	
+	/**
+	 * @brief Get opcode assigned by `compile()`, or resolve it for nodes which were not compiled.
+	 */
+	static Opcode opcode(const html::Node& op) noexcept {
+		return (op.op != 0) ? Opcode(op.op) : resolve(op);
+	}
+	
+	static Opcode opcode(const html::Attr& attr) noexcept {
+		return (attr.op != 0) ? Opcode(attr.op) : resolve(attr);
+	}
+	
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	/**
+	 * @brief Get document which allocates created nodes and their strings, see `output`.
+	 */
+	html::Document& document();
+	
 	html::Node* newNode(html::NodeType type);
 	html::Attr* newAttr();
 	char* newStr(size_t len);
 	char* newStr(std::string_view str);
 	
+	/**
+	 * @brief Get parsed expression from the cache of the current macro.
+	 *        The expression is parsed only on first use.
+	 * @param str Expression text from the source of the current macro.
+	 * @return Cached expression. Empty expression if parsing failed.
+	 */
+	const Expression& expression(std::string_view str);
+	
+	/**
+	 * @brief Get parsed interpolation from the cache of the current macro.
+	 *        The string is split into text and expressions only on first use.
+	 * @param str Interpolated text from the source of the current macro.
+	 * @return Cached interpolation.
+	 */
+	const Interpolation& interpolation(std::string_view str);
+	
+	/**
+	 * @brief Get interned symbol of a variable name from the cache of `macro`.
+	 * @param macro Macro which owns the text of `name`.
+	 * @param name Variable name, such as an attribute name.
+	 */
+	static Symbol symbol(Macro& macro, std::string_view name);
+	
+	Symbol symbol(std::string_view name){
+		assert(macro != nullptr);
+		return symbol(*macro, name);
+	}
+	
+	/**
+	 * @brief Get user macro called by name from the call site cache of the current macro.
+	 * @param name Macro name from the source of the current macro.
+	 * @return Handle valid until the next change of `MacroCache`, `nullptr` if the macro does not exist.
+	 */
+	const std::shared_ptr<Macro>* userMacro(std::string_view name);
+	
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 public:
 	/**
@@ -71,6 +256,14 @@ public:
 	 */
 	void text(const html::Node& src, html::Node& dst);
 	
+	/**
+	 * @brief Reference static subtree from the output instead of copying it.
+	 *        The subtree is written directly from the macro source.
+	 * @param src Source node marked with `NodeOptions::STATIC`.
+	 * @param dst Parent node for the created `NodeType::BORROWED` node.
+	 */
+	void borrow(const html::Node& src, html::Node& dst);
+	
 	/**
 	 * @brief Copy HTML tag and attributes.
 	 *        Attributes are also interpolated for expressions.
@@ -110,10 +303,11 @@ public:
 	/**
 	 * @brief Shorthand for <CALL> where the macro name is the tag.
 	 * @param op Operation node from which to extract call information.
+	 * @param target Macro named by `op`, as returned by `userMacro()`.
 	 * @param dst Destination parent node for any created nodes.
-	 * @return `false` if the macro does not exist.
+	 * @return `false` if the macro is not invokable.
 	 */
-	bool call_userElementMacro(const html::Node& op, html::Node& dst);
+	bool call_userElementMacro(const html::Node& op, const std::shared_ptr<Macro>& target, html::Node& dst);
 	
 	/**
 	 * @brief Shorthand for CALL attribute macro where the macro name is the attribute name.
@@ -167,11 +361,28 @@ public:
 	/**
 	 * @brief Execute content of operation node as a shell command and
 	 *         include results in the document.
+	 *        Output inserted as text is awaited by `join()`, so evaluation continues while the command runs.
 	 * @param op Operation node from which to extract the shell command.
 	 * @param dst Destination parent node for any created nodes.
 	 */
 	void shell(const html::Node& op, html::Node& dst);
 	
+	/**
+	 * @brief Wait until at most `running` commands started by `shell()` are still running.
+	 */
+	void wait(size_t running = 0);
+	
+	/**
+	 * @brief Wait for all commands started by `shell()` and replace their placeholders with the output.
+	 *        Placeholders of failed commands and empty outputs are removed.
+	 */
+	void join();
+	
+	/**
+	 * @brief Discard outputs of commands whose placeholders are in the subtree of `node`, before it is removed.
+	 */
+	void detach(const html::Node& node);
+	
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 public:
 	/**
@@ -205,6 +416,19 @@ public:
 	 */
 	static void transfer_parent_space(const html::Node& op, html::Node& dst, const html::Node* prev_last_child);
 	
+	/**
+	 * @brief Get last child of `dst` before `op` adds more, and keep track of it while streaming.
+	 * @return Original last child to pass to `leave_parent_space()`.
+	 */
+	const html::Node* enter_parent_space(const html::Node& op, html::Node& dst);
+	
+	/**
+	 * @brief Transfer leading and trailing whitespace with `transfer_parent_space()`,
+	 *        unless the leading whitespace was already transferred while streaming.
+	 * @param prev_last_child Original last child returned by `enter_parent_space()`.
+	 */
+	void leave_parent_space(const html::Node& op, html::Node& dst, const html::Node* prev_last_child);
+	
 	/**
 	 * @brief Check if attribute is an `IF`, `ELIF` or `ELSE` attribute macro, and evaluate.
 	 * @param op Parent node of `attr`.
@@ -253,7 +477,7 @@ public:
 	
 	/**
 	 * @brief Interpolate string for all expressions.
-	 * @param str The string to interpolate.
+	 * @param str The string to interpolate. Must be text from the source of the current macro.
 	 * @param buff The output buffer for the resulting interpolated string.
 	 *             If an error occurs, the buffer is not cleared.
 	 * @return `true` If no errors occured with interpolation.
@@ -0,0 +1,169 @@
+#include "MacroMemo.hpp"
+#include "MacroEngine.hpp"
+#include <bit>
+#include <functional>
+
+using namespace std;
+using namespace html;
+using Opcode = MacroEngine::Opcode;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+/**
+ * @brief Check if all variables assigned by `<SET>` are parameters of `macro`,
+ *        which are restored after the call.
+ */
+static bool setsParameters(const Node& op, const Macro& macro){
+	for (const Attr* attr = op.attribute ; attr != nullptr ; attr = attr->next){
+		switch (MacroEngine::opcode(*attr)){
+			case Opcode::IF:
+			case Opcode::ELIF:
+			case Opcode::ELSE:
+				continue;
+			default:
+				break;
+		}
+		
+		const Attr* param = macro.html->attribute;
+		while (param != nullptr && (param->name() != attr->name() || MacroEngine::opcode(*param) == Opcode::NAME)){
+			param = param->next;
+		}
+		
+		if (param == nullptr){
+			return false;
+		}
+	
+	}
+	return true;
+}
+
+
+static bool pure(const Node& node, const Macro& macro){
+	if (node.type == NodeType::TAG){
+		switch (MacroEngine::opcode(node)){
+			case Opcode::REGULAR:
+			case Opcode::USER:
+			case Opcode::CALL:
+			case Opcode::IF:
+			case Opcode::ELIF:
+			case Opcode::ELSE:
+				break;
+			
+			case Opcode::SET:
+				if (!setsParameters(node, macro))
+					return false;
+				break;
+			
+			// Loops assign variables, other macros have effects outside of the output.
+			default:
+				return false;
+		}
+		
+		for (const Attr* attr = node.attribute ; attr != nullptr ; attr = attr->next){
+			if (MacroEngine::opcode(*attr) == Opcode::INCLUDE)
+				return false;
+		}
+	
+	}
+	
+	for (const Node* child = node.child ; child != nullptr ; child = child->next){
+		if (!pure(*child, macro))
+			return false;
+	}
+	
+	return true;
+}
+
+
+bool MacroMemo::pure(const Macro& macro){
+	assert(macro.html != nullptr);
+	return ::pure(*macro.html, macro);
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+size_t MacroMemo::hash(Symbol sym, const Value& value) noexcept {
+	size_t h = 0;
+	
+	switch (value.type){
+		case Value::Type::NONE:
+			break;
+		case Value::Type::LONG:
+			h = std::hash<long>()(value.data.l);
+			break;
+		case Value::Type::DOUBLE:
+			h = std::hash<uint64_t>()(bit_cast<uint64_t>(value.data.d));
+			break;
+		case Value::Type::STRING:
+			h = std::hash<string_view>()(value.sv());
+			break;
+		case Value::Type::OBJECT:
+			h = std::hash<const void*>()(value.data.o);
+			break;
+	}
+	
+	// Mix symbol and type, so equal values of different arguments don't cancel out.
+	h ^= (uint64_t(sym) << 8 | uint64_t(value.type)) * 0x9E3779B97F4A7C15ull;
+	return h * 0xFF51AFD7ED558CCDull;
+}
+
+
+bool MacroMemo::same(const Value& a, const Value& b) noexcept {
+	if (a.type != b.type){
+		return false;
+	}
+	
+	switch (a.type){
+		case Value::Type::DOUBLE:
+			return bit_cast<uint64_t>(a.data.d) == bit_cast<uint64_t>(b.data.d);
+		case Value::Type::OBJECT:
+			return a.data.o == b.data.o;
+		default:
+			return a.equals(b);
+	}
+
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+static void reverse(Node& node) noexcept {
+	Node* prev = nullptr;
+	Node* child = node.child;
+	
+	while (child != nullptr){
+		Node* next = child->next;
+		child->next = prev;
+		prev = child;
+		child = next;
+		
+		if (prev->type != NodeType::BORROWED)
+			reverse(*prev);
+	}
+	
+	node.child = prev;
+	
+	Attr* prev_attr = nullptr;
+	Attr* attr = node.attribute;
+	while (attr != nullptr){
+		Attr* next = attr->next;
+		attr->next = prev_attr;
+		prev_attr = attr;
+		attr = next;
+	}
+	
+	node.attribute = prev_attr;
+}
+
+
+void MacroMemo::normalize(Node& output) noexcept {
+	reverse(output);
+}
+
+
+// ------------------------------------------------------------------------------------------ //
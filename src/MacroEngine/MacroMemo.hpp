@@ -0,0 +1,75 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "Macro.hpp"
+#include "VariableMap.hpp"
+
+
+/**
+ * @brief Recorded outputs of calls to a single macro, replayed for later calls with the same inputs.
+ *        Only macros whose bodies have no side effects are memoized (see `pure()`).
+ *        Inputs of a call are its arguments and all other variables read while the call was recorded.
+ */
+class MacroMemo {
+// ----------------------------------- [ Structures ] --------------------------------------- //
+public:
+	using Input = VariableMap::Trace::Read;
+	
+	struct Entry {
+		std::vector<Input> args;		// Arguments of the call, including default parameters.
+		std::vector<Input> reads;		// Other variables read by the call.
+		const html::Node* output;		// Parent of the recorded output, child lists are in document order. Freed with `document`.
+	};
+	
+	enum class Purity : uint8_t {
+		UNKNOWN,
+		PURE,
+		IMPURE
+	};
+
+// ----------------------------------- [ Constants ] ---------------------------------------- //
+public:
+	static constexpr size_t MAX_ENTRIES = 1024;	// Calls recorded per macro.
+	static constexpr size_t MAX_SHAPES = 8;		// Distinct lists of variables read by the recorded calls.
+
+// ------------------------------------[ Properties ] --------------------------------------- //
+public:
+	Purity purity = Purity::UNKNOWN;
+	bool disabled = false;							// Calls are not memoized anymore, since they rarely repeat.
+	size_t hits = 0;
+	size_t misses = 0;
+	double seconds = 0;								// Duration of the shortest recorded call, estimate of time saved by a replay.
+	uint64_t generation = 0;						// `MacroCache::generation()` of the recorded entries.
+	const html::Document* document = nullptr;		// Rendered document which allocated outputs of the entries.
+	
+	std::vector<std::vector<Symbol>> shapes;		// Symbols of `Entry::reads`, each distinct list stored once.
+	std::unordered_multimap<size_t,Entry> entries;	// Keyed by sum of `hash()` of arguments and reads.
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	/**
+	 * @brief Check if the body of a macro can be replayed from its output.
+	 *        The body may only create nodes and set its own parameters. Macros it calls are checked when they are invoked.
+	 * @note `macro.html != nullptr`
+	 */
+	static bool pure(const Macro& macro);
+	
+	/**
+	 * @brief Hash of a single argument. Hashes of all arguments are summed, so their order doesn't matter.
+	 */
+	static size_t hash(Symbol sym, const Value& value) noexcept;
+	
+	/**
+	 * @brief Check if values are interchangeable as inputs of a call.
+	 *        Stricter than `Value::equals()`: doubles are compared bitwise and objects by identity.
+	 */
+	static bool same(const Value& a, const Value& b) noexcept;
+	
+	/**
+	 * @brief Reverse child and attribute lists of recorded output into document order,
+	 *        so the nodes can be borrowed like nodes of a macro source.
+	 */
+	static void normalize(html::Node& output) noexcept;
+
+// ------------------------------------------------------------------------------------------ //
+};
@@ -0,0 +1,163 @@
+#include "ShellCache.hpp"
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unistd.h>
+
+#include "Stats.hpp"
+
+using namespace std;
+
+
+// ----------------------------------- [ Structures ] --------------------------------------- //
+
+
+struct Entry {
+	string output;
+	chrono::steady_clock::time_point time;	// When the command was executed.
+	long seconds;							// Lifetime of the output, `0` for the current build.
+};
+
+
+// ----------------------------------- [ Variables ] ---------------------------------------- //
+
+
+filepath ShellCache::dir;
+
+static unordered_map<string,Entry> outputs;	// Outputs by key.
+static shared_mutex mtx;
+
+
+// ----------------------------------- [ Constants ] ---------------------------------------- //
+
+
+// First line of stored outputs, changed whenever their format changes.
+static constexpr string_view HEADER = "html-macro-shell 1\n";
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+static filepath path(const string& key){
+	char name[24];
+	snprintf(name, sizeof(name), "%016zx", std::hash<string>()(key));
+	return ShellCache::dir / name;
+}
+
+
+/**
+ * @brief Read stored output, unless it is older than `seconds`.
+ *        File holds the header, length of the key, the key and the output.
+ * @param age Receives age of the output.
+ */
+static bool read(const string& key, long seconds, string& output, chrono::nanoseconds& age){
+	const filepath file = path(key);
+	
+	error_code err;
+	const auto mtime = filesystem::last_write_time(file, err);
+	age = filesystem::file_time_type::clock::now() - mtime;
+	if (err || age > chrono::seconds(seconds)){
+		return false;
+	}
+	
+	string content;
+	if (!fs::readFile(file, content)){
+		return false;
+	}
+	
+	const string prefix = string(HEADER) + to_string(key.size()) + "\n" + key;
+	if (!content.starts_with(prefix)){
+		return false;
+	}
+	
+	output = content.substr(prefix.size());
+	return true;
+}
+
+
+static void write(const string& key, string_view output){
+	static atomic<size_t> counter = 0;
+	
+	error_code err;
+	filesystem::create_directories(ShellCache::dir, err);
+	
+	// Written to a unique file first, so other processes never read a partial file.
+	const filepath file = path(key);
+	filepath tmp = file;
+	tmp += "." + to_string(getpid()) + "." + to_string(counter++) + ".tmp";
+	
+	{
+		ofstream out = ofstream(tmp, ios::binary);
+		out << HEADER << key.size() << '\n' << key << output;
+		if (!out.flush()){
+			out.close();
+			filesystem::remove(tmp, err);
+			return;
+		}
+	}
+	
+	filesystem::rename(tmp, file, err);
+	if (err){
+		filesystem::remove(tmp, err);
+	}
+
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+bool ShellCache::find(const string& key, long seconds, string& output){
+	{
+		shared_lock _lock = shared_lock(mtx);
+		auto p = outputs.find(key);
+		
+		// Outputs in memory also expire, e.g. in processes watching for changes.
+		if (p != outputs.end() && (seconds <= 0 || chrono::steady_clock::now() - p->second.time <= chrono::seconds(seconds))){
+			output = p->second.output;
+			Stats::shell.hits++;
+			return true;
+		}
+	}
+	
+	chrono::nanoseconds age;
+	if (seconds > 0 && !dir.empty() && read(key, seconds, output, age)){
+		unique_lock _lock = unique_lock(mtx);
+		outputs[key] = Entry { .output = output, .time = chrono::steady_clock::now() - age, .seconds = seconds };
+		Stats::shell.hits++;
+		return true;
+	}
+	
+	Stats::shell.misses++;
+	return false;
+}
+
+
+void ShellCache::store(const string& key, long seconds, string_view output){
+	{
+		unique_lock _lock = unique_lock(mtx);
+		outputs[key] = Entry { .output = string(output), .time = chrono::steady_clock::now(), .seconds = seconds };
+	}
+	
+	if (seconds > 0 && !dir.empty()){
+		write(key, output);
+	}
+
+}
+
+
+
+void ShellCache::reset(){
+	unique_lock _lock = unique_lock(mtx);
+	erase_if(outputs, [](const auto& p){
+		return p.second.seconds <= 0;
+	});
+}
+
+
+// ------------------------------------------------------------------------------------------ //
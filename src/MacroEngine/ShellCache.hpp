@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "fs.hpp"
+
+
+/**
+ * @brief Outputs of successful `<SHELL>` commands with the `CACHE` attribute, shared by all threads.
+ *        Outputs are kept in memory until the process exits, or until `reset()` for outputs without a lifetime.
+ *        Outputs with a lifetime in seconds are also stored in `dir` and reused by later runs.
+ */
+namespace ShellCache {
+// ------------------------------------[ Properties ] --------------------------------------- //
+
+
+extern filepath dir;	// Directory of stored outputs, empty to keep outputs only in memory.
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+/**
+ * @brief Find output of a command.
+ * @param key Command together with its environment and working directory.
+ * @param seconds Lifetime of stored outputs, or `0` to only use outputs of this process.
+ * @return `false` if the command needs to be executed.
+ */
+bool find(const std::string& key, long seconds, std::string& output);
+
+/**
+ * @brief Store output of a successful command.
+ * @param seconds Lifetime of the output, or `0` to keep it only in memory until `reset()`.
+ */
+void store(const std::string& key, long seconds, std::string_view output);
+
+/**
+ * @brief Forget outputs stored without a lifetime, so that a new build executes their commands again.
+ */
+void reset();
+
+
+// ------------------------------------------------------------------------------------------ //
+};
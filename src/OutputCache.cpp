@@ -0,0 +1,285 @@
+#include "OutputCache.hpp"
+#include <cassert>
+#include <atomic>
+#include <charconv>
+#include <fstream>
+#include <vector>
+#include <unistd.h>
+
+#include "Stats.hpp"
+
+using namespace std;
+
+
+// ----------------------------------- [ Constants ] ---------------------------------------- //
+
+
+// First line of manifests, changed whenever their format changes.
+static constexpr string_view HEADER = "html-macro-cache 2\n";
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+static string hash(string_view s){
+	return SHA256::hex(SHA256::hash(s));
+}
+
+
+/**
+ * @brief Split next line from `s`.
+ */
+static string_view line(string_view& s) noexcept {
+	const size_t n = s.find('\n');
+	const string_view ln = s.substr(0, n);
+	s.remove_prefix((n != string_view::npos) ? n + 1 : s.size());
+	return ln;
+}
+
+
+/**
+ * @brief Split next entry from manifest text `s`. Entries are separated by empty lines.
+ */
+static string_view entry(string_view& s) noexcept {
+	const size_t n = s.find("\n\n");
+	const string_view e = s.substr(0, (n != string_view::npos) ? n + 1 : n);
+	s.remove_prefix((n != string_view::npos) ? n + 2 : s.size());
+	return e;
+}
+
+
+/**
+ * @brief Get key of the output from the first line of an entry: `entry <key>`.
+ */
+static string_view entryKey(string_view e) noexcept {
+	string_view ln = line(e);
+	return ln.starts_with("entry ") ? ln.substr(6) : string_view();
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+bool OutputCache::open(const filepath& dir, string_view settings){
+	error_code err;
+	filesystem::create_directories(dir, err);
+	if (!fs::is_dir(dir)){
+		return false;
+	}
+	
+	this->dir = dir;
+	this->settings = ::hash(settings);
+	return true;
+}
+
+
+filepath OutputCache::manifest(const filepath& input) const {
+	const string key = settings + '\0' + input.native();
+	return dir / (::hash(key) + ".manifest");
+}
+
+
+bool OutputCache::write(const filepath& path, string_view content) const {
+	static atomic<size_t> counter = 0;
+	
+	// Unique name among threads and processes.
+	filepath tmp = path;
+	tmp += "." + to_string(getpid()) + "." + to_string(counter++) + ".tmp";
+	
+	{
+		ofstream out = ofstream(tmp, ios::binary);
+		if (!out.is_open()){
+			return false;
+		}
+		
+		out << content;
+		if (!out.flush()){
+			out.close();
+			error_code err;
+			filesystem::remove(tmp, err);
+			return false;
+		}
+	
+	}
+	
+	error_code err;
+	filesystem::rename(tmp, path, err);
+	if (err){
+		filesystem::remove(tmp, err);
+		return false;
+	}
+	
+	return true;
+}
+
+
+bool OutputCache::hash(const filepath& path, uintmax_t& size, SHA256::Digest& digest){
+	error_code err;
+	const auto mtime = filesystem::last_write_time(path, err);
+	size = err ? 0 : filesystem::file_size(path, err);
+	if (err){
+		return false;
+	}
+	
+	{
+		lock_guard _lock = lock_guard(hashesMutex);
+		auto p = hashes.find(path.native());
+		if (p != hashes.end() && p->second.mtime == mtime && p->second.size == size){
+			digest = p->second.digest;
+			return true;
+		}
+	}
+	
+	string content;
+	if (!fs::readFile(path, content)){
+		return false;
+	}
+	
+	// File may have changed since it was measured.
+	size = content.size();
+	digest = SHA256::hash(content);
+	
+	lock_guard _lock = lock_guard(hashesMutex);
+	hashes[path.native()] = FileHash { .mtime = mtime, .size = size, .digest = digest };
+	return true;
+}
+
+
+/**
+ * @brief Check file of a manifest line `<size> <digest> <path>` and add its path to `deps`.
+ * @return `false` if the file changed or the line is malformed.
+ */
+bool OutputCache::checkFile(string_view ln, Dependencies& deps){
+	uintmax_t size;
+	const auto [p, err] = from_chars(ln.data(), ln.data() + ln.size(), size);
+	ln.remove_prefix(p - ln.data());
+	
+	const size_t n = SHA256::Digest().size() * 2;
+	if (err != errc() || ln.size() < n + 3 || ln[0] != ' ' || ln[n + 1] != ' '){
+		return false;
+	}
+	
+	const string_view digest = ln.substr(1, n);
+	const filepath& path = deps.files.emplace_back(ln.substr(n + 2));
+	
+	uintmax_t fsize;
+	SHA256::Digest fdigest;
+	return hash(path, fsize, fdigest) && fsize == size && SHA256::hex(fdigest) == digest;
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+bool OutputCache::find(const filepath& input, string& output, Dependencies& deps){
+	string manifest;
+	if (!fs::readFile(this->manifest(input), manifest) || !manifest.starts_with(HEADER)){
+		Stats::outputs.misses++;
+		return false;
+	}
+	
+	string_view s = string_view(manifest).substr(HEADER.size());
+	
+	// Entries are ordered from newest to oldest.
+	while (!s.empty()){
+		string_view e = entry(s);
+		const string_view key = entryKey(line(e));
+		if (key.empty()){
+			break;
+		}
+		
+		deps.clear();
+		bool valid = true;
+		
+		while (valid && !e.empty()){
+			const string_view ln = line(e);
+			
+			// file <size> <digest> <path>
+			if (ln.starts_with("file ")){
+				valid = checkFile(ln.substr(5), deps);
+			}
+			
+			// missing <path>
+			else if (ln.starts_with("missing ")){
+				const filepath& path = deps.missing.emplace_back(ln.substr(8));
+				valid = !fs::exists(path);
+			}
+			
+			else {
+				valid = false;
+			}
+		
+		}
+		
+		if (valid && fs::readFile(dir / (string(key) + ".out"), output)){
+			Stats::outputs.hits++;
+			return true;
+		}
+	
+	}
+	
+	deps.clear();
+	Stats::outputs.misses++;
+	return false;
+}
+
+
+bool OutputCache::store(const filepath& input, const Dependencies& deps, string_view output){
+	string e;
+	uintmax_t size;
+	SHA256::Digest digest;
+	
+	for (const filepath& path : deps.files){
+		if (path.native().find('\n') != string::npos || !hash(path, size, digest))
+			return false;
+		e += "file " + to_string(size) + " " + SHA256::hex(digest) + " " + path.native() + "\n";
+	}
+	
+	for (const filepath& path : deps.missing){
+		if (path.native().find('\n') != string::npos)
+			return false;
+		e += "missing " + path.native() + "\n";
+	}
+	
+	// Output is addressed by the input and all its dependencies.
+	const filepath manifestPath = manifest(input);
+	const string key = ::hash(manifestPath.native() + '\n' + e);
+	if (!write(dir / (key + ".out"), output)){
+		return false;
+	}
+	
+	lock_guard _lock = lock_guard(mtx);
+	
+	// Add entry before older entries with other keys.
+	string manifest = string(HEADER) + "entry " + key + "\n" + e + "\n";
+	string old;
+	
+	if (fs::readFile(manifestPath, old) && old.starts_with(HEADER)){
+		string_view s = string_view(old).substr(HEADER.size());
+		size_t n = 1;
+		
+		while (!s.empty()){
+			const string_view oe = entry(s);
+			const string_view okey = entryKey(oe);
+			if (okey.empty() || okey == key){
+				continue;
+			}
+			
+			if (n < MAX_ENTRIES){
+				manifest.append(oe);
+				manifest += '\n';
+				n++;
+			} else {
+				error_code err;
+				filesystem::remove(dir / (string(okey) + ".out"), err);
+			}
+		
+		}
+	
+	}
+	
+	return write(manifestPath, manifest);
+}
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <mutex>
+#include <unordered_map>
+
+#include "fs.hpp"
+#include "Dependencies.hpp"
+#include "SHA256.hpp"
+
+
+/**
+ * @brief Persistent cache of rendered outputs in a directory, shared between runs.
+ *        Each input file has a manifest with recently stored renders, listing hashes of all files the render loaded.
+ *        A stored output is used only if all of its files are unchanged and its missing files still don't exist.
+ *        Outputs are stored by a hash of the input, settings and contents of the files.
+ *        Files are identified by their size and SHA-256 digest, which are stable between runs and builds.
+ */
+class OutputCache {
+// ----------------------------------- [ Constants ] ---------------------------------------- //
+public:
+	static constexpr size_t MAX_ENTRIES = 8;	// Renders kept per input file, e.g. for different branches.
+
+// ----------------------------------- [ Structures ] --------------------------------------- //
+private:
+	struct FileHash {
+		std::filesystem::file_time_type mtime;
+		uintmax_t size;
+		SHA256::Digest digest;
+	};
+
+// ------------------------------------[ Properties ] --------------------------------------- //
+private:
+	filepath dir;
+	std::string settings;	// Digest of options which affect the output.
+	std::mutex mtx;			// Held while a manifest is updated.
+	
+	// Shared files are hashed once, until their modification time or size changes.
+	std::unordered_map<std::string,FileHash> hashes;
+	std::mutex hashesMutex;
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	/**
+	 * @brief Open cache directory, create it if needed.
+	 * @param settings Options which affect the output, such as the program version and variables.
+	 *        Outputs are only shared between runs with equal settings.
+	 * @return `false` if the directory can't be created.
+	 */
+	bool open(const filepath& dir, std::string_view settings);
+	
+	/**
+	 * @brief Find stored output of `input` whose dependencies are unchanged.
+	 * @param deps Receives dependencies of the stored output.
+	 * @return `false` if no output matches.
+	 */
+	bool find(const filepath& input, std::string& output, Dependencies& deps);
+	
+	/**
+	 * @brief Store rendered output and the hashes of its dependencies.
+	 *        Files are replaced by renaming, so concurrent runs never read partial files.
+	 */
+	bool store(const filepath& input, const Dependencies& deps, std::string_view output);
+
+private:
+	filepath manifest(const filepath& input) const;
+	bool hash(const filepath& path, uintmax_t& size, SHA256::Digest& digest);
+	bool checkFile(std::string_view line, Dependencies& deps);
+	bool write(const filepath& path, std::string_view content) const;
+
+// ------------------------------------------------------------------------------------------ //
+};
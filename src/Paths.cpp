@@ -1,4 +1,5 @@
 #include "Paths.hpp"
+#include "Dependencies.hpp"
 
 using namespace std;
 
@@ -6,16 +7,25 @@ using namespace std;
 // ----------------------------------- [ Variables ] ---------------------------------------- //
 
 
-shared_ptr<const filepath> Paths::cwd = make_unique<filepath>(".");
+thread_local shared_ptr<const filepath> Paths::cwd = make_unique<filepath>(".");
 vector<filepath> Paths::includeDirs;
 
 
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
+// Path that was probed but didn't exist, the result would change if it is created.
+static void missed(const filepath& path){
+	if (Dependencies* deps = Dependencies::recording())
+		deps->addMissing(filesystem::proximate(path));
+}
+
+
 bool Paths::resolve(filepath& path, const filepath& cwd) noexcept {
 	try {
 		if (path.is_absolute()){
+			if (!fs::exists(path))
+				missed(path);
 			path = filesystem::canonical(path);
 			return true;
 		}
@@ -26,6 +36,7 @@ bool Paths::resolve(filepath& path, const filepath& cwd) noexcept {
 			path = filesystem::relative(p1);
 			return true;
 		}
+		missed(p1);
 		
 		// Check include paths
 		filepath p2;
@@ -36,7 +47,7 @@ bool Paths::resolve(filepath& path, const filepath& cwd) noexcept {
 				path = filesystem::relative(p2);
 				return true;
 			}
-			
+			missed(p2);
 		}
 		
 		path = filesystem::proximate(p1);
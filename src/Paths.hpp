@@ -9,7 +9,7 @@ namespace Paths {
 // ------------------------------------[ Properties ] --------------------------------------- //
 
 
-extern std::shared_ptr<const filepath> cwd;
+extern thread_local std::shared_ptr<const filepath> cwd;	// Directory of the evaluated macro, set by each thread.
 extern std::vector<filepath> includeDirs;
 
 
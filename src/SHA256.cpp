@@ -0,0 +1,131 @@
+#include "SHA256.hpp"
+#include <bit>
+#include <cstring>
+
+using namespace std;
+
+
+// ----------------------------------- [ Constants ] ---------------------------------------- //
+
+
+static constexpr uint32_t K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+static inline uint32_t load(const uint8_t* p) noexcept {
+	return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+
+static inline void store(uint8_t* p, uint64_t v, int bytes) noexcept {
+	for (int i = bytes - 1 ; i >= 0 ; i--){
+		p[i] = uint8_t(v);
+		v >>= 8;
+	}
+}
+
+
+/**
+ * @brief Process a single 64 byte block of the message.
+ */
+static void compress(uint32_t (&h)[8], const uint8_t* block) noexcept {
+	uint32_t w[64];
+	for (int i = 0 ; i < 16 ; i++){
+		w[i] = load(block + i*4);
+	}
+	
+	for (int i = 16 ; i < 64 ; i++){
+		const uint32_t s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+		const uint32_t s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+		w[i] = w[i-16] + s0 + w[i-7] + s1;
+	}
+	
+	uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+	uint32_t e = h[4], f = h[5], g = h[6], k = h[7];
+	
+	for (int i = 0 ; i < 64 ; i++){
+		const uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+		const uint32_t ch = (e & f) ^ (~e & g);
+		const uint32_t t1 = k + S1 + ch + K[i] + w[i];
+		const uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+		const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+		const uint32_t t2 = S0 + maj;
+		
+		k = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+	
+	h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+	h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+SHA256::Digest SHA256::hash(string_view data) noexcept {
+	uint32_t h[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+	
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data());
+	size_t n = data.size();
+	
+	for ( ; n >= 64 ; n -= 64, p += 64){
+		compress(h, p);
+	}
+	
+	// Last block is padded with bit 1, zeros and the message length in bits.
+	uint8_t block[128] = {};
+	memcpy(block, p, n);
+	block[n] = 0x80;
+	
+	const size_t len = (n < 56) ? 64 : 128;
+	store(block + len - 8, uint64_t(data.size()) * 8, 8);
+	
+	compress(h, block);
+	if (len == 128){
+		compress(h, block + 64);
+	}
+	
+	Digest digest;
+	for (int i = 0 ; i < 8 ; i++){
+		store(digest.data() + i*4, h[i], 4);
+	}
+	
+	return digest;
+}
+
+
+string SHA256::hex(const Digest& digest){
+	static constexpr char DIGITS[] = "0123456789abcdef";
+	string s = string(digest.size() * 2, '0');
+	
+	for (size_t i = 0 ; i < digest.size() ; i++){
+		s[i*2] = DIGITS[digest[i] >> 4];
+		s[i*2 + 1] = DIGITS[digest[i] & 0xF];
+	}
+	
+	return s;
+}
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -0,0 +1,31 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+/**
+ * @brief SHA-256 digest (FIPS 180-4), for identifying file contents across runs.
+ */
+namespace SHA256 {
+// ----------------------------------- [ Structures ] --------------------------------------- //
+
+
+using Digest = std::array<uint8_t,32>;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+Digest hash(std::string_view data) noexcept;
+
+
+/**
+ * @brief Convert `digest` to 64 lowercase hexadecimal digits.
+ */
+std::string hex(const Digest& digest);
+
+
+// ------------------------------------------------------------------------------------------ //
+};
@@ -0,0 +1,106 @@
+#include "Stats.hpp"
+#include "Debug.hpp"
+#include "Value.hpp"
+#include <mutex>
+
+using namespace std;
+
+
+// ----------------------------------- [ Variables ] ---------------------------------------- //
+
+
+constinit thread_local CacheStats Stats::expressions;
+constinit thread_local CacheStats Stats::interpolations;
+constinit thread_local CacheStats Stats::regex;
+constinit thread_local CacheStats Stats::calls;
+constinit thread_local CacheStats Stats::memo;
+constinit thread_local double Stats::memoSeconds = 0;
+constinit thread_local CacheStats Stats::outputs;
+constinit thread_local CacheStats Stats::shell;
+
+
+// Totals of collected threads.
+static struct {
+	CacheStats expressions;
+	CacheStats interpolations;
+	CacheStats regex;
+	CacheStats calls;
+	CacheStats memo;
+	double memoSeconds = 0;
+	CacheStats outputs;
+	CacheStats shell;
+	decltype(Value::pools()) pools = {};
+} total;
+
+static mutex totalMutex;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+static void print(const char* name, const CacheStats& stats){
+	const size_t total = stats.hits + stats.misses;
+	const double rate = (total > 0) ? (100.0 * double(stats.hits) / double(total)) : 0.0;
+	LOG_STDERR("  %-20s %10zu hits %10zu misses %6.1f%%\n", name, stats.hits, stats.misses, rate);
+}
+
+
+static void print(const PoolStats& stats){
+	const size_t kib = (stats.capacity * stats.block + 1023) / 1024;
+	LOG_STDERR("  %-20s %10zu used %10zu peak %10zu KiB\n", stats.name, stats.used, stats.peak, kib);
+}
+
+
+static void add(CacheStats& dst, CacheStats& src){
+	dst.hits += src.hits;
+	dst.misses += src.misses;
+	src = {};
+}
+
+
+void Stats::collect(){
+	lock_guard _lock = lock_guard(totalMutex);
+	add(total.expressions, Stats::expressions);
+	add(total.interpolations, Stats::interpolations);
+	add(total.regex, Stats::regex);
+	add(total.calls, Stats::calls);
+	add(total.memo, Stats::memo);
+	total.memoSeconds += Stats::memoSeconds;
+	Stats::memoSeconds = 0;
+	add(total.outputs, Stats::outputs);
+	add(total.shell, Stats::shell);
+	
+	// Pools are kept by threads until they exit, so only their current state is added.
+	const auto pools = Value::pools();
+	for (size_t i = 0 ; i < pools.size() ; i++){
+		PoolStats& dst = total.pools[i];
+		dst.name = pools[i].name;
+		dst.block = pools[i].block;
+		dst.used += pools[i].used;
+		dst.peak += pools[i].peak;
+		dst.capacity += pools[i].capacity;
+	}
+
+}
+
+
+void Stats::print(){
+	collect();
+	
+	LOG_STDERR(ANSI_BOLD "Statistics:\n" ANSI_RESET);
+	::print("expression cache", total.expressions);
+	::print("interpolation cache", total.interpolations);
+	::print("regex cache", total.regex);
+	::print("macro call cache", total.calls);
+	::print("macro memo", total.memo);
+	LOG_STDERR("  %-20s %10.3f ms saved\n", "macro memo time", total.memoSeconds * 1000.0);
+	::print("output cache", total.outputs);
+	::print("shell cache", total.shell);
+	
+	for (const PoolStats& pool : total.pools){
+		::print(pool);
+	}
+}
+
+
+// ------------------------------------------------------------------------------------------ //
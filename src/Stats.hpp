@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+
+
+// ----------------------------------- [ Structures ] --------------------------------------- //
+
+
+struct CacheStats {
+	size_t hits = 0;
+	size_t misses = 0;
+};
+
+
+struct PoolStats {
+	const char* name = nullptr;
+	size_t block = 0;		// Size of a single block in bytes.
+	size_t used = 0;		// Blocks currently allocated.
+	size_t peak = 0;		// Maximum number of blocks allocated at once.
+	size_t capacity = 0;	// Blocks reserved in pages.
+};
+
+
+// ----------------------------------- [ Variables ] ---------------------------------------- //
+
+
+/**
+ * @brief Statistics are counted separately by each thread and summed by `collect()`.
+ */
+namespace Stats {
+	extern constinit thread_local CacheStats expressions;		// Parsed expressions reused from `ExpressionCache`.
+	extern constinit thread_local CacheStats interpolations;	// Parsed interpolations reused from `ExpressionCache`.
+	extern constinit thread_local CacheStats regex;				// Compiled patterns reused from `Regex::compile()`.
+	extern constinit thread_local CacheStats calls;				// User macros resolved from `ExpressionCache` instead of `MacroCache`.
+	extern constinit thread_local CacheStats memo;				// Calls of pure macros replayed from `MacroMemo`.
+	extern constinit thread_local double memoSeconds;			// Evaluation time saved by replayed calls, estimated from the shortest recorded calls.
+	extern constinit thread_local CacheStats outputs;			// Rendered files copied from `OutputCache`.
+	extern constinit thread_local CacheStats shell;				// Outputs of commands reused from `ShellCache`.
+	
+	/**
+	 * @brief Add statistics of the current thread to the process totals and reset them.
+	 *        Called by threads before they exit.
+	 */
+	void collect();
+	
+	/**
+	 * @brief Collect statistics of the current thread and print process totals to stderr.
+	 */
+	void print();
+
+};
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -0,0 +1,93 @@
+#include "Watch.hpp"
+#include <cassert>
+#include <cerrno>
+#include <algorithm>
+#include <poll.h>
+#include <sys/inotify.h>
+
+using namespace std;
+
+
+// ----------------------------------- [ Constants ] ---------------------------------------- //
+
+
+// Events of files which were written, created, replaced or removed.
+static constexpr uint32_t EVENTS = IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+bool FileWatcher::open(){
+	fd = fs::FileDesc(inotify_init1(IN_CLOEXEC));
+	return fd.isOpen();
+}
+
+
+bool FileWatcher::add(const filepath& file){
+	assert(fd.isOpen());
+	filepath dir = file.parent_path();
+	
+	if (watched.contains(dir.string())){
+		return true;
+	}
+	
+	const int wd = inotify_add_watch(fd, dir.empty() ? "." : dir.c_str(), EVENTS);
+	if (wd < 0){
+		return false;
+	}
+	
+	// Different paths of the same directory get the same descriptor.
+	watched.emplace(dir.string(), wd);
+	dirs[wd].emplace_back(move(dir));
+	return true;
+}
+
+
+bool FileWatcher::wait(vector<filepath>& changed, int settle){
+	assert(fd.isOpen());
+	alignas(inotify_event) char buff[4096];
+	int timeout = -1;	// Block until the first event.
+	
+	while (true){
+		pollfd p = { .fd = fd, .events = POLLIN, .revents = 0 };
+		const int n = poll(&p, 1, timeout);
+		
+		if (n < 0){
+			if (errno == EINTR)
+				continue;
+			return false;
+		} else if (n == 0){
+			break;	// Settled
+		}
+		
+		const ssize_t len = read(fd, buff, sizeof(buff));
+		if (len <= 0){
+			return false;
+		}
+		
+		for (ssize_t i = 0 ; i < len ; ){
+			const inotify_event& e = *reinterpret_cast<const inotify_event*>(buff + i);
+			i += ssize_t(sizeof(inotify_event) + e.len);
+			
+			auto dir = dirs.find(e.wd);
+			if (dir == dirs.end() || e.len == 0 || (e.mask & IN_ISDIR)){
+				continue;
+			}
+			
+			for (const filepath& d : dir->second){
+				filepath path = d / e.name;
+				if (find(changed.begin(), changed.end(), path) == changed.end())
+					changed.emplace_back(move(path));
+			}
+		}
+		
+		if (!changed.empty())
+			timeout = settle;
+	}
+	
+	return true;
+}
+
+
+// ------------------------------------------------------------------------------------------ //
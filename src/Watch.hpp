@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "fs.hpp"
+#include "fd.hpp"
+
+
+/**
+ * @brief Notifies about changed files using inotify.
+ *        Directories of the files are watched instead of the files themselves,
+ *        so files replaced by editors (written to a new file and renamed) are still noticed.
+ */
+class FileWatcher {
+// ------------------------------------[ Properties ] --------------------------------------- //
+private:
+	fs::FileDesc fd;
+	std::unordered_map<int,std::vector<filepath>> dirs;	// Watched directories by watch descriptor, same directory may have several paths.
+	std::unordered_map<std::string,int> watched;		// Watch descriptors by directory.
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	/**
+	 * @brief Initialize inotify.
+	 * @return `false` if inotify is not available.
+	 */
+	bool open();
+	
+	/**
+	 * @brief Watch directory of `file` for changes.
+	 * @param file Path of a file, as it should be reported by `wait()`.
+	 */
+	bool add(const filepath& file);
+	
+	/**
+	 * @brief Block until watched files change.
+	 *        Changes that arrive within `settle` milliseconds of each other are reported together,
+	 *        since saving a file often produces several events.
+	 * @param changed Paths of changed files in watched directories, joined with each path of the directory passed to `add()`.
+	 * @return `false` on error.
+	 */
+	bool wait(std::vector<filepath>& changed, int settle = 50);
+
+// ------------------------------------------------------------------------------------------ //
+};
@@ -3,6 +3,8 @@
 #include <string_view>
 #include <array>
 #include <iostream>
+#include <charconv>
+#include <thread>
 
 #include "Debug.hpp"
 
@@ -26,6 +28,13 @@ enum class OptId {
 	COMPRESS,
 	OUTPUT_DISCARD,
 	DEPENDENCIES,
+	STATS,
+	STREAM,
+	BATCH,
+	JOBS,
+	WATCH,
+	DEPFILE,
+	CACHE,
 };
 
 struct OptInfo {
@@ -43,6 +52,13 @@ constexpr array options = {
 	OptInfo { "-c", "--compress",     OptId::COMPRESS,       true  },
 	OptInfo { "-x", "--nostdout",     OptId::OUTPUT_DISCARD, false },
 	OptInfo { "-d", "--dependencies", OptId::DEPENDENCIES,   false },
+	OptInfo { "",   "--stats",        OptId::STATS,          false },
+	OptInfo { "-s", "--stream",       OptId::STREAM,         false },
+	OptInfo { "-b", "--batch",        OptId::BATCH,          true  },
+	OptInfo { "-j", "--jobs",         OptId::JOBS,           true  },
+	OptInfo { "-w", "--watch",        OptId::WATCH,          false },
+	OptInfo { "-M", "--depfile",      OptId::DEPFILE,        true  },
+	OptInfo { "-C", "--cache",        OptId::CACHE,          true  },
 };
 
 
@@ -59,6 +75,18 @@ static bool onOption(OptId id, const char* value){
 			opt.printDependencies = true;
 			return true;
 		
+		case OptId::STATS:
+			opt.printStats = true;
+			return true;
+		
+		case OptId::STREAM:
+			opt.stream = true;
+			return true;
+		
+		case OptId::WATCH:
+			opt.watch = true;
+			return true;
+		
 		case OptId::OUTPUT_DISCARD:
 			opt.outFilePath = nullptr;
 			return true;
@@ -94,6 +122,33 @@ static bool onOption(OptId id, const char* value){
 			opt.includes.emplace_back(value);
 			return true;
 		
+		case OptId::BATCH:
+			opt.batchFilePath = value;
+			return true;
+		
+		case OptId::DEPFILE:
+			opt.depFilePath = value;
+			return true;
+		
+		case OptId::CACHE:
+			opt.cacheDir = value;
+			return true;
+		
+		case OptId::JOBS: {
+			assert(value != nullptr);
+			const char* end = value + strlen(value);
+			
+			unsigned n = 0;
+			auto res = from_chars(value, end, n);
+			if (res.ec != errc() || res.ptr != end){
+				ERROR("Invalid option value " PURPLE("`%s`") ". Expected number of threads or " CYAN("`0`") " for all cores.", value);
+				return false;
+			}
+			
+			opt.jobs = (n > 0) ? n : max(thread::hardware_concurrency(), 1u);
+			return true;
+		}
+		
 		case OptId::COMPRESS: {
 			assert(value != nullptr);
 			
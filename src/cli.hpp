@@ -10,11 +10,18 @@ extern struct Opt {
 	const char* program = "html-macro";
 	bool help = false;
 	bool printDependencies = false;
+	bool printStats = false;
+	bool stream = false;
+	bool watch = false;
 	
 	const char* inFilePath = nullptr;
+	const char* batchFilePath = nullptr;	// Manifest of input and output files, `-` is stdin
+	unsigned jobs = 1;						// Threads rendering files of the batch
 	Macro::Type inFileType = Macro::Type::NONE;
 	
-	const char* outFilePath = "-";	// `-` is stdout
+	const char* outFilePath = "-";		// `-` is stdout
+	const char* depFilePath = nullptr;	// Make rules of output files
+	const char* cacheDir = nullptr;		// Directory of cached outputs, shared between runs
 	WriteOptions compress = WriteOptions::NONE;
 	
 	std::vector<const char*> includes;
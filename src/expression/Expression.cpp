@@ -1,6 +1,8 @@
 #include "Expression.hpp"
 #include "ExpressionAllocator.hpp"
+#include "ExpressionBytecode.hpp"
 #include <cmath>
+#include <climits>
 
 #include "Debug.hpp"
 #include "DebugSource.hpp"
@@ -51,7 +53,7 @@ static Value::Object& uniq_obj(Value& val){
 	if (val.data.o->refs > 1){
 		unique_ptr<Value::Object> o2 = Value::Object::create();
 		o2->arr = val.data.o->arr;
-		val.data.o->dict.copy(o2->dict);
+		o2->dict = val.data.o->dict;
 		val.data.o->unref();
 		val.data.o = o2.release()->ref();
 	}
@@ -99,12 +101,28 @@ static void error_invalid_property_type(const Expression& self, const Operation&
 	printCodeView(pos, mark, ANSI_YELLOW);
 }
 
+static void warn_integer_division(const Expression& self, const Operation& op, long divisor){
+	if (self.origin == nullptr){
+		return;
+	}
+	
+	string_view mark = op.view();
+	linepos pos = findLine(*self.origin, mark.begin());
+	
+	print(pos);
+	if (divisor == 0)
+		LOG_STDERR(WARN_PFX "Integer division by zero.\n");
+	else
+		LOG_STDERR(WARN_PFX "Integer division overflows.\n");
+	printCodeView(pos, mark, ANSI_YELLOW);
+}
+
 
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
 static Value var(const Expression& self, const Variable& var, const VariableMap& vars){
-	const Value* val = vars.get(var.name());
+	const Value* val = vars.get(var.sym);
 	if (val != nullptr){
 		return Value(*val);
 	} else {
@@ -114,11 +132,9 @@ static Value var(const Expression& self, const Variable& var, const VariableMap&
 }
 
 
-static Value index(const Expression& self, const Index& idx, const VariableMap& vars){
+static Value index(const Expression& self, const Index& idx, const Value& obj, const Value& index){
 	assert(idx.obj != nullptr);
 	assert(idx.index != nullptr);
-	Value obj = eval(self, *idx.obj, vars);
-	Value index = eval(self, *idx.index, vars);
 	
 	if (obj.type == Type::NONE){
 		return Value();
@@ -127,8 +143,8 @@ static Value index(const Expression& self, const Index& idx, const VariableMap&
 		return Value();
 	}
 	
-	Value::Object& o = *obj.data.o;
-	Value* el = nullptr;
+	const Value::Object& o = *obj.data.o;
+	const Value* el = nullptr;
 	
 	switch (index.type){
 		case Type::LONG:
@@ -138,7 +154,7 @@ static Value index(const Expression& self, const Index& idx, const VariableMap&
 			el = o.get(size_t(index.data.d));
 			break;
 		case Type::STRING:
-			el = o.get(index.data.s->sv());
+			el = o.get(index.sv());
 			break;
 		case Type::OBJECT:
 			HERE(error_invalid_property_type(self, *idx.index));
@@ -155,6 +171,41 @@ static Value index(const Expression& self, const Index& idx, const VariableMap&
 }
 
 
+/**
+ * @brief Insert dictionary entry into object. Key must be a string or number.
+ */
+static void object_insert(const Expression& self, Value::Object& obj, const Operation& key_op, Value&& key, Value&& val){
+	string key_buff;
+	string_view key_s;
+	
+	// Verify type.
+	switch (key.type){
+		case Type::LONG:
+			key_buff = to_string(key.data.l);
+			key_s = key_buff;
+			break;
+		
+		case Type::DOUBLE:
+			key_buff = to_string(key.data.l);
+			key_s = key_buff;
+			break;
+		
+		case Type::STRING:
+			key_s = key.sv();
+			break;
+		
+		case Type::OBJECT:
+			HERE(error_invalid_property_type(self, key_op));
+			return;
+		
+		case Type::NONE:
+			return;
+	}
+	
+	obj.insert(key_s, move(val));
+}
+
+
 static Value object(const Expression& self, const Object& objop, const VariableMap& vars){
 	unique_ptr<Value::Object> obj = Value::Object::create();
 	
@@ -171,55 +222,21 @@ static Value object(const Expression& self, const Object& objop, const VariableM
 		else {
 			Value key = eval(self, *e.key, vars);
 			Value val = eval(self, *e.value, vars);
-			
-			string key_buff;
-			string_view key_s;
-			
-			// Verify type.
-			switch (key.type){
-				case Type::LONG:
-					key_buff = to_string(key.data.l);
-					key_s = key_buff;
-					break;
-				
-				case Type::DOUBLE:
-					key_buff = to_string(key.data.l);
-					key_s = key_buff;
-					break;
-				
-				case Type::STRING:
-					key_s = key.data.s->sv();
-					break;
-				
-				case Type::OBJECT:
-					HERE(error_invalid_property_type(self, *e.key));
-					goto next;
-				
-				case Type::NONE:
-					goto next;
-			}
-			
-			obj->insert(key_s, move(val));
+			object_insert(self, *obj, *e.key, move(key), move(val));
 		}
 		
-		next: continue;
 	}
 	
 	return Value(obj.release());
 }
 
 
-static Value nott(const Expression& self, const UnaryOperation& unop, const VariableMap& vars){
-	assert(unop.arg != nullptr);
-	Value val = eval(self, *unop.arg, vars);
-	return val.getBool() ? 0L : 1L;
+static void nott(Value& val){
+	val = val.getBool() ? 0L : 1L;
 }
 
 
-static Value neg(const Expression& self, const UnaryOperation& unop, const VariableMap& vars){
-	assert(unop.arg != nullptr);
-	Value val = eval(self, *unop.arg, vars);
-	
+static void neg(Value& val){
 	switch (val.type){
 		case Type::LONG:
 			val = -val.data.l;
@@ -232,18 +249,13 @@ static Value neg(const Expression& self, const UnaryOperation& unop, const Varia
 		case Type::OBJECT:
 			break;
 	}
-	
-	return val;
 }
 
 
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
-static Value add(const Expression& self, const BinaryOperation& binop, const VariableMap& vars){
-	assert(binop.arg_1 != nullptr && binop.arg_2 != nullptr);
-	Value v1 = eval(self, *binop.arg_1, vars);
-	Value v2 = eval(self, *binop.arg_2, vars);
+static void add(Value& v1, Value v2){
 	
 	if (v1.type == Type::NONE) [[unlikely]] {
 		v1 = move(v2);
@@ -255,7 +267,7 @@ static Value add(const Expression& self, const BinaryOperation& binop, const Var
 		else if (v2.type == Type::DOUBLE)
 			v1 = v1.data.l + v2.data.d;
 		else if (v2.type == Type::STRING)
-			v1 = Value(to_string(v1.data.l), v2.data.s->sv());
+			v1 = Value(to_string(v1.data.l), v2.sv());
 		else if (v2.type == Type::OBJECT){
 			uniq_obj(v2).insert(0, move(v1));
 			v1 = move(v2);
@@ -268,7 +280,7 @@ static Value add(const Expression& self, const BinaryOperation& binop, const Var
 		else if (v2.type == Type::DOUBLE)
 			v1.data.d += v2.data.d;
 		else if (v2.type == Type::STRING)
-			v1 = Value(to_string(v1.data.l), v2.data.s->sv());
+			v1 = Value(to_string(v1.data.l), v2.sv());
 		else if (v2.type == Type::OBJECT){
 			uniq_obj(v2).insert(0, move(v1));
 			v1 = move(v2);
@@ -277,12 +289,12 @@ static Value add(const Expression& self, const BinaryOperation& binop, const Var
 	
 	else if (v1.type == Type::STRING){
 		if (v2.type == Type::STRING){
-			v1 = Value(v1.data.s->sv(), v2.toStr());
+			v1.append(v2.sv());
 		} else if (v2.type == Type::OBJECT){
 			uniq_obj(v2).insert(0, move(v1));
 			v1 = move(v2);
 		} else if (v2.type != Type::NONE){
-			v1 = Value(v1.data.s->sv(), v2.toStr());
+			v1.append(v2.toStr());
 		}
 	}
 	
@@ -290,15 +302,10 @@ static Value add(const Expression& self, const BinaryOperation& binop, const Var
 		if (v2.type != Type::NONE)
 			uniq_obj(v1).arr.emplace_back(move(v2));
 	}
-	
-	return v1;
 }
 
 
-static Value sub(const Expression& self, const BinaryOperation& binop, const VariableMap& vars){
-	assert(binop.arg_1 != nullptr && binop.arg_2 != nullptr);
-	Value v1 = eval(self, *binop.arg_1, vars);
-	Value v2 = eval(self, *binop.arg_2, vars);
+static void sub(Value& v1, Value v2){
 	
 	if (v1.type == Type::LONG){
 		if (v2.type == Type::LONG)
@@ -315,8 +322,6 @@ static Value sub(const Expression& self, const BinaryOperation& binop, const Var
 	}
 	
 	else if (v1.type == Type::STRING){
-		Value::String& s = *v1.data.s;
-		
 		// Downcast double to long.
 		if (v2.type == Type::DOUBLE){
 			v2.type = Type::LONG;
@@ -325,14 +330,8 @@ static Value sub(const Expression& self, const BinaryOperation& binop, const Var
 		
 		// Shorten string.
 		if (v2.type == Type::LONG){
-			const size_t len = (v2.data.l < s.len) ? s.len - v2.data.l : 0;
-			
-			if (v1.data.s->refs <= 1){
-				v1.data.s->len = uint32_t(len);
-			} else {
-				v1 = Value(string_view(s.str, len));
-			}
-			
+			const long n = long(v1.sv().length());
+			v1.truncate((v2.data.l < n) ? size_t(n - v2.data.l) : 0);
 		}
 		
 	}
@@ -341,9 +340,14 @@ static Value sub(const Expression& self, const BinaryOperation& binop, const Var
 		Value::Object& o1 = uniq_obj(v1);
 		
 		// Remove identical elements.
-		for (ssize_t i = o1.arr.size() - 1 ; i >= 0 ; i--){
-			if (o1.arr[i] == v2)
-				o1.arr.erase(o1.arr.begin() + i);
+		persistent_vector<Value> arr;
+		for (const Value& el : o1.arr){
+			if (!(el == v2))
+				arr.push_back(el);
+		}
+		
+		if (arr.size() != o1.arr.size()){
+			o1.arr = move(arr);
 		}
 		
 	}
@@ -351,15 +355,10 @@ static Value sub(const Expression& self, const BinaryOperation& binop, const Var
 	else if (v1.type == Type::NONE){
 		v1 = move(v2);
 	}
-	
-	return v1;
 }
 
 
-static Value mul(const Expression& self, const BinaryOperation& binop, const VariableMap& vars){
-	assert(binop.arg_1 != nullptr && binop.arg_2 != nullptr);
-	Value v1 = eval(self, *binop.arg_1, vars);
-	Value v2 = eval(self, *binop.arg_2, vars);
+static void mul(Value& v1, Value v2){
 	
 	auto mul = [](string_view sv, long n){
 		assert(n > 0);
@@ -387,7 +386,7 @@ static Value mul(const Expression& self, const BinaryOperation& binop, const Var
 			else if (v1.data.l == 1)
 				v1 = move(v2);
 			else
-				v1 = mul(v2.data.s->sv(), v1.data.l);
+				v1 = mul(v2.sv(), v1.data.l);
 		}
 		else if (v2.type == Type::OBJECT){
 			uniq_obj(v2).insert(0, move(v1));
@@ -408,7 +407,7 @@ static Value mul(const Expression& self, const BinaryOperation& binop, const Var
 			else if (v1.data.d == 1)
 				v1 = move(v2);
 			else
-				v1 = mul(v2.data.s->sv(), long(v1.data.d));
+				v1 = mul(v2.sv(), long(v1.data.d));
 		}
 		else if (v2.type == Type::OBJECT){
 			uniq_obj(v2).insert(0, move(v1));
@@ -420,9 +419,9 @@ static Value mul(const Expression& self, const BinaryOperation& binop, const Var
 		if (v2.type == Type::NONE)
 			v1 = Value();
 		else if (v2.type == Type::LONG)
-			v1 = mul(v1.data.s->sv(), v2.data.l);
+			v1 = mul(v1.sv(), v2.data.l);
 		else if (v2.type == Type::DOUBLE)
-			v1 = mul(v1.data.s->sv(), long(v2.data.d));
+			v1 = mul(v1.sv(), long(v2.data.d));
 		else if (v2.type == Type::OBJECT){
 			uniq_obj(v2).insert(0, move(v1));
 			v1 = move(v2);
@@ -449,15 +448,26 @@ static Value mul(const Expression& self, const BinaryOperation& binop, const Var
 	else if (v1.type == Type::NONE){
 		v1 = move(v2);
 	}
+}
+
+
+/**
+ * @brief Check if integer division or remainder of `v1` by `v2` is defined, report it otherwise.
+ *        Dividing by zero or `LONG_MIN` by `-1` would terminate the process.
+ */
+static bool divisible(const Expression& self, const Operation& op, const Value& v1, const Value& v2){
+	if (v1.type != Type::LONG || v2.type != Type::LONG){
+		return true;
+	} else if (v2.data.l != 0 && (v2.data.l != -1 || v1.data.l != LONG_MIN)){
+		return true;
+	}
 	
-	return v1;
+	HERE(warn_integer_division(self, op, v2.data.l));
+	return false;
 }
 
 
-static Value div(const Expression& self, const BinaryOperation& binop, const VariableMap& vars){
-	assert(binop.arg_1 != nullptr && binop.arg_2 != nullptr);
-	Value v1 = eval(self, *binop.arg_1, vars);
-	Value v2 = eval(self, *binop.arg_2, vars);
+static void div(Value& v1, Value v2){
 	
 	if (v1.type == Type::NONE){
 		v1 = move(v2);
@@ -485,7 +495,7 @@ static Value div(const Expression& self, const BinaryOperation& binop, const Var
 		else if (v2.type == Type::DOUBLE)
 			o1.remove(static_cast<size_t>(v2.data.d));
 		else if (v2.type == Type::STRING)
-			o1.remove(v2.data.s->sv());
+			o1.remove(v2.sv());
 		else if (v2.type == Type::OBJECT){
 			// TODO: optimize by constructing the object without the elements instead of removing them.
 			
@@ -496,7 +506,7 @@ static Value div(const Expression& self, const BinaryOperation& binop, const Var
 				else if (el.type == Type::DOUBLE)
 					o1.remove(size_t(el.data.d));
 				else if (el.type == Type::STRING)
-					o1.remove(el.data.s->sv());
+					o1.remove(el.sv());
 			}
 			
 			// Remove properties indexed from o2 dictionary.
@@ -506,15 +516,10 @@ static Value div(const Expression& self, const BinaryOperation& binop, const Var
 			
 		}
 	}
-	
-	return v1;
 }
 
 
-static Value mod(const Expression& self, const BinaryOperation& binop, const VariableMap& vars){
-	assert(binop.arg_1 != nullptr && binop.arg_2 != nullptr);
-	Value v1 = eval(self, *binop.arg_1, vars);
-	Value v2 = eval(self, *binop.arg_2, vars);
+static void mod(Value& v1, Value v2){
 	
 	if (v1.type == Type::LONG){
 		if (v2.type == Type::LONG)
@@ -546,7 +551,7 @@ static Value mod(const Expression& self, const BinaryOperation& binop, const Var
 	
 	else if (v1.type == Type::STRING){
 		if (v2.type == Type::OBJECT){
-			const Value* v = v2.data.o->get(v1.data.s->sv());
+			const Value* v = v2.data.o->get(v1.sv());
 			v1 = (v != nullptr) ? *v : Value();
 		} else {
 			v1 = Value();
@@ -557,15 +562,15 @@ static Value mod(const Expression& self, const BinaryOperation& binop, const Var
 		Value::Object& o1 = *v1.data.o;
 		
 		if (v2.type == Type::LONG){
-			Value* v = o1.get(static_cast<size_t>(v2.data.l));
+			const Value* v = o1.get(static_cast<size_t>(v2.data.l));
 			v1 = (v != nullptr) ? *v : Value();
 		}
 		else if (v2.type == Type::DOUBLE){
-			Value* v = o1.get(static_cast<size_t>(v2.data.l));
+			const Value* v = o1.get(static_cast<size_t>(v2.data.l));
 			v1 = (v != nullptr) ? *v : Value();
 		}
 		else if (v2.type == Type::STRING){
-			Value* v = o1.get(v2.data.s->sv());
+			const Value* v = o1.get(v2.sv());
 			v1 = (v != nullptr) ? *v : Value();
 		}
 		else if (v2.type == Type::OBJECT){
@@ -576,17 +581,17 @@ static Value mod(const Expression& self, const BinaryOperation& binop, const Var
 			// Build array by extracting elements from o1 and indecies from o2.
 			for (const Value& el : o2.arr){
 				if (el.type == Type::LONG){
-					Value* v = o1.get(static_cast<size_t>(el.data.l));
+					const Value* v = o1.get(static_cast<size_t>(el.data.l));
 					if (v != nullptr)
 						o3->arr.emplace_back(*v);
 				}
 				else if (el.type == Type::DOUBLE){
-					Value* v = o1.get(static_cast<size_t>(el.data.d));
+					const Value* v = o1.get(static_cast<size_t>(el.data.d));
 					if (v != nullptr)
 						o3->arr.emplace_back(*v);
 				}
 				else if (el.type == Type::STRING){
-					Value* v = o1.get(el.data.s->sv());
+					const Value* v = o1.get(el.sv());
 					if (v != nullptr)
 						o3->arr.emplace_back(*v);
 				}
@@ -594,7 +599,7 @@ static Value mod(const Expression& self, const BinaryOperation& binop, const Var
 			
 			// Build dictionary by extracting entries from o1 and keys from o2.
 			for (const auto& pair : o2.dict){
-				Value* v = o1.get(pair.key);
+				const Value* v = o1.get(pair.key);
 				if (v != nullptr)
 					o3->dict.insert(pair.key, *v);
 			}
@@ -606,8 +611,6 @@ static Value mod(const Expression& self, const BinaryOperation& binop, const Var
 	else if (v1.type == Type::NONE){
 		v1 = move(v2);
 	}
-	
-	return v1;
 }
 
 
@@ -615,21 +618,15 @@ static Value mod(const Expression& self, const BinaryOperation& binop, const Var
 
 
 template<typename OP>
-static Value logical(const Expression& self, const BinaryOperation& binop, const VariableMap& vars){
-	assert(binop.arg_1 != nullptr && binop.arg_2 != nullptr);
-	Value v1 = eval(self, *binop.arg_1, vars);
-	Value v2 = eval(self, *binop.arg_2, vars);
-	return OP{}(v1.getBool(), v2.getBool()) ? 1L : 0L;
+static bool logical(const Value& v1, const Value& v2){
+	return OP{}(v1.getBool(), v2.getBool());
 }
 
 
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
-static bool equals(const Expression& self, const BinaryOperation& binop, const VariableMap& vars){
-	assert(binop.arg_1 != nullptr && binop.arg_2 != nullptr);
-	Value v1 = eval(self, *binop.arg_1, vars);
-	Value v2 = eval(self, *binop.arg_2, vars);
+static bool equals(const Value& v1, const Value& v2){
 	
 	if (v1.type == Type::LONG){
 		if (v2.type == Type::LONG)
@@ -637,7 +634,7 @@ static bool equals(const Expression& self, const BinaryOperation& binop, const V
 		else if (v2.type == Type::DOUBLE)
 			return v1.data.l == v2.data.d;
 		else if (v2.type == Type::STRING)
-			return to_string(v1.data.l) == v2.data.s->sv();
+			return to_string(v1.data.l) == v2.sv();
 		else if (v2.type == Type::OBJECT)
 			return v2.data.o->arr.size() == size_t(v1.data.l);
 	}
@@ -648,18 +645,18 @@ static bool equals(const Expression& self, const BinaryOperation& binop, const V
 		else if (v2.type == Type::DOUBLE)
 			return v1.data.d == v2.data.d;
 		else if (v2.type == Type::STRING)
-			return to_string(v1.data.d) == v2.data.s->sv();
+			return to_string(v1.data.d) == v2.sv();
 		else if (v2.type == Type::OBJECT)
 			return v2.data.o->arr.size() == v1.data.d;
 	}
 	
 	else if (v1.type == Type::STRING){
 		if (v2.type == Type::LONG)
-			return v1.data.s->sv() == to_string(v2.data.l);
+			return v1.sv() == to_string(v2.data.l);
 		else if (v2.type == Type::DOUBLE)
-			return v1.data.s->sv() == to_string(v2.data.d);
+			return v1.sv() == to_string(v2.data.d);
 		else if (v2.type == Type::STRING)
-			return v1.data.s->sv() == v2.data.s->sv();
+			return v1.sv() == v2.sv();
 	}
 	
 	else if (v1.type == Type::OBJECT){
@@ -676,10 +673,7 @@ static bool equals(const Expression& self, const BinaryOperation& binop, const V
 
 
 template<typename OP>
-static bool cmp(const Expression& self, const BinaryOperation& binop, const VariableMap& vars){
-	assert(binop.arg_1 != nullptr && binop.arg_2 != nullptr);
-	Value v1 = eval(self, *binop.arg_1, vars);
-	Value v2 = eval(self, *binop.arg_2, vars);
+static bool cmp(const Value& v1, const Value& v2){
 	OP op = {};
 	
 	if (v1.type == Type::LONG){
@@ -688,7 +682,7 @@ static bool cmp(const Expression& self, const BinaryOperation& binop, const Vari
 		else if (v2.type == Type::DOUBLE)
 			return op(v1.data.l, v2.data.d);
 		else if (v2.type == Type::STRING)
-			return op(v1.data.l, v2.data.s->len);
+			return op(v1.data.l, v2.sv().length());
 		else if (v2.type == Type::OBJECT)
 			return op(v1.data.l, v2.data.o->arr.size());
 	}
@@ -699,18 +693,18 @@ static bool cmp(const Expression& self, const BinaryOperation& binop, const Vari
 		else if (v2.type == Type::DOUBLE)
 			return op(v1.data.d, v2.data.d);
 		else if (v2.type == Type::STRING)
-			return op(v1.data.d, v2.data.s->len);
+			return op(v1.data.d, v2.sv().length());
 		else if (v2.type == Type::OBJECT)
 			return op(v1.data.d, v2.data.o->arr.size());
 	}
 	
 	else if (v1.type == Type::STRING){
 		if (v2.type == Type::LONG)
-			return op(v1.data.s->len, v2.data.l);
+			return op(v1.sv().length(), v2.data.l);
 		else if (v2.type == Type::DOUBLE)
-			return op(v1.data.s->len, v2.data.d);
+			return op(v1.sv().length(), v2.data.d);
 		else if (v2.type == Type::STRING)
-			return op(v1.data.s->sv(), v2.data.s->sv());
+			return op(v1.sv(), v2.sv());
 	}
 	
 	else if (v1.type == Type::OBJECT){
@@ -729,6 +723,46 @@ static bool cmp(const Expression& self, const BinaryOperation& binop, const Vari
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
+template<void(*OP)(Value&, Value)>
+static Value arithmetic(const Expression& self, const BinaryOperation& binop, const VariableMap& vars){
+	assert(binop.arg_1 != nullptr && binop.arg_2 != nullptr);
+	Value v1 = eval(self, *binop.arg_1, vars);
+	Value v2 = eval(self, *binop.arg_2, vars);
+	OP(v1, move(v2));
+	return v1;
+}
+
+
+/**
+ * @brief Same as `arithmetic()`, but undefined integer division evaluates to `null`.
+ */
+template<void(*OP)(Value&, Value)>
+static Value division(const Expression& self, const BinaryOperation& binop, const VariableMap& vars){
+	assert(binop.arg_1 != nullptr && binop.arg_2 != nullptr);
+	Value v1 = eval(self, *binop.arg_1, vars);
+	Value v2 = eval(self, *binop.arg_2, vars);
+	if (!divisible(self, binop, v1, v2)){
+		return Value();
+	}
+	OP(v1, move(v2));
+	return v1;
+}
+
+
+template<bool(*OP)(const Value&, const Value&)>
+static Value compare(const Expression& self, const BinaryOperation& binop, const VariableMap& vars){
+	assert(binop.arg_1 != nullptr && binop.arg_2 != nullptr);
+	Value v1 = eval(self, *binop.arg_1, vars);
+	Value v2 = eval(self, *binop.arg_2, vars);
+	return OP(v1, v2) ? 1L : 0L;
+}
+
+
+static bool not_equals(const Value& v1, const Value& v2){
+	return !equals(v1, v2);
+}
+
+
 Value eval(const Expression& self, const Operation& op, const VariableMap& vars){
 	switch (op.type){
 		case Operation::Type::LONG:
@@ -741,38 +775,50 @@ Value eval(const Expression& self, const Operation& op, const VariableMap& vars)
 			return object(self, static_cast<const Object&>(op), vars);
 		case Operation::Type::VAR:
 			return var(self, static_cast<const Variable&>(op), vars);
+		
 		case Operation::Type::NOT:
-			return nott(self, static_cast<const UnaryOperation&>(op), vars);
-		case Operation::Type::NEG:
-			return neg(self, static_cast<const UnaryOperation&>(op), vars);
+		case Operation::Type::NEG: {
+			const UnaryOperation& unop = static_cast<const UnaryOperation&>(op);
+			assert(unop.arg != nullptr);
+			Value val = eval(self, *unop.arg, vars);
+			(op.type == Operation::Type::NOT) ? nott(val) : neg(val);
+			return val;
+		}
+		
 		case Operation::Type::ADD:
-			return add(self, static_cast<const BinaryOperation&>(op), vars);
+			return arithmetic<add>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::SUB:
-			return sub(self, static_cast<const BinaryOperation&>(op), vars);
+			return arithmetic<sub>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::MUL:
-			return mul(self, static_cast<const BinaryOperation&>(op), vars);
+			return arithmetic<mul>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::DIV:
-			return div(self, static_cast<const BinaryOperation&>(op), vars);
+			return division<div>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::MOD:
-			return mod(self, static_cast<const BinaryOperation&>(op), vars);
+			return division<mod>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::AND:
-			return logical<logical_and<>>(self, static_cast<const BinaryOperation&>(op), vars);
+			return compare<logical<logical_and<>>>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::OR:
-			return logical<logical_or<>>(self, static_cast<const BinaryOperation&>(op), vars);
+			return compare<logical<logical_or<>>>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::EQ:
-			return equals(self, static_cast<const BinaryOperation&>(op), vars) ? 1L : 0L;
+			return compare<equals>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::NEQ:
-			return equals(self, static_cast<const BinaryOperation&>(op), vars) ? 0L : 1L;
+			return compare<not_equals>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::LT:
-			return cmp<less<>>(self, static_cast<const BinaryOperation&>(op), vars) ? 1L : 0L;
+			return compare<cmp<less<>>>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::LTE:
-			return cmp<less_equal<>>(self, static_cast<const BinaryOperation&>(op), vars) ? 1L : 0L;
+			return compare<cmp<less_equal<>>>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::GT:
-			return cmp<greater<>>(self, static_cast<const BinaryOperation&>(op), vars) ? 1L : 0L;
+			return compare<cmp<greater<>>>(self, static_cast<const BinaryOperation&>(op), vars);
 		case Operation::Type::GTE:
-			return cmp<greater_equal<>>(self, static_cast<const BinaryOperation&>(op), vars) ? 1L : 0L;
-		case Operation::Type::INDEX:
-			return index(self, static_cast<const Index&>(op), vars);
+			return compare<cmp<greater_equal<>>>(self, static_cast<const BinaryOperation&>(op), vars);
+		
+		case Operation::Type::INDEX: {
+			const Index& idx = static_cast<const Index&>(op);
+			Value obj = eval(self, *idx.obj, vars);
+			Value i = eval(self, *idx.index, vars);
+			return index(self, idx, obj, i);
+		}
+		
 		case Operation::Type::FUNC:
 			return eval(self, static_cast<const Function&>(op), vars);
 		case Operation::Type::ERROR:
@@ -786,7 +832,231 @@ Value eval(const Expression& self, const Operation& op, const VariableMap& vars)
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
+/**
+ * @brief Value stack of the bytecode interpreter.
+ *        Small stacks live in the C stack frame, deeper ones on the heap.
+ */
+class ValueStack {
+private:
+	static constexpr uint32_t LOCAL = 16;
+	alignas(Value) std::byte local[LOCAL * sizeof(Value)];
+	unique_ptr<std::byte[]> heap;
+	
+public:
+	Value* const base;
+	Value* sp;
+	
+public:
+	ValueStack(uint32_t depth) : base{stack(depth)}, sp{base} {}
+	
+	~ValueStack(){
+		while (sp != base)
+			(--sp)->~Value();
+	}
+	
+private:
+	Value* stack(uint32_t depth){
+		if (depth <= LOCAL)
+			return reinterpret_cast<Value*>(local);
+		heap = make_unique<std::byte[]>(depth * sizeof(Value));
+		return reinterpret_cast<Value*>(heap.get());
+	}
+	
+};
+
+
+// Fast path for operations on two numbers of the same type.
+#define NUMERIC_FAST_PATH(a, b, expr_l, expr_d)                            \
+	if (a.type == b.type){                                                 \
+		if (a.type == Type::LONG){ expr_l; sp--; continue; }             \
+		else if (a.type == Type::DOUBLE){ expr_d; sp--; continue; }      \
+	}
+
+
+/**
+ * @brief Execute bytecode of the expression.
+ * @param acc Value pushed instead of executing the first instruction, which must be a `VAR`.
+ */
+static Value run(const Expression& self, const Expression::Program& prog, const VariableMap& vars, Value* acc = nullptr){
+	using Code = Expression::Instruction::Code;
+	ValueStack stack = ValueStack(prog.depth);
+	Value*& sp = stack.sp;
+	
+	const Expression::Instruction* ip = prog.code;
+	const Expression::Instruction* const end = prog.code + prog.len;
+	
+	if (acc != nullptr){
+		assert(prog.len > 0 && ip->code == Code::VAR);
+		new (sp++) Value(move(*acc));
+		ip++;
+	}
+	
+	for ( ; ip != end ; ip++){
+		// Operations which push a value or modify the top value
+		switch (ip->code){
+			case Code::LONG:
+				new (sp++) Value(ip->l);
+				continue;
+			case Code::DOUBLE:
+				new (sp++) Value(ip->d);
+				continue;
+			case Code::STRING:
+				new (sp++) Value(static_cast<const String*>(ip->op)->str());
+				continue;
+			case Code::VAR:
+				new (sp++) Value(var(self, *static_cast<const Variable*>(ip->op), vars));
+				continue;
+			case Code::FUNC: {
+				const Function& f = *static_cast<const Function*>(ip->op);
+				new (sp++) Value(f.info->fn(self, f, vars));
+				continue;
+			}
+			
+			case Code::OBJECT:
+				new (sp++) Value(Value::Object::create().release());
+				continue;
+			
+			case Code::NOT:
+				nott(sp[-1]);
+				continue;
+			case Code::NEG:
+				neg(sp[-1]);
+				continue;
+			
+			default:
+				break;
+		}
+		
+		// Binary operations, the stack holds at least two operands.
+		assert(sp - stack.base >= 2);
+		Value& a = sp[-2];
+		Value& b = sp[-1];
+		
+		switch (ip->code){
+			case Code::APPEND:
+				a.data.o->arr.emplace_back(move(b));
+				break;
+			case Code::INSERT:
+				object_insert(self, *sp[-3].data.o, *ip->op, move(a), move(b));
+				(--sp)->~Value();
+				break;
+			
+			case Code::ADD:
+				NUMERIC_FAST_PATH(a, b, a.data.l += b.data.l, a.data.d += b.data.d);
+				add(a, move(b));
+				break;
+			case Code::SUB:
+				NUMERIC_FAST_PATH(a, b, a.data.l -= b.data.l, a.data.d -= b.data.d);
+				sub(a, move(b));
+				break;
+			case Code::MUL:
+				NUMERIC_FAST_PATH(a, b, a.data.l *= b.data.l, a.data.d *= b.data.d);
+				mul(a, move(b));
+				break;
+			case Code::DIV:
+				if (!divisible(self, *ip->op, a, b)){
+					a = Value();
+					break;
+				}
+				NUMERIC_FAST_PATH(a, b, a.data.l /= b.data.l, a.data.d /= b.data.d);
+				div(a, move(b));
+				break;
+			case Code::MOD:
+				if (!divisible(self, *ip->op, a, b)){
+					a = Value();
+					break;
+				}
+				if (a.type == Type::LONG && b.type == Type::LONG){
+					a.data.l %= b.data.l;
+					sp--;
+					continue;
+				}
+				mod(a, move(b));
+				break;
+			
+			case Code::AND:
+				a = logical<logical_and<>>(a, b) ? 1L : 0L;
+				break;
+			case Code::OR:
+				a = logical<logical_or<>>(a, b) ? 1L : 0L;
+				break;
+			
+			case Code::EQ:
+				NUMERIC_FAST_PATH(a, b, a.data.l = (a.data.l == b.data.l), a = (a.data.d == b.data.d) ? 1L : 0L);
+				a = equals(a, b) ? 1L : 0L;
+				break;
+			case Code::NEQ:
+				NUMERIC_FAST_PATH(a, b, a.data.l = (a.data.l != b.data.l), a = (a.data.d != b.data.d) ? 1L : 0L);
+				a = equals(a, b) ? 0L : 1L;
+				break;
+			case Code::LT:
+				NUMERIC_FAST_PATH(a, b, a.data.l = (a.data.l < b.data.l), a = (a.data.d < b.data.d) ? 1L : 0L);
+				a = cmp<less<>>(a, b) ? 1L : 0L;
+				break;
+			case Code::LTE:
+				NUMERIC_FAST_PATH(a, b, a.data.l = (a.data.l <= b.data.l), a = (a.data.d <= b.data.d) ? 1L : 0L);
+				a = cmp<less_equal<>>(a, b) ? 1L : 0L;
+				break;
+			case Code::GT:
+				NUMERIC_FAST_PATH(a, b, a.data.l = (a.data.l > b.data.l), a = (a.data.d > b.data.d) ? 1L : 0L);
+				a = cmp<greater<>>(a, b) ? 1L : 0L;
+				break;
+			case Code::GTE:
+				NUMERIC_FAST_PATH(a, b, a.data.l = (a.data.l >= b.data.l), a = (a.data.d >= b.data.d) ? 1L : 0L);
+				a = cmp<greater_equal<>>(a, b) ? 1L : 0L;
+				break;
+			
+			case Code::INDEX:
+				a = index(self, *static_cast<const Index*>(ip->op), a, b);
+				break;
+			
+			default:
+				assert(false);
+				break;
+		}
+		
+		// Pop second operand
+		(--sp)->~Value();
+	}
+	
+	assert(sp == stack.base + 1);
+	Value res = move(stack.base[0]);
+	return res;
+}
+
+#undef NUMERIC_FAST_PATH
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
 Value Expression::eval(const VariableMap& vars) const noexcept {
+	if (constant){
+		return value;
+	} else if (program == nullptr){
+		assert(program != nullptr);
+		return Value();
+	}
+	return run(*this, *program, vars);
+}
+
+
+Value Expression::evalAssign(VariableMap& vars, Symbol target) const noexcept {
+	if (accumulator == Symbols::NONE || accumulator != target){
+		return eval(vars);
+	}
+	
+	Value* acc = vars.get(target);
+	if (acc == nullptr){
+		return eval(vars);
+	}
+	
+	assert(program != nullptr);
+	return run(*this, *program, vars, acc);
+}
+
+
+Value Expression::evalTree(const VariableMap& vars) const noexcept {
 	if (op == nullptr){
 		assert(op != nullptr);
 		return Value();
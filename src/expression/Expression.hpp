@@ -1,10 +1,8 @@
 #pragma once
+#include <cassert>
 #include "Value.hpp"
 #include "Macro.hpp"
-#include "str_map.hpp"
-
-
-using VariableMap = str_map<Value>;
+#include "VariableMap.hpp"
 
 
 class Expression {
@@ -12,15 +10,21 @@ class Expression {
 public:
 	struct Allocator;
 	struct Operation;
+	struct Instruction;
+	struct Program;
 	enum class Status;
 	
 // ------------------------------------[ Properties ] --------------------------------------- //
 private:
 	Allocator* alloc = nullptr;
 	Operation* op = nullptr;
+	Program* program = nullptr;		// Bytecode compiled from `op`.
+	Value value;					// Result of a constant expression.
+	bool constant = false;			// Expression folded into a literal and is evaluated only once into `value`.
+	Symbol accumulator = Symbols::NONE;	// Variable read once, as the leftmost operand of a `+` chain.
 	
 public:
-	std::shared_ptr<Macro> origin;
+	const Macro* origin = nullptr;	// Source of the expression text, used for reporting errors.
 	
 // ---------------------------------- [ Constructors ] -------------------------------------- //
 public:
@@ -35,10 +39,28 @@ public:
 	
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 public:
+	/**
+	 * @brief Evaluate compiled bytecode of the expression.
+	 *        Constant expressions return a copy of the precomputed value.
+	 */
 	Value eval(const VariableMap& vars) const noexcept;
 	
+	/**
+	 * @brief Evaluate by recursively walking the operation tree.
+	 *        Reference implementation of `eval()`, used for testing and benchmarking.
+	 */
+	Value evalTree(const VariableMap& vars) const noexcept;
+	
+	/**
+	 * @brief Evaluate expression whose result is assigned to variable `target`.
+	 *        If the expression appends to `target` (`x = x + ...`), the variable is moved into
+	 *        the evaluation instead of being copied, allowing strings to be appended in place.
+	 * @note `target` is left undefined until the result is assigned back to it.
+	 */
+	Value evalAssign(VariableMap& vars, Symbol target) const noexcept;
+	
 public:
-	static Expression parse(std::string_view str, const std::shared_ptr<Macro>& origin) noexcept;
+	static Expression parse(std::string_view str, const Macro* origin) noexcept;
 	std::string serialize() const; 
 	
 // ----------------------------------- [ Operators ] ---------------------------------------- //
@@ -47,6 +69,19 @@ public:
 		return op != nullptr;
 	}
 	
+	/**
+	 * @brief Check if the expression doesn't depend on any variables.
+	 *        Such expressions need not be evaluated, use `constantValue()` instead.
+	 */
+	bool isConstant() const noexcept {
+		return constant;
+	}
+	
+	const Value& constantValue() const noexcept {
+		assert(constant);
+		return value;
+	}
+	
 	Expression& operator=(Expression&& o){
 		swap(*this, o);
 		return *this;
@@ -57,6 +92,10 @@ public:
 	friend void swap(Expression& a, Expression& b) noexcept {
 		std::swap(a.alloc, b.alloc);
 		std::swap(a.op, b.op);
+		std::swap(a.program, b.program);
+		std::swap(a.value, b.value);
+		std::swap(a.constant, b.constant);
+		std::swap(a.accumulator, b.accumulator);
 		std::swap(a.origin, b.origin);
 	}
 	
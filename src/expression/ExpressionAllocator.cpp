@@ -1,23 +1,136 @@
 #include "ExpressionAllocator.hpp"
 #include <cassert>
+#include <bit>
 
 using namespace std;
 using Allocator = Expression::Allocator;
 using Page = Expression::Allocator::Page;
 
 
+// ----------------------------------- [ Structures ] --------------------------------------- //
+
+
+/**
+ * @brief Free pages of expression arenas, sorted by capacity.
+ *        Page capacities are powers of 2 so each class holds interchangeable pages.
+ * @note Trivially destructible, so it remains usable by expressions destroyed after
+ *       the thread local destructors, e.g. those held by static caches.
+ *       Once `release()` is called, pages and allocators are returned to the system.
+ */
+struct PagePool {
+	static constexpr int MIN_CLASS = countr_zero(Allocator::MIN_CAPACITY);
+	static constexpr int CLASSES = countr_zero(Allocator::MAX_POOLED_CAPACITY) - MIN_CLASS + 1;
+	
+	Page* pages[CLASSES] = {};
+	size_t size = 0;				// Total capacity of pooled pages in bytes.
+	void* allocators = nullptr;		// Linked list of free `Allocator` objects.
+	bool closed = false;
+	
+	static int index(size_t capacity) noexcept {
+		return countr_zero(capacity) - MIN_CLASS;
+	}
+	
+	Page* take(size_t capacity) noexcept {
+		if (capacity > Allocator::MAX_POOLED_CAPACITY){
+			return nullptr;
+		}
+		
+		Page*& head = pages[index(capacity)];
+		Page* p = head;
+		if (p != nullptr){
+			head = p->next;
+			size -= capacity;
+		}
+		return p;
+	}
+	
+	bool put(Page* p) noexcept {
+		if (closed || p->capacity > Allocator::MAX_POOLED_CAPACITY || size + p->capacity > Allocator::POOL_CAPACITY){
+			return false;
+		}
+		
+		Page*& head = pages[index(p->capacity)];
+		p->next = head;
+		p->size = 0;
+		head = p;
+		size += p->capacity;
+		return true;
+	}
+	
+	void release() noexcept {
+		closed = true;
+		
+		for (Page*& head : pages){
+			while (head != nullptr){
+				Page* next = head->next;
+				::operator delete(head, align_val_t(alignof(Page)));
+				head = next;
+			}
+		}
+		size = 0;
+		
+		while (allocators != nullptr){
+			void* next = *static_cast<void**>(allocators);
+			::operator delete(allocators);
+			allocators = next;
+		}
+	}
+
+};
+
+
+struct PagePoolRelease {
+	~PagePoolRelease();
+};
+
+
+static constinit thread_local PagePool pool;
+static thread_local PagePoolRelease poolRelease;
+
+
+PagePoolRelease::~PagePoolRelease(){
+	pool.release();
+}
+
+
 // ---------------------------------- [ Constructors ] -------------------------------------- //
 
 
 Allocator::~Allocator(){
 	Page* p = this->page;
+	(void)poolRelease;	// Schedules release of the pool at thread exit.
 	
 	while (p != nullptr){
 		auto* next = p->next;
-		delete p;
+		if (!pool.put(p)){
+			::operator delete(p, align_val_t(alignof(Page)));
+		}
 		p = next;
 	}
+
+}
+
+
+void* Allocator::operator new(size_t size){
+	assert(size == sizeof(Allocator));
 	
+	if (pool.allocators != nullptr){
+		void* p = pool.allocators;
+		pool.allocators = *static_cast<void**>(p);
+		return p;
+	}
+	
+	return ::operator new(size);
+}
+
+
+void Allocator::operator delete(void* p) noexcept {
+	if (pool.closed){
+		::operator delete(p);
+	} else if (p != nullptr){
+		*static_cast<void**>(p) = pool.allocators;
+		pool.allocators = p;
+	}
 }
 
 
@@ -25,11 +138,14 @@ Allocator::~Allocator(){
 
 
 static Page* newPage(Page* prev, size_t minCapacity) noexcept {
-	size_t capacity;
+	size_t capacity = bit_ceil(max(minCapacity, Allocator::MIN_CAPACITY));
 	if (prev != nullptr){
-		capacity = max(prev->capacity * 2, minCapacity);
-	} else {
-		capacity = Allocator::MIN_CAPACITY;
+		capacity = max(prev->capacity * 2, capacity);
+	}
+	
+	Page* page = pool.take(capacity);
+	if (page != nullptr){
+		return page;
 	}
 	
 	assert(capacity > 0);
@@ -38,7 +154,7 @@ static Page* newPage(Page* prev, size_t minCapacity) noexcept {
 		return nullptr;
 	}
 	
-	Page* page = new (mem) Page();
+	page = new (mem) Page();
 	page->capacity = capacity;
 	return page;
 }
@@ -65,4 +181,4 @@ void* Allocator::alloc(size_t size){
 }
 
 
-// ------------------------------------------------------------------------------------------ //
\ No newline at end of file
+// ------------------------------------------------------------------------------------------ //
@@ -1,6 +1,7 @@
 #pragma once
 #include <cstdint>
 #include "ExpressionOperation.hpp"
+#include "ExpressionBytecode.hpp"
 
 
 template<typename A, typename ...T>
@@ -16,6 +17,8 @@ consteval size_t maxAlign(){
 
 /**
  * @brief Arena allocator for all expression operation structs.
+ *        Pages are recycled through a thread local pool, so temporary expressions
+ *        stop calling the system allocator once the pool is warm.
  */
 struct Expression::Allocator {
 // ----------------------------------- [ Constants ] ---------------------------------------- //
@@ -23,9 +26,12 @@ public:
 	static constexpr size_t UNIT = maxAlign<
 		Operation,Variable,Long,Double,String,Object,Object::Entry,
 		UnaryOperation,BinaryOperation,
-		Index,Function
+		Index,Function,
+		Program,Instruction
 	>();
 	static constexpr size_t MIN_CAPACITY = 128 * sizeof(std::byte);
+	static constexpr size_t MAX_POOLED_CAPACITY = 64 * 1024;	// Larger pages are returned to the system.
+	static constexpr size_t POOL_CAPACITY = 1024 * 1024;		// Maximum bytes of free pages kept per thread.
 
 // ----------------------------------- [ Structures ] --------------------------------------- //
 public:
@@ -49,6 +55,9 @@ public:
 	
 	~Allocator();
 	
+	static void* operator new(size_t size);
+	static void operator delete(void* p) noexcept;
+	
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 public:
 	void* alloc(size_t size);
@@ -0,0 +1,43 @@
+#pragma once
+#include "ExpressionOperation.hpp"
+
+
+// ----------------------------------- [ Structures ] --------------------------------------- //
+
+
+/**
+ * @brief Single instruction of the expression stack machine.
+ *        Operands are popped from the value stack and the result is pushed back.
+ *        Instructions are laid out in post-order of the operation tree.
+ */
+struct Expression::Instruction {
+	enum class Code : uint32_t {
+		LONG, DOUBLE, STRING, VAR,
+		OBJECT, APPEND, INSERT,
+		NOT, NEG,
+		ADD, SUB, MUL, DIV, MOD,
+		AND, OR,
+		EQ, NEQ, LT, LTE, GT, GTE,
+		INDEX, FUNC,
+	} code;
+	
+	union {
+		long l;					// `Code::LONG`
+		double d;				// `Code::DOUBLE`
+		const Operation* op;	// Source operation of the instruction.
+	};
+
+};
+
+
+/**
+ * @brief Compiled bytecode of an expression, allocated in the expression arena.
+ */
+struct Expression::Program {
+	uint32_t len;			// Number of instructions in `code`.
+	uint32_t depth;			// Maximum depth of the value stack.
+	Instruction code[];
+};
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -0,0 +1,65 @@
+#include "ExpressionCache.hpp"
+#include "Stats.hpp"
+
+using namespace std;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+template<typename T>
+static const T& get(auto& map, string_view str, const Macro* origin, CacheStats& stats){
+	auto [it, inserted] = map.try_emplace({ str.data(), str.length() });
+	
+	if (!inserted){
+		stats.hits++;
+		return it->second;
+	}
+	
+	// Entries are never replaced, so returned references stay valid.
+	stats.misses++;
+	it->second = T::parse(str, origin);
+	return it->second;
+}
+
+
+const Expression& ExpressionCache::expression(string_view str){
+	return get<Expression>(expressions, str, origin, Stats::expressions);
+}
+
+
+const Interpolation& ExpressionCache::interpolation(string_view str){
+	return get<Interpolation>(interpolations, str, origin, Stats::interpolations);
+}
+
+
+Symbol ExpressionCache::symbol(string_view name){
+	assert(!name.empty());
+	auto [it, inserted] = symbols.try_emplace({ name.data(), name.length() });
+	
+	if (inserted){
+		it->second = Symbols::intern(name);
+	}
+	return it->second;
+}
+
+
+const shared_ptr<Macro>* ExpressionCache::macro(string_view name){
+	assert(!name.empty());
+	auto [it, inserted] = calls.try_emplace({ name.data(), name.length() });
+	CallSite& c = it->second;
+	const uint64_t generation = MacroCache::generation();
+	
+	if (!inserted && c.generation == generation){
+		Stats::calls.hits++;
+		return c.macro;
+	}
+	
+	Stats::calls.misses++;
+	c.generation = generation;
+	c.macro = MacroCache::find(name);
+	return c.macro;
+}
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -0,0 +1,84 @@
+#pragma once
+#include <unordered_map>
+#include "Expression.hpp"
+#include "Interpolation.hpp"
+
+
+/**
+ * @brief Parsed expressions, interpolations, variable names and called macros of a single macro, keyed by the address and length of their source text.
+ *        The source text is owned by the macro and never changes, so each
+ *        attribute, text node or interpolated expression is parsed at most once.
+ *        Failed parses are cached as well, reporting the error only once.
+ */
+class ExpressionCache {
+// ----------------------------------- [ Structures ] --------------------------------------- //
+private:
+	/**
+	 * @brief Source text identified by its address, texts with the same start but different lengths are separate entries.
+	 */
+	struct Key {
+		const char* str;
+		size_t len;
+		
+		bool operator==(const Key&) const = default;
+	};
+	
+	struct KeyHash {
+		size_t operator()(const Key& k) const noexcept {
+			return std::hash<const char*>()(k.str) ^ (k.len * 0x9E3779B97F4A7C15);
+		}
+	};
+	
+	template<typename T>
+	using Map = std::unordered_map<Key,T,KeyHash>;
+	
+	struct CallSite {
+		uint64_t generation = 0;					// `MacroCache::generation()` when `macro` was found.
+		const std::shared_ptr<Macro>* macro = nullptr;
+	};
+
+// ------------------------------------[ Properties ] --------------------------------------- //
+private:
+	const Macro* origin;
+	Map<Expression> expressions;
+	Map<Interpolation> interpolations;
+	Map<Symbol> symbols;
+	Map<CallSite> calls;
+
+// ---------------------------------- [ Constructors ] -------------------------------------- //
+public:
+	ExpressionCache(const Macro* origin) : origin{origin} {}
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	/**
+	 * @brief Get parsed expression or parse and cache a new one.
+	 * @param str Expression source text. Must point into the text of the cache's macro.
+	 * @return Reference to the cached expression, valid for the lifetime of the cache.
+	 *         Empty expression if parsing failed.
+	 */
+	const Expression& expression(std::string_view str);
+	
+	/**
+	 * @brief Get parsed interpolation or parse and cache a new one.
+	 * @param str Interpolated source text. Must point into the text of the cache's macro.
+	 * @return Reference to the cached interpolation, valid for the lifetime of the cache.
+	 */
+	const Interpolation& interpolation(std::string_view str);
+	
+	/**
+	 * @brief Get interned symbol of a variable name, hashing the name only on first use.
+	 * @param name Variable name. Must point into the text of the cache's macro.
+	 */
+	Symbol symbol(std::string_view name);
+	
+	/**
+	 * @brief Get user macro called by name. `MacroCache` is searched again only after named macros change.
+	 * @param name Macro name. Must point into the text of the cache's macro.
+	 * @return Handle from `MacroCache::find()`, valid until the next change of named macros.
+	 *         `nullptr` if the macro does not exist.
+	 */
+	const std::shared_ptr<Macro>* macro(std::string_view name);
+
+// ------------------------------------------------------------------------------------------ //
+};
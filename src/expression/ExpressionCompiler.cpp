@@ -0,0 +1,206 @@
+#include "Expression.hpp"
+#include "ExpressionAllocator.hpp"
+#include "ExpressionBytecode.hpp"
+#include <cassert>
+
+using namespace std;
+using Operation = Expression::Operation;
+using Instruction = Expression::Instruction;
+using Program = Expression::Program;
+using Code = Expression::Instruction::Code;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+/**
+ * @brief Count instructions needed for the operation tree.
+ */
+static uint32_t count(const Operation& op){
+	switch (op.type){
+		case Operation::Type::LONG:
+		case Operation::Type::DOUBLE:
+		case Operation::Type::STRING:
+		case Operation::Type::VAR:
+		case Operation::Type::FUNC:
+			return 1;
+		
+		case Operation::Type::OBJECT: {
+			const Object& obj = static_cast<const Object&>(op);
+			uint32_t n = 1;
+			for (uint32_t i = 0 ; i < obj.count ; i++){
+				const Object::Entry& e = obj.elements[i];
+				if (e.key != nullptr)
+					n += count(*e.key);
+				n += count(*e.value) + 1;
+			}
+			return n;
+		}
+		
+		case Operation::Type::NOT:
+		case Operation::Type::NEG:
+			return count(*static_cast<const UnaryOperation&>(op).arg) + 1;
+		
+		case Operation::Type::INDEX: {
+			const Index& idx = static_cast<const Index&>(op);
+			return count(*idx.obj) + count(*idx.index) + 1;
+		}
+		
+		case Operation::Type::ERROR:
+			assert(false);
+			return 0;
+		
+		default: {
+			const BinaryOperation& binop = static_cast<const BinaryOperation&>(op);
+			return count(*binop.arg_1) + count(*binop.arg_2) + 1;
+		}
+	
+	}
+}
+
+
+static Code binaryCode(Operation::Type type){
+	switch (type){
+		case Operation::Type::ADD: return Code::ADD;
+		case Operation::Type::SUB: return Code::SUB;
+		case Operation::Type::MUL: return Code::MUL;
+		case Operation::Type::DIV: return Code::DIV;
+		case Operation::Type::MOD: return Code::MOD;
+		case Operation::Type::AND: return Code::AND;
+		case Operation::Type::OR:  return Code::OR;
+		case Operation::Type::EQ:  return Code::EQ;
+		case Operation::Type::NEQ: return Code::NEQ;
+		case Operation::Type::LT:  return Code::LT;
+		case Operation::Type::LTE: return Code::LTE;
+		case Operation::Type::GT:  return Code::GT;
+		case Operation::Type::GTE: return Code::GTE;
+		default:
+			assert(false);
+			return Code::ADD;
+	}
+}
+
+
+/**
+ * @brief Emit instructions of the operation tree in post-order.
+ * @param op Operation to compile.
+ * @param out Output instruction, advanced past the last emitted instruction.
+ * @return Stack depth needed to evaluate `op`.
+ */
+static uint32_t emit(const Operation& op, Instruction*& out){
+	Instruction& ins = *out;
+	
+	switch (op.type){
+		case Operation::Type::LONG:
+			ins.code = Code::LONG;
+			ins.l = static_cast<const Long&>(op).n;
+			out++;
+			return 1;
+		
+		case Operation::Type::DOUBLE:
+			ins.code = Code::DOUBLE;
+			ins.d = static_cast<const Double&>(op).n;
+			out++;
+			return 1;
+		
+		case Operation::Type::STRING:
+			ins.code = Code::STRING;
+			ins.op = &op;
+			out++;
+			return 1;
+		
+		case Operation::Type::VAR:
+			ins.code = Code::VAR;
+			ins.op = &op;
+			out++;
+			return 1;
+		
+		case Operation::Type::FUNC:
+			ins.code = Code::FUNC;
+			ins.op = &op;
+			out++;
+			return 1;
+		
+		case Operation::Type::OBJECT: {
+			const Object& obj = static_cast<const Object&>(op);
+			ins.code = Code::OBJECT;
+			ins.op = &op;
+			out++;
+			
+			uint32_t depth = 1;
+			for (uint32_t i = 0 ; i < obj.count ; i++){
+				const Object::Entry& e = obj.elements[i];
+				
+				if (e.key == nullptr){
+					depth = max(depth, 1 + emit(*e.value, out));
+					out->code = Code::APPEND;
+					out->op = e.value;
+				} else {
+					depth = max(depth, 1 + emit(*e.key, out));
+					depth = max(depth, 2 + emit(*e.value, out));
+					out->code = Code::INSERT;
+					out->op = e.key;
+				}
+				
+				out++;
+			}
+			
+			return depth;
+		}
+		
+		case Operation::Type::NOT:
+		case Operation::Type::NEG: {
+			uint32_t depth = emit(*static_cast<const UnaryOperation&>(op).arg, out);
+			out->code = (op.type == Operation::Type::NOT) ? Code::NOT : Code::NEG;
+			out->op = &op;
+			out++;
+			return depth;
+		}
+		
+		case Operation::Type::INDEX: {
+			const Index& idx = static_cast<const Index&>(op);
+			uint32_t depth = emit(*idx.obj, out);
+			depth = max(depth, 1 + emit(*idx.index, out));
+			out->code = Code::INDEX;
+			out->op = &op;
+			out++;
+			return depth;
+		}
+		
+		case Operation::Type::ERROR:
+			assert(false);
+			return 0;
+		
+		default: {
+			const BinaryOperation& binop = static_cast<const BinaryOperation&>(op);
+			uint32_t depth = emit(*binop.arg_1, out);
+			depth = max(depth, 1 + emit(*binop.arg_2, out));
+			out->code = binaryCode(op.type);
+			out->op = &op;
+			out++;
+			return depth;
+		}
+	
+	}
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+Program* compile(const Operation& op, Expression::Allocator& alloc){
+	const uint32_t len = count(op);
+	void* mem = alloc.alloc(sizeof(Program) + sizeof(Instruction) * len);
+	
+	Program* prog = new (mem) Program();
+	prog->len = len;
+	
+	Instruction* out = prog->code;
+	prog->depth = emit(op, out);
+	assert(out == prog->code + len);
+	
+	return prog;
+}
+
+
+// ------------------------------------------------------------------------------------------ //
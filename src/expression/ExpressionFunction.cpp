@@ -1,8 +1,8 @@
 #include "ExpressionOperation.hpp"
 #include <cmath>
 #include <algorithm>
-#include <regex>
 
+#include "Regex.hpp"
 #include "Debug.hpp"
 #include "DebugSource.hpp"
 
@@ -21,49 +21,6 @@ Value eval(const Expression& self, const Function& op, const VariableMap& vars);
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
-static void error_undefined_function(const Expression& self, const Function& func){
-	if (self.origin == nullptr){
-		return;
-	}
-	
-	string_view mark = func.name();
-	linepos pos = findLine(*self.origin, mark.begin());
-	
-	print(pos);
-	LOG_STDERR(ERROR_PFX "Undefined function: " PURPLE("'%.*s()'") "\n", VA_STRV(func.name()));
-	printCodeView(pos, mark, ANSI_RED);
-}
-
-static void error_arg_underflow(const Expression& self, const Function& func, int argc_req, string_view sig){
-	if (self.origin == nullptr){
-		return;
-	}
-	
-	string_view mark = func.view();
-	linepos pos = findLine(*self.origin, mark.begin());
-	
-	print(pos);
-	LOG_STDERR(ERROR_PFX "Missing arguments (" RED("%d") "/" PURPLE("%d") ") in function " PURPLE("%.*s") ".\n", func.argc, argc_req, VA_STRV(sig));
-	printCodeView(pos, mark, ANSI_RED);
-}
-
-static void warn_arg_overflow(const Expression& self, const Function& func, int argc_req, string_view sig){
-	if (self.origin == nullptr){
-		return;
-	}
-	
-	string_view mark = func.view();
-	if (func.argc > 0 && func.argv[func.argc-1] != nullptr){
-		mark = func.argv[func.argc-1]->view();
-	}
-	
-	linepos pos = findLine(*self.origin, mark.begin());
-	
-	print(pos);
-	LOG_STDERR(WARN_PFX "Too many arguments (" YELLOW("%d") "/" PURPLE("%d") ") in function " PURPLE("%.*s") ".\n", func.argc, argc_req, VA_STRV(sig));
-	printCodeView(pos, mark, ANSI_YELLOW);
-}
-
 static void error_arg_expected_var(const Expression& self, const Operation& arg, string_view arg_name, string_view sig){
 	if (self.origin == nullptr){
 		return;
@@ -134,13 +91,6 @@ static void error_arg_expected_regex(const Expression& self, const Operation& ar
 
 
 static Value f_defined(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "defined(var)"));
-		return 0L;
-	} else if (f.argc > 1){
-		HERE(warn_arg_overflow(self, f, 1, "defined(var)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	const Operation* arg0 = f.argv[0];
 	
@@ -150,17 +100,12 @@ static Value f_defined(const Expression& self, const Function& f, const Variable
 	}
 	
 	const Variable& var = static_cast<const Variable&>(*arg0);
-	const Value* val = vars.get(var.name());
+	const Value* val = vars.get(var.sym);
 	return (val != nullptr && val->type != Value::Type::NONE) ? 1L : 0L;
 }
 
 
 static Value f_coalesce(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "coalesce(x, ...)"));
-		return Value();
-	}
-	
 	for (uint32_t i = 0 ; i < f.argc ; i++){
 		assert(f.argv[i] != nullptr);
 		const Operation& arg = *f.argv[i];
@@ -168,7 +113,7 @@ static Value f_coalesce(const Expression& self, const Function& f, const Variabl
 		// Check for variable.
 		if (arg.type == Operation::Type::VAR){
 			const Variable& var = static_cast<const Variable&>(arg);
-			const Value* val = vars.get(var.name());
+			const Value* val = vars.get(var.sym);
 			
 			if (val != nullptr && val->type != Type::NONE){
 				return *val;
@@ -193,13 +138,6 @@ static Value f_coalesce(const Expression& self, const Function& f, const Variabl
 
 
 static Value f_bool(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "bool(e)"));
-		return Value(0L);
-	} else if (f.argc > 1){
-		HERE(warn_arg_overflow(self, f, 1, "bool(e)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	Value val = eval(self, *f.argv[0], vars);
 	return val.cast_bool();
@@ -207,13 +145,6 @@ static Value f_bool(const Expression& self, const Function& f, const VariableMap
 
 
 static Value f_int(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "int(e)"));
-		return Value(0L);
-	} else if (f.argc > 1){
-		HERE(warn_arg_overflow(self, f, 1, "int(e)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	Value val = eval(self, *f.argv[0], vars);
 	return val.cast_int();
@@ -221,13 +152,6 @@ static Value f_int(const Expression& self, const Function& f, const VariableMap&
 
 
 static Value f_float(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "float(e)"));
-		return Value(0.0);
-	} else if (f.argc > 1){
-		HERE(warn_arg_overflow(self, f, 1, "float(e)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	Value val = eval(self, *f.argv[0], vars);
 	return val.cast_float();
@@ -235,13 +159,6 @@ static Value f_float(const Expression& self, const Function& f, const VariableMa
 
 
 static Value f_str(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "str(e)"));
-		return string_view();
-	} else if (f.argc > 1){
-		HERE(warn_arg_overflow(self, f, 1, "str(e)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	Value val = eval(self, *f.argv[0], vars);
 	return val.cast_str();
@@ -249,13 +166,6 @@ static Value f_str(const Expression& self, const Function& f, const VariableMap&
 
 
 static Value f_len(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "len(e)"));
-		return Value(0L);
-	} else if (f.argc > 1){
-		HERE(warn_arg_overflow(self, f, 1, "len(e)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	Value val = eval(self, *f.argv[0], vars);
 	
@@ -270,7 +180,7 @@ static Value f_len(const Expression& self, const Function& f, const VariableMap&
 			val.data.d = abs(val.data.d);
 			break;
 		case Type::STRING:
-			val = static_cast<long>(val.data.s->len);
+			val = static_cast<long>(val.sv().length());
 			break;
 		case Type::OBJECT:
 			val = static_cast<long>(val.data.o->arr.size());
@@ -298,7 +208,7 @@ static bool cmp(const Value& v1, const Value& v2, auto op){
 				case Type::DOUBLE:
 					return op(v1.data.l, v2.data.d);
 				case Type::STRING:
-					return op(v1.data.l, v2.data.s->len);
+					return op(v1.data.l, v2.sv().length());
 				case Type::OBJECT:
 					return op(v1.data.l, v2.data.o->arr.size());
 			}
@@ -313,7 +223,7 @@ static bool cmp(const Value& v1, const Value& v2, auto op){
 				case Type::DOUBLE:
 					return op(v1.data.d, v2.data.d);
 				case Type::STRING:
-					return op(v1.data.d, v2.data.s->len);
+					return op(v1.data.d, v2.sv().length());
 				case Type::OBJECT:
 					return op(v1.data.d, v2.data.o->arr.size());
 			}
@@ -324,13 +234,13 @@ static bool cmp(const Value& v1, const Value& v2, auto op){
 				case Type::NONE:
 					return true;
 				case Type::LONG:
-					return op(v1.data.s->len, v2.data.l);
+					return op(v1.sv().length(), v2.data.l);
 				case Type::DOUBLE:
-					return op(v1.data.s->len, v2.data.d);
+					return op(v1.sv().length(), v2.data.d);
 				case Type::STRING:
-					return op(v1.data.s->len, v2.data.s->len);
+					return op(v1.sv().length(), v2.sv().length());
 				case Type::OBJECT:
-					return op(v1.data.s->len, v2.data.o->arr.size());
+					return op(v1.sv().length(), v2.data.o->arr.size());
 			}
 		} break;
 		
@@ -343,7 +253,7 @@ static bool cmp(const Value& v1, const Value& v2, auto op){
 				case Type::DOUBLE:
 					return op(v1.data.o->arr.size(), v2.data.d);
 				case Type::STRING:
-					return op(v1.data.o->arr.size(), v2.data.s->len);
+					return op(v1.data.o->arr.size(), v2.sv().length());
 				case Type::OBJECT:
 					return op(v1.data.o->arr.size(), v2.data.o->arr.size());
 			}
@@ -356,11 +266,6 @@ static bool cmp(const Value& v1, const Value& v2, auto op){
 
 
 static Value f_min(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "min(x, ...)"));
-		return {};
-	}
-	
 	Value result;
 	auto op = std::less();
 	
@@ -387,11 +292,6 @@ static Value f_min(const Expression& self, const Function& f, const VariableMap&
 
 
 static Value f_max(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "max(x, ...)"));
-		return {};
-	}
-	
 	Value result;
 	auto op = std::greater();
 	
@@ -418,13 +318,6 @@ static Value f_max(const Expression& self, const Function& f, const VariableMap&
 
 
 static Value f_sin(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "sin(x)"));
-		return Value(0L);
-	} else if (f.argc > 1){
-		HERE(warn_arg_overflow(self, f, 1, "sin(x)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	Value val = eval(self, *f.argv[0], vars);
 	
@@ -447,13 +340,6 @@ static Value f_sin(const Expression& self, const Function& f, const VariableMap&
 
 
 static Value f_cos(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "cos(x)"));
-		return Value(0L);
-	} else if (f.argc > 1){
-		HERE(warn_arg_overflow(self, f, 1, "cos(x)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	Value val = eval(self, *f.argv[0], vars);
 	
@@ -476,13 +362,6 @@ static Value f_cos(const Expression& self, const Function& f, const VariableMap&
 
 
 static Value f_if(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 3){
-		HERE(error_arg_underflow(self, f, 3, "if(cond, true_expr, false_expr)"));
-		return {};
-	} else if (f.argc > 3){
-		HERE(warn_arg_overflow(self, f, 3, "if(cond, true_expr, false_expr)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	Value cond = eval(self, *f.argv[0], vars);
 	
@@ -530,21 +409,12 @@ inline string_view substr(string_view s, long beg, long end){
 
 
 static Value f_lower(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "lower(str)"));
-		return string_view();
-	} else if (f.argc > 1){
-		HERE(warn_arg_overflow(self, f, 1, "lower(str)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	Value val = eval(self, *f.argv[0], vars);
 	
 	switch (val.type){
 		case Type::STRING: [[likely]]
-			if (val.data.s->refs > 1)
-				val = Value(val.data.s->sv());
-			lowercase(val.data.s->str, val.data.s->len);
+			lowercase(val.unique_str(), val.sv().length());
 			break;
 		case Type::LONG:
 			val = Value(to_string(val.data.l));
@@ -562,21 +432,12 @@ static Value f_lower(const Expression& self, const Function& f, const VariableMa
 
 
 static Value f_upper(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "upper(str)"));
-		return string_view();
-	} else if (f.argc > 1){
-		HERE(warn_arg_overflow(self, f, 1, "upper(str)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	Value val = eval(self, *f.argv[0], vars);
 	
 	switch (val.type){
 		case Type::STRING: [[likely]]
-			if (val.data.s->refs > 1)
-				val = Value(val.data.s->sv());
-			uppercase(val.data.s->str, val.data.s->len);
+			uppercase(val.unique_str(), val.sv().length());
 			break;
 		case Type::LONG:
 			val = Value(to_string(val.data.l));
@@ -594,13 +455,6 @@ static Value f_upper(const Expression& self, const Function& f, const VariableMa
 
 
 static Value f_slice(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 2){
-		HERE(error_arg_underflow(self, f, 2, "slice(arr, beg, [len])"));
-		return string_view();
-	} else if (f.argc > 3){
-		HERE(warn_arg_overflow(self, f, 3, "slice(arr, beg, [len])"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	assert(f.argv[1] != nullptr);
 	Value arg_0 = eval(self, *f.argv[0], vars);
@@ -620,7 +474,7 @@ static Value f_slice(const Expression& self, const Function& f, const VariableMa
 	// Verify argument 0 [arr]
 	switch (arg_0.type){
 		case Type::STRING:
-			size = arg_0.data.s->len;
+			size = arg_0.sv().length();
 			break;
 		case Type::OBJECT:
 			size = arg_0.data.o->arr.size();
@@ -667,16 +521,18 @@ static Value f_slice(const Expression& self, const Function& f, const VariableMa
 	
 	switch (arg_0.type){
 		case Type::STRING: {
-			string_view s = arg_0.data.s->sv();
+			string_view s = arg_0.sv();
 			return Value(s.substr(beg, len));
 		}
 		
 		case Type::OBJECT: {
 			Value o2 = Value(new Value::Object());
-			const vector<Value>& v1 = arg_0.data.o->arr;
-			vector<Value>& v2 = o2.data.o->arr;
-			v2.insert(v2.end(), v1.begin() + beg, v1.begin() + end);
-			return o2; 
+			const persistent_vector<Value>& v1 = arg_0.data.o->arr;
+			persistent_vector<Value>& v2 = o2.data.o->arr;
+			for (long i = beg ; i < end ; i++){
+				v2.push_back(v1[i]);
+			}
+			return o2;
 		}
 		
 		default:
@@ -689,13 +545,6 @@ static Value f_slice(const Expression& self, const Function& f, const VariableMa
 
 
 static Value f_split(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 2){
-		HERE(error_arg_underflow(self, f, 2, "split(str, delim)"));
-		return Value();
-	} else if (f.argc > 2){
-		HERE(warn_arg_overflow(self, f, 2, "split(str, delim)"));
-	}
-	
 	// Extract argument 0 [str]
 	assert(f.argv[0] != nullptr);
 	Value arg_str = eval(self, *f.argv[0], vars);
@@ -705,7 +554,7 @@ static Value f_split(const Expression& self, const Function& f, const VariableMa
 	}
 	
 	arg_str = arg_str.cast_str();
-	string_view str = arg_str.data.s->sv();
+	string_view str = arg_str.sv();
 	
 	// Extract argument 1 [delim]
 	assert(f.argv[1] != nullptr);
@@ -717,7 +566,7 @@ static Value f_split(const Expression& self, const Function& f, const VariableMa
 		case Type::LONG:
 		case Type::DOUBLE:
 			arg_delim = arg_delim.cast_str();
-			delim = arg_delim.data.s->sv();
+			delim = arg_delim.sv();
 			break;
 			
 		case Type::OBJECT:
@@ -725,7 +574,7 @@ static Value f_split(const Expression& self, const Function& f, const VariableMa
 			return Value();
 		
 		case Type::STRING:
-			delim = arg_delim.data.s->sv();
+			delim = arg_delim.sv();
 			break;
 	}
 	
@@ -734,8 +583,6 @@ static Value f_split(const Expression& self, const Function& f, const VariableMa
 	
 	// Split on every character.
 	if (delim.empty()){
-		obj->arr.reserve(str.size());
-		
 		for (char c : str){
 			obj->arr.emplace_back(string_view(&c, 1));
 		}
@@ -745,14 +592,15 @@ static Value f_split(const Expression& self, const Function& f, const VariableMa
 	
 	// Split using regex.
 	try {
-		regex reg = regex(delim.begin(), delim.end());
-		cregex_token_iterator tok = cregex_token_iterator(str.begin(), str.end(), reg, -1);
-		cregex_token_iterator end = cregex_token_iterator();
+		shared_ptr<const Regex> reg = Regex::compile(delim);
+		if (reg == nullptr){
+			HERE(error_arg_expected_regex(self, *f.argv[1], "delim", "split(str, delim)"));
+			goto _err_ret;
+		}
 		
-		for (; tok != end ; tok++){
-			string_view s = string_view(tok->first, tok->length());
+		reg->split(str, [&](string_view s){
 			obj->arr.emplace_back(s);
-		}
+		});
 		
 	} catch (...){
 		HERE(error_arg_expected_regex(self, *f.argv[1], "delim", "split(str, delim)"));
@@ -769,13 +617,6 @@ static Value f_split(const Expression& self, const Function& f, const VariableMa
 
 
 static Value f_join(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 1){
-		HERE(error_arg_underflow(self, f, 1, "join(arr, [sep])"));
-		return Value();
-	} else if (f.argc > 2){
-		HERE(warn_arg_overflow(self, f, 2, "join(arr, sep)"));
-	}
-	
 	// Extract argument 0 [arr]
 	assert(f.argv[0] != nullptr);
 	Value arg_arr = eval(self, *f.argv[0], vars);
@@ -784,7 +625,7 @@ static Value f_join(const Expression& self, const Function& f, const VariableMap
 		return arg_arr.cast_str();
 	}
 	
-	const vector<Value>& arr = arg_arr.data.o->arr;
+	const persistent_vector<Value>& arr = arg_arr.data.o->arr;
 	
 	// Extract argument 1 [sep]
 	Value arg_sep;
@@ -794,14 +635,16 @@ static Value f_join(const Expression& self, const Function& f, const VariableMap
 		assert(f.argv[1] != nullptr);
 		arg_sep = eval(self, *f.argv[1], vars).cast_str();
 		assert(arg_sep.type == Type::STRING);
-		sep = arg_sep.data.s->sv();
+		sep = arg_sep.sv();
 	}
 	
 	string buff;
-	for (size_t i = 0 ; i < arr.size() ; i++){
-		if (i > 0)
+	bool first = true;
+	for (const Value& el : arr){
+		if (!first)
 			buff.append(sep);
-		arr[i].toStr(buff);
+		first = false;
+		el.toStr(buff);
 	}
 	
 	return Value(buff);
@@ -812,13 +655,6 @@ static Value f_join(const Expression& self, const Function& f, const VariableMap
 
 
 static Value f_match(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 2){
-		HERE(error_arg_underflow(self, f, 2, "match(str, reg)"));
-		return 0L;
-	} else if (f.argc > 2){
-		HERE(warn_arg_overflow(self, f, 2, "match(str, reg)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	assert(f.argv[1] != nullptr);
 	
@@ -837,16 +673,14 @@ static Value f_match(const Expression& self, const Function& f, const VariableMa
 	}
 	
 	// Create regex
-	regex reg;
-	try {
-		reg = regex(arg_reg.data.s->begin(), arg_reg.data.s->end());
-	} catch (...){
+	shared_ptr<const Regex> reg = Regex::compile(arg_reg.sv());
+	if (reg == nullptr){
 		HERE(error_arg_expected_regex(self, *f.argv[1], "reg", "match(str, reg)"));
 		return 0L;
 	}
 	
 	try {
-		bool m = regex_match(arg_str.data.s->begin(), arg_str.data.s->end(), reg);
+		bool m = reg->match(arg_str.sv());
 		return m ? 1L : 0L;
 	} catch (...){
 		HERE(error_arg_expected_regex(self, *f.argv[1], "reg", "match(str, reg)"));
@@ -857,13 +691,6 @@ static Value f_match(const Expression& self, const Function& f, const VariableMa
 
 
 static Value f_replace(const Expression& self, const Function& f, const VariableMap& vars){
-	if (f.argc < 3){
-		HERE(error_arg_underflow(self, f, 3, "replace(str, reg, rep)"));
-		return Value(""sv);
-	} else if (f.argc > 3){
-		HERE(warn_arg_overflow(self, f, 3, "replace(str, reg, rep)"));
-	}
-	
 	assert(f.argv[0] != nullptr);
 	assert(f.argv[1] != nullptr);
 	assert(f.argv[2] != nullptr);
@@ -890,13 +717,16 @@ static Value f_replace(const Expression& self, const Function& f, const Variable
 	}
 	
 	// Strings are C-strings
-	assert(*arg_str.data.s->end() == '\0');
-	assert(*arg_rep.data.s->end() == '\0');
 	
 	// Create regex
+	shared_ptr<const Regex> reg = Regex::compile(arg_reg.sv());
+	if (reg == nullptr){
+		HERE(error_arg_expected_regex(self, *f.argv[1], "reg", "replace(str, reg, rep)"));
+		return arg_str;
+	}
+	
 	try {
-		regex reg = regex(arg_reg.data.s->begin(), arg_reg.data.s->end());
-		string buff = regex_replace(arg_str.data.s->begin(), reg, arg_rep.data.s->begin());
+		string buff = reg->replace(arg_str.sv(), arg_rep.c_str());
 		arg_str = Value(move(buff));
 	} catch (...){
 		HERE(error_arg_expected_regex(self, *f.argv[1], "reg", "replace(str, reg, rep)"));
@@ -909,69 +739,52 @@ static Value f_replace(const Expression& self, const Function& f, const Variable
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
-Value eval(const Expression& self, const Function& f, const VariableMap& vars){
-	string_view name = f.name();
-	try {
-		switch (name.length()){
-			case 2:
-				if (name == "if")
-					return f_if(self, f, vars);
-				break;
-			case 3:
-				if (name == "int")
-					return f_int(self, f, vars);
-				else if (name == "str")
-					return f_str(self, f, vars);
-				else if (name == "len" || name == "abs")
-					return f_len(self, f, vars);
-				else if (name == "min")
-					return f_min(self, f, vars);
-				else if (name == "max")
-					return f_max(self, f, vars);
-				else if (name == "sin")
-					return f_sin(self, f, vars);
-				else if (name == "cos")
-					return f_cos(self, f, vars);
-				break;
-			case 4:
-				if (name == "bool")
-					return f_bool(self, f, vars);
-				else if (name == "join")
-					return f_join(self, f, vars);
-				break;
-			case 5:
-				if (name == "float")
-					return f_float(self, f, vars);
-				else if (name == "slice")
-					return f_slice(self, f, vars);
-				else if (name == "split")
-					return f_split(self, f, vars);
-				else if (name == "lower")
-					return f_lower(self, f, vars);
-				else if (name == "upper")
-					return f_upper(self, f, vars);
-				else if (name == "match")
-					return f_match(self, f, vars);
-				break;
-			case 7:
-				if (name == "replace")
-					return f_replace(self, f, vars);
-				else if (name == "defined")
-					return f_defined(self, f, vars);
-				break;
-			case 8:
-				if (name == "coalesce")
-					return f_coalesce(self, f, vars);
-				break;
-		}
-	} catch (...) {
-		HERE(ERROR("Failed to evaluate function " PURPLE("%.*s()") " due to an internal exception.", VA_STRV(name)));
-		return {};
-	}
-	
-	HERE(error_undefined_function(self, f));
+static constexpr FunctionInfo functions[] = {
+	{ "abs",      f_len,       1, 1,          "abs(x)",                            true  },
+	{ "bool",     f_bool,      1, 1,          "bool(e)",                           true  },
+	{ "coalesce", f_coalesce,  1, UINT32_MAX, "coalesce(x, ...)",                  true  },
+	{ "cos",      f_cos,       1, 1,          "cos(x)",                            true  },
+	{ "defined",  f_defined,   1, 1,          "defined(var)",                      false },
+	{ "float",    f_float,     1, 1,          "float(e)",                          true  },
+	{ "if",       f_if,        3, 3,          "if(cond, true_expr, false_expr)",   true  },
+	{ "int",      f_int,       1, 1,          "int(e)",                            true  },
+	{ "join",     f_join,      1, 2,          "join(arr, [sep])",                  false },
+	{ "len",      f_len,       1, 1,          "len(e)",                            true  },
+	{ "lower",    f_lower,     1, 1,          "lower(str)",                        true  },
+	{ "match",    f_match,     2, 2,          "match(str, reg)",                   false },
+	{ "max",      f_max,       1, UINT32_MAX, "max(x, ...)",                       true  },
+	{ "min",      f_min,       1, UINT32_MAX, "min(x, ...)",                       true  },
+	{ "replace",  f_replace,   3, 3,          "replace(str, reg, rep)",            false },
+	{ "sin",      f_sin,       1, 1,          "sin(x)",                            true  },
+	{ "slice",    f_slice,     2, 3,          "slice(arr, beg, [len])",            false },
+	{ "split",    f_split,     2, 2,          "split(str, delim)",                 false },
+	{ "str",      f_str,       1, 1,          "str(e)",                            true  },
+	{ "upper",    f_upper,     1, 1,          "upper(str)",                        true  },
+};
+
+
+static Value f_unbound(const Expression&, const Function&, const VariableMap&){
 	return {};
 }
 
 
+const FunctionInfo FunctionInfo::UNBOUND = { "", f_unbound, 0, UINT32_MAX, "", false };
+
+
+const FunctionInfo* FunctionInfo::find(string_view name) noexcept {
+	for (const FunctionInfo& f : functions){
+		if (f.name == name)
+			return &f;
+	}
+	return nullptr;
+}
+
+
+Value eval(const Expression& self, const Function& f, const VariableMap& vars){
+	assert(f.info != nullptr);
+	assert(f.info->argc_min <= f.argc);
+	return f.info->fn(self, f, vars);
+}
+
+
 // ------------------------------------------------------------------------------------------ //
@@ -40,10 +40,11 @@ struct Double : public Expression::Operation {
 
 
 struct String : public Expression::Operation {
+	uint32_t str_len;		// Length of `str_p`.
+	const char* str_p;		// String content, without quotes. Folded strings point into the expression arena.
+	
 	std::string_view str() const {
-		if (len >= 2) [[likely]]
-			return std::string_view(pos + 1, len - 2);
-		return view();
+		return std::string_view(str_p, str_len);
 	}
 };
 
@@ -60,6 +61,8 @@ struct Object : public Expression::Operation {
 
 
 struct Variable : public Expression::Operation {
+	Symbol sym;		// Interned `name()`.
+	
 	std::string_view name() const {
 		return std::string_view(pos, len);
 	}
@@ -83,7 +86,35 @@ struct Index : public Expression::Operation {
 };
 
 
+struct Function;
+
+
+/**
+ * @brief Builtin function entry, bound to `Function` operations by the parser.
+ */
+struct FunctionInfo {
+	using Ptr = Value(*)(const Expression& self, const Function& f, const VariableMap& vars);
+	
+	std::string_view name;
+	Ptr fn;
+	uint32_t argc_min;			// Required number of arguments.
+	uint32_t argc_max;			// Maximum number of arguments, `UINT32_MAX` if variadic.
+	std::string_view sig;		// Signature, used for reporting errors.
+	bool fold;					// Function has no side effects or warnings and can be evaluated when parsing.
+	
+	static const FunctionInfo UNBOUND;	// Bound to calls of undefined functions or with missing arguments, evaluates to nothing.
+	
+	/**
+	 * @brief Find builtin function by name.
+	 * @return `nullptr` if no such function exists.
+	 */
+	static const FunctionInfo* find(std::string_view name) noexcept;
+	
+};
+
+
 struct Function : public Expression::Operation {
+	const FunctionInfo* info;	// Bound builtin function, never `null`.
 	uint32_t name_len;
 	uint32_t argc;			// Number of arguments in `argv`.
 	Operation* argv[];
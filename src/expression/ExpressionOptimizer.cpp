@@ -0,0 +1,274 @@
+#include "Expression.hpp"
+#include "ExpressionOperation.hpp"
+#include "ExpressionAllocator.hpp"
+#include <cassert>
+#include <cstring>
+
+using namespace std;
+using Operation = Expression::Operation;
+using Allocator = Expression::Allocator;
+using Type = Value::Type;
+
+
+// ----------------------------------- [ Prototypes ] --------------------------------------- //
+
+
+Value eval(const Expression& self, const Operation& op, const VariableMap& vars);
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+static bool isLiteral(const Operation* op){
+	assert(op != nullptr);
+	switch (op->type){
+		case Operation::Type::LONG:
+		case Operation::Type::DOUBLE:
+		case Operation::Type::STRING:
+			return true;
+		default:
+			return false;
+	}
+}
+
+
+/**
+ * @brief Check if integer division by `op` may be undefined, which is reported when evaluated.
+ */
+static bool isUnsafeDivisor(const Operation* op){
+	assert(op != nullptr);
+	return op->type == Operation::Type::LONG && (static_cast<const Long*>(op)->n == 0 || static_cast<const Long*>(op)->n == -1);
+}
+
+
+/**
+ * @brief Create literal node holding `val`, located at the source text of `src`.
+ * @return `nullptr` if the value has no literal representation.
+ */
+static Operation* literal(const Operation& src, const Value& val, Allocator& alc){
+	Operation* op = nullptr;
+	
+	switch (val.type){
+		case Type::LONG: {
+			Long* c = alc.alloc<Long>();
+			c->type = Operation::Type::LONG;
+			c->n = val.data.l;
+			op = c;
+		} break;
+		
+		case Type::DOUBLE: {
+			Double* c = alc.alloc<Double>();
+			c->type = Operation::Type::DOUBLE;
+			c->n = val.data.d;
+			op = c;
+		} break;
+		
+		case Type::STRING: {
+			const string_view sv = val.sv();
+			if (sv.length() > UINT32_MAX){
+				return nullptr;
+			}
+			
+			char* str = static_cast<char*>(alc.alloc(sv.length() + 1));
+			memcpy(str, sv.data(), sv.length());
+			str[sv.length()] = '\0';
+			
+			String* c = alc.alloc<String>();
+			c->type = Operation::Type::STRING;
+			c->str_len = uint32_t(sv.length());
+			c->str_p = str;
+			op = c;
+		} break;
+		
+		case Type::NONE:
+		case Type::OBJECT:
+			return nullptr;
+	}
+	
+	// Keep source location for error reporting.
+	op->pos = src.pos;
+	op->len = src.len;
+	return op;
+}
+
+
+/**
+ * @brief Evaluate operation with constant operands and replace it with a literal.
+ */
+static Operation* evalLiteral(Operation* op, Allocator& alc){
+	static const Expression quiet = Expression();	// No origin, so no errors are reported.
+	static const VariableMap none = VariableMap();
+	
+	Value val = eval(quiet, *op, none);
+	Operation* lit = literal(*op, val, alc);
+	return (lit != nullptr) ? lit : op;
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+/**
+ * @brief Fold constant subexpressions into literal nodes.
+ *        Only operations which can't report errors and have no side effects are folded.
+ * @return Folded operation, or `op` if it could not be folded.
+ */
+Operation* fold(Operation* op, Allocator& alc){
+	assert(op != nullptr);
+	
+	switch (op->type){
+		case Operation::Type::ERROR:
+		case Operation::Type::LONG:
+		case Operation::Type::DOUBLE:
+		case Operation::Type::STRING:
+		case Operation::Type::VAR:
+			return op;
+		
+		case Operation::Type::OBJECT: {
+			Object& obj = static_cast<Object&>(*op);
+			for (uint32_t i = 0 ; i < obj.count ; i++){
+				Object::Entry& e = obj.elements[i];
+				if (e.key != nullptr)
+					e.key = fold(e.key, alc);
+				e.value = fold(e.value, alc);
+			}
+			return op;
+		}
+		
+		case Operation::Type::INDEX: {
+			Index& idx = static_cast<Index&>(*op);
+			idx.obj = fold(idx.obj, alc);
+			idx.index = fold(idx.index, alc);
+			return op;
+		}
+		
+		case Operation::Type::NOT:
+		case Operation::Type::NEG: {
+			UnaryOperation& unop = static_cast<UnaryOperation&>(*op);
+			unop.arg = fold(unop.arg, alc);
+			if (isLiteral(unop.arg))
+				return evalLiteral(op, alc);
+			return op;
+		}
+		
+		case Operation::Type::FUNC: {
+			Function& f = static_cast<Function&>(*op);
+			bool constant = f.info->fold;
+			
+			for (uint32_t i = 0 ; i < f.argc ; i++){
+				f.argv[i] = fold(f.argv[i], alc);
+				constant &= isLiteral(f.argv[i]);
+			}
+			
+			if (constant)
+				return evalLiteral(op, alc);
+			return op;
+		}
+		
+		case Operation::Type::DIV:
+		case Operation::Type::MOD: {
+			BinaryOperation& binop = static_cast<BinaryOperation&>(*op);
+			binop.arg_1 = fold(binop.arg_1, alc);
+			binop.arg_2 = fold(binop.arg_2, alc);
+			
+			// Division by zero or overflow is not folded, so it is reported with a warning when evaluated.
+			if (isLiteral(binop.arg_1) && isLiteral(binop.arg_2) && !isUnsafeDivisor(binop.arg_2))
+				return evalLiteral(op, alc);
+			return op;
+		}
+		
+		default: {
+			BinaryOperation& binop = static_cast<BinaryOperation&>(*op);
+			binop.arg_1 = fold(binop.arg_1, alc);
+			binop.arg_2 = fold(binop.arg_2, alc);
+			
+			if (isLiteral(binop.arg_1) && isLiteral(binop.arg_2))
+				return evalLiteral(op, alc);
+			return op;
+		}
+	
+	}
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+/**
+ * @brief Count references to variable `sym` in the operation tree.
+ */
+static uint32_t countVar(const Operation& op, Symbol sym){
+	switch (op.type){
+		case Operation::Type::ERROR:
+		case Operation::Type::LONG:
+		case Operation::Type::DOUBLE:
+		case Operation::Type::STRING:
+			return 0;
+		
+		case Operation::Type::VAR:
+			return (static_cast<const Variable&>(op).sym == sym) ? 1 : 0;
+		
+		case Operation::Type::OBJECT: {
+			const Object& obj = static_cast<const Object&>(op);
+			uint32_t n = 0;
+			for (uint32_t i = 0 ; i < obj.count ; i++){
+				const Object::Entry& e = obj.elements[i];
+				if (e.key != nullptr)
+					n += countVar(*e.key, sym);
+				n += countVar(*e.value, sym);
+			}
+			return n;
+		}
+		
+		case Operation::Type::INDEX: {
+			const Index& idx = static_cast<const Index&>(op);
+			return countVar(*idx.obj, sym) + countVar(*idx.index, sym);
+		}
+		
+		case Operation::Type::NOT:
+		case Operation::Type::NEG:
+			return countVar(*static_cast<const UnaryOperation&>(op).arg, sym);
+		
+		case Operation::Type::FUNC: {
+			const Function& f = static_cast<const Function&>(op);
+			uint32_t n = 0;
+			for (uint32_t i = 0 ; i < f.argc ; i++){
+				n += countVar(*f.argv[i], sym);
+			}
+			return n;
+		}
+		
+		default: {
+			const BinaryOperation& binop = static_cast<const BinaryOperation&>(op);
+			return countVar(*binop.arg_1, sym) + countVar(*binop.arg_2, sym);
+		}
+		
+	}
+}
+
+
+/**
+ * @brief Find variable which is appended to by the expression, as in `x + a + b`.
+ *        The variable must be the leftmost operand of a chain of `+` and not referenced anywhere else.
+ * @return Symbol of the variable or `Symbols::NONE`.
+ */
+Symbol accumulator(const Operation& op){
+	if (op.type != Operation::Type::ADD){
+		return Symbols::NONE;
+	}
+	
+	const Operation* left = &op;
+	while (left->type == Operation::Type::ADD){
+		left = static_cast<const BinaryOperation*>(left)->arg_1;
+	}
+	
+	if (left->type != Operation::Type::VAR){
+		return Symbols::NONE;
+	}
+	
+	const Symbol sym = static_cast<const Variable*>(left)->sym;
+	return (countVar(op, sym) == 1) ? sym : Symbols::NONE;
+}
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -2,8 +2,8 @@
 #include "ExpressionOperation.hpp"
 #include "ExpressionAllocator.hpp"
 #include <cassert>
-#include <vector>
 #include <charconv>
+#include "stack_vector.hpp"
 
 #include "Debug.hpp"
 #include "DebugSource.hpp"
@@ -12,6 +12,16 @@ using namespace std;
 using Operation = Expression::Operation;
 using Allocator = Expression::Allocator;
 using Status = Expression::Status;
+using OperationList = stack_vector<Operation*,16>;
+using OperationTypeList = stack_vector<Operation::Type,16>;
+
+
+// ----------------------------------- [ Prototypes ] --------------------------------------- //
+
+
+Operation* fold(Operation* op, Allocator& alloc);
+Expression::Program* compile(const Operation& op, Allocator& alloc);
+Symbol accumulator(const Operation& op);
 
 
 // ----------------------------------- [ Structures ] --------------------------------------- //
@@ -27,6 +37,8 @@ enum class Expression::Status {
 	INVALID_UNARY_EXPRESSION,	// Missing operand in unary expression.
 	INVALID_INT,
 	INVALID_FLOAT,
+	UNDEFINED_FUNCTION,
+	MISSING_ARGUMENTS,			// Function called with less than the required number of arguments.
 	MEMORY,
 	ERROR,
 };
@@ -35,6 +47,7 @@ enum class Expression::Status {
 struct Error {
 	Status status;
 	string_view mark;
+	const Function* func = nullptr;		// Function of `Status::MISSING_ARGUMENTS`.
 };
 
 
@@ -93,7 +106,7 @@ static const char* parse_num(const char* s, const char* end, Allocator& alc, Ope
 	
 	bool dot = false;
 	while (s != end){
-		
+	
 		if (isDigit(*s)){
 			goto next;
 		} else if (*s == '.'){
@@ -118,7 +131,7 @@ static const char* parse_num(const char* s, const char* end, Allocator& alc, Ope
 		if (res.ec != errc()){
 			throw Error(Status::INVALID_FLOAT, string_view(beg, s));
 		}
-		
+	
 	} else {
 		Long* c = alc.alloc<Long>();
 		out = c;
@@ -129,7 +142,7 @@ static const char* parse_num(const char* s, const char* end, Allocator& alc, Ope
 		if (res.ec != errc()){
 			throw Error(Status::INVALID_INT, string_view(beg, s));
 		}
-		
+	
 	}
 	
 	out->len = s - beg;
@@ -160,7 +173,7 @@ static const char* parse_str(const char* s, const char* end, Allocator& alc, Ope
 		} else {
 			escape = false;
 		}
-		
+	
 	}
 	
 	assert(isQuot(*beg) && isQuot(*s) && *beg == *s);
@@ -170,6 +183,8 @@ static const char* parse_str(const char* s, const char* end, Allocator& alc, Ope
 	c->type = Operation::Type::STRING;
 	c->len = s - beg;
 	c->pos = beg;
+	c->str_len = c->len - 2;
+	c->str_p = beg + 1;
 	
 	out = c;
 	return s;
@@ -300,7 +315,7 @@ static Operation::Type try_parse_binaryOp(const char*& s, const char* end) noexc
 				return Operation::Type::GTE;
 			}
 			return Operation::Type::GT;
-			
+		
 		case '<':
 			s++;
 			if (s != end && *s == '='){
@@ -315,7 +330,7 @@ static Operation::Type try_parse_binaryOp(const char*& s, const char* end) noexc
 				return Operation::Type::NEQ;
 			}
 			return Operation::Type::ERROR;
-			
+		
 		case '=':
 			if (s+1 != end && s[1] == '='){
 				s += 2;
@@ -363,13 +378,13 @@ constexpr int _bindPower(Operation::Type type){
 }
 
 
-static Operation* prattBinopTree(Allocator& alc, vector<Operation*>& args, vector<Operation::Type>& ops){
+static Operation* prattBinopTree(Allocator& alc, OperationList& args, OperationTypeList& ops){
 	if (args.size() == 0){
 		return nullptr;
 	}
 	
 	assert(args.size() == ops.size()+1);
-	size_t i = 0;
+	int i = 0;
 	
 	auto capture = [&](auto& capture, int bp) -> Operation* {
 		Operation* left = args[i];
@@ -441,14 +456,12 @@ static const char* parse_binaryExpressionChain(const char* s, const char* end, A
 	}
 	
 	// Chain binops
-	vector<Operation*> args;
-	vector<Operation::Type> ops;
-	args.reserve(8);
-	args.emplace_back(move(first));
-	args.emplace_back(move(second));
-	ops.reserve(args.size() - 1);
-	ops.push_back(binop);
-	ops.push_back(binop_2);
+	OperationList args;
+	OperationTypeList ops;
+	args.emplace_back(first);
+	args.emplace_back(second);
+	ops.emplace_back(binop);
+	ops.emplace_back(binop_2);
 	
 	// e1 + e2 + ...
 	while (true){
@@ -475,7 +488,7 @@ static const char* parse_binaryExpressionChain(const char* s, const char* end, A
 			break;
 		}
 		
-		ops.push_back(binop);
+		ops.emplace_back(binop);
 	}
 	
 	// Build expression tree
@@ -493,8 +506,7 @@ static const char* parse_object(const char* beg, const char* end, Allocator& alc
 	assert(*beg == '[');
 	const char* s = beg + 1;
 	
-	vector<Object::Entry> v;
-	v.reserve(8);
+	stack_vector<Object::Entry,8> v;
 	
 	while (true){
 		s = parseWhitespace(s, end);
@@ -556,7 +568,7 @@ static const char* parse_object(const char* beg, const char* end, Allocator& alc
 	s++;
 	
 	// Create Object expression.
-	const uint32_t count = uint32_t(min(v.size(), size_t(UINT32_MAX)));
+	const uint32_t count = uint32_t(v.size());
 	void* mem = alc.alloc(sizeof(Object) + count * sizeof(*Object::elements));
 	
 	Object* obj = new (mem) Object();
@@ -590,8 +602,7 @@ static const char* parse_func(const char* s, const char* end, string_view name,
 	assert(s != nullptr && end != nullptr && s != end);
 	assert(*s == '(');
 	
-	vector<Operation*> argv;
-	argv.reserve(8);
+	OperationList argv;
 	
 	// Parse arguments
 	const char* const beg = s++;
@@ -603,7 +614,7 @@ static const char* parse_func(const char* s, const char* end, string_view name,
 		} else if (*s == ')'){
 			break;
 		} else if (*s == ','){
-			if (argv.empty()){
+			if (argv.size() == 0){
 				throw Error(Status::UNEXPECTED_SYMBOL, string_view(s, 1));
 			}
 			
@@ -611,8 +622,8 @@ static const char* parse_func(const char* s, const char* end, string_view name,
 			if (s == end){
 				goto unclosed;
 			}
-			
-		} else if (!argv.empty()){
+		
+		} else if (argv.size() != 0){
 			throw Error(Status::UNEXPECTED_SYMBOL, string_view(s, 1));
 		}
 		
@@ -625,10 +636,18 @@ static const char* parse_func(const char* s, const char* end, string_view name,
 	assert(*s == ')');
 	s++;
 	
+	const uint32_t argc = uint32_t(argv.size());
+	
+	// Bind builtin function, calls which can't be bound are reported after parsing and evaluate to nothing.
+	const FunctionInfo* info = FunctionInfo::find(name);
+	if (info == nullptr || argc < info->argc_min){
+		info = &FunctionInfo::UNBOUND;
+	}
+	
 	// Create function
-	const uint32_t argc = uint32_t(min(argv.size(), size_t(UINT32_MAX)));
 	Function* f = static_cast<Function*>(alc.alloc(sizeof(Function) + argc * sizeof(*Function::argv)));
 	f->type = Operation::Type::FUNC;
+	f->info = info;
 	f->len = s - name.begin();
 	f->pos = name.begin();
 	f->name_len = uint32_t(name.length());
@@ -660,6 +679,7 @@ static const char* parse_varOrFunc(const char* s, const char* end, Allocator& al
 		var->type = Operation::Type::VAR;
 		var->len = uint32_t(id.length());
 		var->pos = id.begin();
+		var->sym = Symbols::intern(id);
 		out = var;
 	}
 	
@@ -763,6 +783,15 @@ static void report(const Macro* origin, const Error& err){
 		case Status::INVALID_UNARY_EXPRESSION:
 			LOG_STDERR("Missing operand in unary expression.\n");
 			break;
+		case Status::UNDEFINED_FUNCTION:
+			LOG_STDERR("Undefined function: " PURPLE("'%.*s()'") "\n", VA_STRV(err.mark));
+			break;
+		case Status::MISSING_ARGUMENTS: {
+			assert(err.func != nullptr);
+			const FunctionInfo* info = FunctionInfo::find(err.func->name());
+			assert(info != nullptr);
+			LOG_STDERR("Missing arguments (" RED("%u") "/" PURPLE("%u") ") in function " PURPLE("%.*s") ".\n", err.func->argc, info->argc_min, VA_STRV(info->sig));
+		} break;
 		case Status::MEMORY:
 			LOG_STDERR("Ran out of memory when parsing expression.\n");
 			break;
@@ -775,7 +804,75 @@ static void report(const Macro* origin, const Error& err){
 }
 
 
-Expression Expression::parse(string_view str, const shared_ptr<Macro>& origin) noexcept {
+static void warn_arg_overflow(const Macro* origin, const Function& f){
+	string_view mark = f.view();
+	if (f.argc > 0 && f.argv[f.argc-1] != nullptr){
+		mark = f.argv[f.argc-1]->view();
+	}
+	
+	linepos pos = findLine(*origin, mark.begin());
+	HERE(print(pos));
+	LOG_STDERR(WARN_PFX "Too many arguments (" YELLOW("%u") "/" PURPLE("%u") ") in function " PURPLE("%.*s") ".\n", f.argc, f.info->argc_max, VA_STRV(f.info->sig));
+	printCodeView(pos, mark, ANSI_YELLOW);
+}
+
+
+/**
+ * @brief Report functions which are undefined or called with a wrong number of arguments.
+ *        Such calls don't fail the parse: unbound calls evaluate to nothing and extra arguments are ignored.
+ */
+static void check_functions(const Macro* origin, const Operation& op){
+	switch (op.type){
+		case Operation::Type::ERROR:
+		case Operation::Type::LONG:
+		case Operation::Type::DOUBLE:
+		case Operation::Type::STRING:
+		case Operation::Type::VAR:
+			break;
+		
+		case Operation::Type::FUNC: {
+			const Function& f = static_cast<const Function&>(op);
+			if (f.info != &FunctionInfo::UNBOUND){
+				if (f.argc > f.info->argc_max)
+					warn_arg_overflow(origin, f);
+			} else if (FunctionInfo::find(f.name()) == nullptr){
+				report(origin, Error(Status::UNDEFINED_FUNCTION, f.name()));
+			} else {
+				report(origin, Error(Status::MISSING_ARGUMENTS, f.view(), &f));
+			}
+			for (uint32_t i = 0 ; i < f.argc ; i++){
+				check_functions(origin, *f.argv[i]);
+			}
+		} break;
+		
+		case Operation::Type::OBJECT: {
+			const Object& obj = static_cast<const Object&>(op);
+			for (uint32_t i = 0 ; i < obj.count ; i++){
+				if (obj.elements[i].key != nullptr)
+					check_functions(origin, *obj.elements[i].key);
+				check_functions(origin, *obj.elements[i].value);
+			}
+		} break;
+		
+		case Operation::Type::NOT:
+		case Operation::Type::NEG:
+			check_functions(origin, *static_cast<const UnaryOperation&>(op).arg);
+			break;
+		
+		case Operation::Type::INDEX:
+			check_functions(origin, *static_cast<const Index&>(op).obj);
+			check_functions(origin, *static_cast<const Index&>(op).index);
+			break;
+		
+		default:
+			check_functions(origin, *static_cast<const BinaryOperation&>(op).arg_1);
+			check_functions(origin, *static_cast<const BinaryOperation&>(op).arg_2);
+			break;
+	}
+}
+
+
+Expression Expression::parse(string_view str, const Macro* origin) noexcept {
 	if (str.empty()){
 		return {};
 	}
@@ -801,13 +898,33 @@ Expression Expression::parse(string_view str, const shared_ptr<Macro>& origin) n
 			throw Error(Status::UNEXPECTED_SYMBOL, string_view(s, 1));
 		}
 		
+		if (origin != nullptr){
+			check_functions(origin, *expr.op);
+		}
+		
+		expr.op = fold(expr.op, *expr.alloc);
+		expr.program = compile(*expr.op, *expr.alloc);
+		expr.accumulator = ::accumulator(*expr.op);
+		
+		// Fully folded
+		switch (expr.op->type){
+			case Operation::Type::LONG:
+			case Operation::Type::DOUBLE:
+			case Operation::Type::STRING:
+				expr.value = expr.eval(VariableMap());
+				expr.constant = true;
+				break;
+			default:
+				break;
+		}
+		
 		return expr;
 	} catch (const Error& e){
-		report(origin.get(), e);
+		report(origin, e);
 	} catch (const bad_alloc&){
-		report(origin.get(), Error(Status::MEMORY, str));
+		report(origin, Error(Status::MEMORY, str));
 	}catch (...){
-		report(origin.get(), Error(Status::ERROR, str));
+		report(origin, Error(Status::ERROR, str));
 	}
 	
 	return {};
@@ -0,0 +1,87 @@
+#include "Interpolation.hpp"
+#include <cassert>
+
+using namespace std;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+Interpolation Interpolation::parse(string_view str, const Macro* origin){
+	Interpolation res;
+	
+	const char* const end = str.end();
+	const char* beg = str.begin();
+	
+	auto append = [&](const char* a, const char* b) -> Segment& {
+		res.text_len += size_t(b - a);
+		return res.segments.emplace_back(string_view(a, b));
+	};
+	
+	while (beg != end){
+		const char* a;	// expr begin
+		const char* b;	// expr end
+		
+		// Find starting point '{'
+		a = beg;
+		while (a != end){
+			if (*a == '{'){
+				break;
+			} else if (a[0] == '\\' && a+1 != end){
+				if (a[1] == '{' || a[1] == '\\'){
+					append(beg, a);
+					beg = ++a;
+				}
+			}
+			a++;
+		}
+		
+		// Find end point '}'
+		b = a;
+		while (b != end){
+			if (*b == '}')
+				break;
+			b++;
+		}
+		
+		// Remaining text
+		if (b == end){
+			append(beg, b);
+			break;
+		}
+		
+		// Parse expression
+		assert(*a == '{' && *b == '}');
+		Expression expr = Expression::parse(string_view(a+1, b), origin);
+		
+		if (expr){
+			append(beg, a).expr = move(expr);
+		} else {
+			res.valid = false;
+			append(beg, b+1);
+		}
+		
+		beg = b+1;
+	}
+	
+	return res;
+}
+
+
+bool Interpolation::eval(const VariableMap& vars, string& buff) const {
+	buff.reserve(buff.length() + text_len + 8*segments.size());
+	
+	for (const Segment& seg : segments){
+		buff.append(seg.text);
+		if (seg.expr.isConstant()){
+			seg.expr.constantValue().toStr(buff);
+		} else if (seg.expr){
+			seg.expr.eval(vars).toStr(buff);
+		}
+	}
+	
+	return valid;
+}
+
+
+// ------------------------------------------------------------------------------------------ //
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include "Expression.hpp"
+
+
+/**
+ * @brief Precompiled interpolated string.
+ *        The text is split once into literal slices of the source text and embedded `{...}` expressions,
+ *        so evaluation only appends segments into the output buffer.
+ */
+class Interpolation {
+// ----------------------------------- [ Structures ] --------------------------------------- //
+public:
+	struct Segment {
+		std::string_view text;	// Literal text, appended before the expression.
+		Expression expr;		// Expression appended after `text`. Empty for pure text segments.
+	};
+
+// ------------------------------------[ Properties ] --------------------------------------- //
+private:
+	std::vector<Segment> segments;
+	size_t text_len = 0;	// Total length of all literal text.
+	bool valid = true;		// `false` if any of the expressions failed to parse.
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	/**
+	 * @brief Split string into literal text and expressions.
+	 *        Expressions that fail to parse are reported and kept as literal text.
+	 * @param str Source text. Must outlive the interpolation.
+	 * @param origin Source macro of the text, used for reporting errors.
+	 */
+	static Interpolation parse(std::string_view str, const Macro* origin);
+	
+	/**
+	 * @brief Evaluate all expressions and append the result to `buff`.
+	 * @param vars Variables used in the expressions.
+	 * @param buff The output buffer for the resulting interpolated string.
+	 * @return `true` If no errors occured with interpolation.
+	 */
+	bool eval(const VariableMap& vars, std::string& buff) const;
+
+// ------------------------------------------------------------------------------------------ //
+};
@@ -0,0 +1,65 @@
+#include "Regex.hpp"
+#include <list>
+#include <unordered_map>
+#include "Stats.hpp"
+
+using namespace std;
+
+
+// ----------------------------------- [ Variables ] ---------------------------------------- //
+
+
+// Number of most recently used patterns kept compiled.
+static constexpr size_t CACHE_CAPACITY = 64;
+
+// Compiled patterns of the current thread, most recently used first. Invalid patterns are cached as `nullptr`.
+static thread_local list<pair<string,shared_ptr<const Regex>>> lru;
+static thread_local unordered_map<string_view,decltype(lru)::iterator> cache;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+shared_ptr<const Regex> Regex::compile(string_view pattern){
+	auto it = cache.find(pattern);
+	
+	if (it != cache.end()){
+		Stats::regex.hits++;
+		lru.splice(lru.begin(), lru, it->second);
+		return it->second->second;
+	}
+	
+	Stats::regex.misses++;
+	
+	shared_ptr<const Regex> reg;
+	try {
+		reg = make_shared<const Regex>(pattern);
+	} catch (const regex_error&){
+		reg = nullptr;
+	}
+	
+	// Evict least recently used
+	if (lru.size() >= CACHE_CAPACITY){
+		cache.erase(lru.back().first);
+		lru.pop_back();
+	}
+	
+	lru.emplace_front(string(pattern), reg);
+	cache.emplace(lru.front().first, lru.begin());
+	return reg;
+}
+
+
+bool Regex::match(string_view str) const {
+	return regex_match(str.begin(), str.end(), reg);
+}
+
+
+string Regex::replace(string_view str, const char* rep) const {
+	string buff;
+	regex_replace(back_inserter(buff), str.begin(), str.end(), reg, rep);
+	return buff;
+}
+
+
+// ------------------------------------------------------------------------------------------ //
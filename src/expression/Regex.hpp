@@ -0,0 +1,55 @@
+#pragma once
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+
+
+/**
+ * @brief Compiled regular expression used by the builtin expression functions.
+ *        Callers only use this interface, so the matching engine can be replaced without touching them.
+ *        All functions may throw `std::regex_error` if matching exceeds the engine's limits.
+ */
+class Regex {
+// ------------------------------------[ Properties ] --------------------------------------- //
+private:
+	std::regex reg;
+
+// ---------------------------------- [ Constructors ] -------------------------------------- //
+public:
+	Regex(std::string_view pattern) : reg(pattern.begin(), pattern.end()) {}
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	/**
+	 * @brief Get compiled pattern from the LRU cache of the calling thread, compiling it on a miss.
+	 * @return `nullptr` if the pattern is invalid.
+	 */
+	static std::shared_ptr<const Regex> compile(std::string_view pattern);
+	
+	/**
+	 * @brief Check if the whole `str` matches the pattern.
+	 */
+	bool match(std::string_view str) const;
+	
+	/**
+	 * @brief Replace all matches in `str` with format string `rep`.
+	 * @param rep Null terminated format string.
+	 */
+	std::string replace(std::string_view str, const char* rep) const;
+	
+	/**
+	 * @brief Split `str` on each match of the pattern.
+	 * @param f Callback receiving each token as `std::string_view`.
+	 */
+	template<typename F>
+	void split(std::string_view str, F&& f) const {
+		std::cregex_token_iterator tok = std::cregex_token_iterator(str.begin(), str.end(), reg, -1);
+		std::cregex_token_iterator end = std::cregex_token_iterator();
+		for (; tok != end ; tok++){
+			f(std::string_view(tok->first, tok->length()));
+		}
+	}
+
+// ------------------------------------------------------------------------------------------ //
+};
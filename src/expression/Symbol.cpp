@@ -0,0 +1,66 @@
+#include "Symbol.hpp"
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+
+// ----------------------------------- [ Variables ] ---------------------------------------- //
+
+
+// Symbol names indexed by id. Deque keeps the strings in place when growing.
+static deque<string> names;
+static unordered_map<string_view,Symbol> symbols;
+static shared_mutex mtx;		// Symbols are shared by all threads. Most lookups are cached by callers.
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+Symbol Symbols::intern(string_view name){
+	if (Symbol sym = find(name) ; sym != Symbols::NONE){
+		return sym;
+	}
+	
+	unique_lock _lock = unique_lock(mtx);
+	auto it = symbols.find(name);
+	if (it != symbols.end()){
+		return it->second;
+	}
+	
+	const Symbol sym = Symbol(names.size());
+	assert(sym != Symbols::NONE);
+	
+	const string& s = names.emplace_back(name);
+	symbols.emplace(string_view(s), sym);
+	return sym;
+}
+
+
+Symbol Symbols::find(string_view name) noexcept {
+	shared_lock _lock = shared_lock(mtx);
+	auto it = symbols.find(name);
+	if (it != symbols.end())
+		return it->second;
+	return Symbols::NONE;
+}
+
+
+string_view Symbols::name(Symbol sym) noexcept {
+	shared_lock _lock = shared_lock(mtx);
+	assert(sym < names.size());
+	return names[sym];
+}
+
+
+size_t Symbols::count() noexcept {
+	shared_lock _lock = shared_lock(mtx);
+	return names.size();
+}
+
+
+// ------------------------------------------------------------------------------------------ //
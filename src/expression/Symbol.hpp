@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+
+// ----------------------------------- [ Structures ] --------------------------------------- //
+
+
+/**
+ * @brief Process-wide integer id of an interned variable name.
+ *        Ids are dense, starting at 0, and never released.
+ *        Symbols are shared by all threads.
+ */
+using Symbol = uint32_t;
+
+
+namespace Symbols {
+// ----------------------------------- [ Variables ] ---------------------------------------- //
+
+
+// Id of no symbol. Not a valid index of any `VariableMap`.
+constexpr Symbol NONE = UINT32_MAX;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+/**
+ * @brief Get id of `name`, creating a new symbol on first use.
+ */
+Symbol intern(std::string_view name);
+
+/**
+ * @brief Get id of `name` without creating a new symbol.
+ * @return `Symbols::NONE` if `name` was never interned.
+ */
+Symbol find(std::string_view name) noexcept;
+
+/**
+ * @brief Get name of symbol.
+ * @return Null terminated name, valid for the lifetime of the program.
+ */
+std::string_view name(Symbol sym) noexcept;
+
+/**
+ * @brief Number of interned symbols.
+ */
+size_t count() noexcept;
+
+
+// ------------------------------------------------------------------------------------------ //
+};
@@ -2,10 +2,84 @@
 #include <string>
 #include <cstring>
 #include <charconv>
+#include "BlockAllocator.hpp"
 
 using namespace std;
 
 
+// ----------------------------------- [ Variables ] ---------------------------------------- //
+
+
+// Block sizes of pooled heap strings, including the `String` header and null terminator.
+static constexpr size_t STRING_BLOCKS[Value::STRING_POOLS] = { 32, 64, 128, 256 };
+
+template<size_t I>
+using StringPool = BlockAllocator<STRING_BLOCKS[I], alignof(Value::String)>;
+using ObjectPool = BlockAllocator<sizeof(Value::Object), alignof(Value::Object)>;
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+template<size_t I = 0>
+static void* pool_allocate(size_t size){
+	if (size <= STRING_BLOCKS[I]){
+		void* mem = StringPool<I>::heap.allocate();
+		if (mem == nullptr)
+			throw bad_alloc();
+		return mem;
+	} else if constexpr (I + 1 < Value::STRING_POOLS){
+		return pool_allocate<I + 1>(size);
+	} else {
+		return ::operator new(size, align_val_t(alignof(Value::String)));
+	}
+}
+
+
+template<size_t I = 0>
+static void pool_deallocate(void* mem, size_t size) noexcept {
+	if (size <= STRING_BLOCKS[I]){
+		StringPool<I>::heap.deallocate(mem);
+	} else if constexpr (I + 1 < Value::STRING_POOLS){
+		pool_deallocate<I + 1>(mem, size);
+	} else {
+		::operator delete(mem, align_val_t(alignof(Value::String)));
+	}
+}
+
+
+static size_t block_size(size_t size) noexcept {
+	for (size_t block : STRING_BLOCKS){
+		if (size <= block)
+			return block;
+	}
+	return size;
+}
+
+
+template<typename Pool>
+static PoolStats pool_stats(const char* name, const Pool& pool, size_t block){
+	return PoolStats {
+		.name = name,
+		.block = block,
+		.used = pool.used,
+		.peak = pool.peak,
+		.capacity = pool.capacity,
+	};
+}
+
+
+array<PoolStats,Value::STRING_POOLS + 1> Value::pools(){
+	return {
+		pool_stats("string pool 32", StringPool<0>::heap, STRING_BLOCKS[0]),
+		pool_stats("string pool 64", StringPool<1>::heap, STRING_BLOCKS[1]),
+		pool_stats("string pool 128", StringPool<2>::heap, STRING_BLOCKS[2]),
+		pool_stats("string pool 256", StringPool<3>::heap, STRING_BLOCKS[3]),
+		pool_stats("object pool", ObjectPool::heap, sizeof(Object)),
+	};
+}
+
+
 // ---------------------------------- [ Constructors ] -------------------------------------- //
 
 
@@ -14,6 +88,7 @@ Value::Value(String* str){
 		type = Type::NONE;
 	} else {
 		type = Type::STRING;
+		sso_len = SSO_HEAP;
 		data.s = str->ref();
 	}
 }
@@ -29,36 +104,52 @@ Value::Value(Object* obj){
 }
 
 
-Value::Value(string_view s){
-	this->type = Type::STRING;
-	this->data.s = String::create(s).release()->ref();
+Value::Value(string_view s) : type{Type::STRING} {
+	if (s.length() <= SSO_CAPACITY){
+		char* buff = sso();
+		copy(s.begin(), s.end(), buff);
+		buff[s.length()] = 0;
+		sso_len = uint8_t(s.length());
+	} else {
+		sso_len = SSO_HEAP;
+		data.s = String::create(s).release()->ref();
+	}
 }
 
 
 Value::Value(string_view s1, string_view s2) : type{Type::STRING} {
-	this->type = Type::STRING;
-	this->data.s = String::create(s1, s2).release()->ref();
+	if (s1.length() + s2.length() <= SSO_CAPACITY){
+		char* buff = sso();
+		copy(s1.begin(), s1.end(), buff);
+		copy(s2.begin(), s2.end(), buff + s1.length());
+		buff[s1.length() + s2.length()] = 0;
+		sso_len = uint8_t(s1.length() + s2.length());
+	} else {
+		sso_len = SSO_HEAP;
+		data.s = String::create(s1, s2).release()->ref();
+	}
 }
 
 
 Value::Value(const Value& o){
-	this->type = o.type;
+	copyBits(o);
 	
 	switch (o.type){
 		case Type::NONE:
 		case Type::LONG:
 		case Type::DOUBLE:
-			this->data = o.data;
 			break;
 		
 		case Type::STRING:
-			assert(o.data.s != nullptr);
-			this->data.s = o.data.s->ref();
+			if (o.sso_len == SSO_HEAP){
+				assert(o.data.s != nullptr);
+				o.data.s->ref();
+			}
 			break;
 		
 		case Type::OBJECT:
 			assert(o.data.o != nullptr);
-			this->data.o = o.data.o->ref();
+			o.data.o->ref();
 			break;
 			
 	}
@@ -74,8 +165,10 @@ Value::~Value(){
 			break;
 		
 		case Type::STRING:
-			assert(data.s != nullptr);
-			data.s->unref();
+			if (sso_len == SSO_HEAP){
+				assert(data.s != nullptr);
+				data.s->unref();
+			}
 			break;
 		
 		case Type::OBJECT:
@@ -90,18 +183,119 @@ Value::~Value(){
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
+char* Value::unique_str(){
+	assert(type == Type::STRING);
+	
+	if (sso_len != SSO_HEAP){
+		return sso();
+	} else if (data.s->refs > 1){
+		String* s = String::create(data.s->sv()).release()->ref();
+		data.s->unref();
+		data.s = s;
+	}
+	
+	return data.s->str;
+}
+
+
+void Value::truncate(size_t len){
+	assert(type == Type::STRING);
+	
+	if (sso_len != SSO_HEAP){
+		if (len < sso_len){
+			sso_len = uint8_t(len);
+			sso()[len] = 0;
+		}
+	} else if (len < data.s->len){
+		if (data.s->refs <= 1){
+			data.s->len = uint32_t(len);
+			data.s->str[len] = 0;
+		} else {
+			*this = Value(data.s->sv().substr(0, len));
+		}
+	}
+	
+}
+
+
+void Value::append(string_view str){
+	assert(type == Type::STRING);
+	const size_t len = sv().length();
+	const size_t total = min(len + str.length(), size_t(UINT32_MAX - 1));
+	str = str.substr(0, total - len);
+	
+	// Inline
+	if (sso_len != SSO_HEAP){
+		if (total <= SSO_CAPACITY){
+			char* buff = sso();
+			copy(str.begin(), str.end(), buff + len);
+			buff[total] = 0;
+			sso_len = uint8_t(total);
+			return;
+		}
+	}
+	
+	// In place
+	else if (data.s->refs <= 1 && total <= data.s->cap){
+		copy(str.begin(), str.end(), data.s->str + len);
+		data.s->str[total] = 0;
+		data.s->len = uint32_t(total);
+		return;
+	}
+	
+	// Reallocate. Reserve extra space only for uniquely owned strings which are being built up.
+	const bool grow = (sso_len == SSO_HEAP && data.s->refs <= 1);
+	const size_t cap = grow ? min(max(total, 2*len), size_t(UINT32_MAX - 1)) : total;
+	
+	unique_ptr<String> s = String::create(uint32_t(cap));
+	string_view old = sv();
+	copy(old.begin(), old.end(), s->str);
+	copy(str.begin(), str.end(), s->str + len);
+	s->str[total] = 0;
+	s->len = uint32_t(total);
+	
+	*this = Value(s.release());
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
 unique_ptr<Value::String> Value::String::create(uint32_t len){
 	len = min(len, UINT32_MAX - 1);
 	
-	void* mem = ::operator new(sizeof(String) + sizeof(*String::str)*(len + 1), align_val_t(alignof(String)));
+	const size_t size = block_size(sizeof(String) + sizeof(*String::str)*(size_t(len) + 1));
+	void* mem = pool_allocate(size);
 	unique_ptr str = unique_ptr<Value::String>(new (mem) String());
 	
+	str->cap = uint32_t(size - sizeof(String) - 1);
 	str->str[0] = 0;
 	str->str[len] = 0;
 	str->len = len;
 	return str;
 }
 
+void Value::String::operator delete(String* s, destroying_delete_t){
+	const size_t size = sizeof(String) + size_t(s->cap) + 1;
+	s->~String();
+	pool_deallocate(s, size);
+}
+
+
+void* Value::Object::operator new([[maybe_unused]] size_t size){
+	assert(size == sizeof(Object));
+	void* mem = ObjectPool::heap.allocate();
+	if (mem == nullptr)
+		throw bad_alloc();
+	return mem;
+}
+
+
+void Value::Object::operator delete(void* p) noexcept {
+	ObjectPool::heap.deallocate(p);
+}
+
+
 unique_ptr<Value::String> Value::String::create(string_view s1){
 	const size_t l1 = min(s1.length(), size_t(UINT32_MAX - 1));
 	unique_ptr<Value::String> s = create(uint32_t(l1));
@@ -267,7 +461,9 @@ void Value::Object::merge(const Object& o2){
 		return;
 	}
 	
-	arr.insert(arr.end(), o2.arr.begin(), o2.arr.end());
+	for (const Value& el : o2.arr){
+		arr.push_back(el);
+	}
 	for (auto p : o2.dict){
 		dict.insert(p.key, p.value);
 	}
@@ -317,7 +513,7 @@ bool Value::getBool() const noexcept {
 			return (!data.o->arr.empty() || !data.o->dict.empty());
 		
 		case Type::STRING: {
-			string_view s = data.s->sv();
+			string_view s = sv();
 			
 			if (s.length() == 4){
 				return strncasecmp(s.data(), "true", 4) == 0;
@@ -342,7 +538,7 @@ string Value::toStr() const {
 		case Type::DOUBLE:
 			return str(data.d);
 		case Type::STRING:
-			return string(string_view(*data.s));
+			return string(sv());
 		case Type::OBJECT:
 			return str(*data.o);
 	}
@@ -359,7 +555,7 @@ string& Value::toStr(string& buff) const {
 		case Type::DOUBLE:
 			return buff.append(str(data.d));
 		case Type::STRING:
-			return buff.append(string_view(*data.s));
+			return buff.append(sv());
 		case Type::OBJECT:
 			return buff.append(str(*data.o));
 	}
@@ -387,8 +583,7 @@ Value Value::cast_int() const noexcept {
 			return Value(static_cast<long>(data.d));
 		
 		case Type::STRING:
-			assert(data.s != nullptr);
-			return Value(atol(data.s->begin()));
+			return Value(atol(c_str()));
 		
 		case Type::OBJECT:
 			assert(data.o != nullptr);
@@ -411,8 +606,7 @@ Value Value::cast_float() const noexcept {
 			return Value(data.d);
 		
 		case Type::STRING:
-			assert(data.s != nullptr);
-			return Value(atof(data.s->begin()));
+			return Value(atof(c_str()));
 		
 		case Type::OBJECT:
 			assert(data.o != nullptr);
@@ -428,23 +622,25 @@ Value Value::cast_str() const {
 		case Type::NONE:
 			break;
 		
-		case Type::LONG:
-			return Value(Value::String::fmt(data.l).release());
+		case Type::LONG: {
+			char buff[24];
+			to_chars_result res = to_chars(buff, buff + sizeof(buff), data.l);
+			return Value(string_view(buff, res.ptr));
+		}
 		
 		case Type::DOUBLE:
-			return Value(Value::String::fmt(data.d).release());
+			return Value(str(data.d));
 		
 		case Type::STRING:
-			return Value(data.s);
+			return *this;
 		
 		case Type::OBJECT: {
 			assert(data.o != nullptr);
-			string x = str(*data.o);
-			return Value(Value::String::create(x).release());
+			return Value(str(*data.o));
 		} break;
 		
 	}
-	return Value(Value::String::create(0).release());
+	return Value(string_view());
 }
 
 
@@ -501,7 +697,7 @@ bool Value::equals(const Value& o) const noexcept {
 		
 		case Type::STRING: {
 			if (o.type == Type::STRING)
-				return string_view(*data.s) == string_view(*o.data.s);
+				return sv() == o.sv();
 			else
 				return false;
 		}
@@ -542,8 +738,7 @@ bool Value::semanticEquals(string_view s) const noexcept {
 		}
 		
 		case Type::STRING: [[likely]] {
-			assert(data.s != nullptr);
-			return (data.s->sv() == s);
+			return (sv() == s);
 		}
 		
 		case Type::OBJECT: {
@@ -563,7 +758,7 @@ bool Value::semanticEquals(string_view s) const noexcept {
 
 bool Value::semanticEquals(const Value& o) const noexcept {
 	if (o.type == Type::STRING){
-		return semanticEquals(string_view(*data.s));
+		return semanticEquals(o.sv());
 	}
 	
 	switch (type){
@@ -601,7 +796,7 @@ bool Value::semanticEquals(const Value& o) const noexcept {
 		} break;
 		
 		case Type::STRING: {
-			return o.semanticEquals(string_view(*data.s));
+			return o.semanticEquals(sv());
 		} break;
 		
 		case Type::OBJECT: {
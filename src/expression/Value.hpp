@@ -1,14 +1,21 @@
 #pragma once
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <array>
+#include <memory>
+#include <new>
+#include <string_view>
 #include <vector>
-#include "str_map.hpp"
+#include "persistent_vector.hpp"
+#include "persistent_map.hpp"
+#include "Stats.hpp"
 
 
 struct Value {
 // ----------------------------------- [ Structures ] --------------------------------------- //
 public:
-	enum class Type : uint32_t {
+	enum class Type : uint8_t {
 		NONE,
 		LONG,
 		DOUBLE,
@@ -19,15 +26,24 @@ public:
 	struct String;
 	struct Object;
 	
+// ----------------------------------- [ Constants ] ---------------------------------------- //
+public:
+	static constexpr uint8_t SSO_HEAP = UINT8_MAX;		// `sso_len` of strings stored in `data.s`.
+	static constexpr size_t SSO_CAPACITY = 13;			// Maximum length of inline strings, excluding null terminator.
+	static constexpr size_t STRING_POOLS = 4;			// Number of size classes of pooled heap strings.
+	
 // ------------------------------------[ Properties ] --------------------------------------- //
 public:
 	Type type = Type::NONE;
+	uint8_t sso_len = SSO_HEAP;		// Length of inline string or `SSO_HEAP`.
+	char sso_head[6] = {};			// Inline string, continued in `data.sso_tail`.
 	
 	union {
 		long l = 0;
 		double d;
-		String* s;
+		String* s;			// Heap string, if `sso_len == SSO_HEAP`.
 		Object* o;
+		char sso_tail[8];
 	} data;
 	
 // ---------------------------------- [ Constructors ] -------------------------------------- //
@@ -40,20 +56,83 @@ public:
 	Value(String* obj);
 	Value(Object* obj);
 	
-	Value(std::string_view s);							// Create owned c-string.
-	Value(std::string_view s1, std::string_view s2);	// Concat strings into owned c-string.
+	Value(std::string_view s);							// Create c-string, inline if short enough.
+	Value(std::string_view s1, std::string_view s2);	// Concat strings into c-string, inline if short enough.
 	
 public:
 	Value(const Value& o);
 	
-	Value(Value&& o){
-		std::swap(this->type, o.type);
-		std::swap(this->data, o.data);
+	Value(Value&& o) noexcept {
+		copyBits(o);
+		o.type = Type::NONE;
 	}
 	
 public:
 	~Value();
 	
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	/**
+	 * @brief Get content of a string value.
+	 * @note `type == Type::STRING`
+	 */
+	std::string_view sv() const noexcept;
+	
+	/**
+	 * @brief Get null terminated content of a string value.
+	 * @note `type == Type::STRING`
+	 */
+	const char* c_str() const noexcept;
+	
+	/**
+	 * @brief Get modifiable content of a string value.
+	 *        Shared heap strings are cloned first.
+	 * @note `type == Type::STRING`
+	 */
+	char* unique_str();
+	
+	/**
+	 * @brief Shorten string value to `len` characters.
+	 * @note `type == Type::STRING`
+	 */
+	void truncate(size_t len);
+	
+	/**
+	 * @brief Append `str` to a string value.
+	 *        Uniquely owned heap strings are extended in place and grow geometrically,
+	 *        so repeated appends take amortized linear time.
+	 * @note `type == Type::STRING`
+	 */
+	void append(std::string_view str);
+	
+	/**
+	 * @brief Get occupancy of the memory pools for heap strings and objects of the current thread.
+	 */
+	static std::array<PoolStats,STRING_POOLS + 1> pools();
+	
+private:
+	char* sso() noexcept {
+		return reinterpret_cast<char*>(this) + offsetof(Value, sso_head);
+	}
+	
+	const char* sso() const noexcept {
+		return reinterpret_cast<const char*>(this) + offsetof(Value, sso_head);
+	}
+	
+	void copyBits(const Value& o) noexcept {
+		type = o.type;
+		sso_len = o.sso_len;
+		std::copy(std::begin(o.sso_head), std::end(o.sso_head), sso_head);
+		data = o.data;
+	}
+	
+	void swapBits(Value& o) noexcept {
+		std::swap(type, o.type);
+		std::swap(sso_len, o.sso_len);
+		std::swap(sso_head, o.sso_head);
+		std::swap(data, o.data);
+	}
+	
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 public:
 	bool getBool() const noexcept;
@@ -87,9 +166,8 @@ public:
 		return *this;
 	}
 	
-	Value& operator=(Value&& o){
-		std::swap(this->type, o.type);
-		std::swap(this->data, o.data);
+	Value& operator=(Value&& o) noexcept {
+		swapBits(o);
 		return *this;
 	}
 
@@ -103,6 +181,7 @@ struct Value::String {
 public:
 	int refs = 0;
 	uint32_t len = 0;
+	uint32_t cap = 0;		// Allocated length of `str`, excluding null terminator.
 	char str[];				// C-string
 	
 // ---------------------------------------------------------------- //
@@ -148,6 +227,11 @@ public:
 	static std::unique_ptr<String> fmt(long val);
 	static std::unique_ptr<String> fmt(double val);
 	
+	/**
+	 * @brief Destroy string and return its memory to the pool of its size class.
+	 */
+	static void operator delete(String* s, std::destroying_delete_t);
+	
 // ---------------------------------------------------------------- //
 public:
 	explicit operator std::string_view() const {
@@ -159,11 +243,38 @@ public:
 
 
 
+static_assert(sizeof(Value) == 16);
+static_assert(offsetof(Value, data) == offsetof(Value, sso_head) + sizeof(Value::sso_head));
+static_assert(sizeof(Value::sso_head) + sizeof(Value::data) == Value::SSO_CAPACITY + 1);
+
+
+inline std::string_view Value::sv() const noexcept {
+	assert(type == Type::STRING);
+	if (sso_len != SSO_HEAP)
+		return std::string_view(sso(), sso_len);
+	return data.s->sv();
+}
+
+
+inline const char* Value::c_str() const noexcept {
+	assert(type == Type::STRING);
+	if (sso_len != SSO_HEAP)
+		return sso();
+	return data.s->str;
+}
+
+
+
+/**
+ * @brief Array and dictionary value.
+ *        Both are persistent structures, so copying a shared object before modifying it is O(1)
+ *        and modifications copy only the touched nodes.
+ */
 struct Value::Object {
 // ---------------------------------------------------------------- //
 public:
-	std::vector<Value> arr;
-	str_map<Value> dict;
+	persistent_vector<Value> arr;
+	persistent_map<Value> dict;
 	int refs = 0;
 	
 // ---------------------------------------------------------------- //
@@ -193,19 +304,11 @@ public:
 		return std::make_unique<Object>();
 	}
 	
+	static void* operator new(size_t size);
+	static void operator delete(void* p) noexcept;
+	
 // ---------------------------------------------------------------- //
 public:
-	/**
-	 * @brief Retrieve value of the underlying array.
-	 * @return Pointer to array element or `null`.
-	 */
-	Value* get(long index){
-		const size_t i = (index < 0) ? (arr.size() + index) : size_t(index);
-		if (i < arr.size())
-			return &arr[i];
-		return nullptr;
-	}
-	
 	/**
 	 * @brief Retrieve value of the underlying array.
 	 * @return Pointer to array element or `null`.
@@ -217,15 +320,6 @@ public:
 		return nullptr;
 	}
 	
-	/**
-	 * @brief Retrieve entry value of the underlying dictionary.
-	 * @param property Dictionary key.
-	 * @return Pointer to dictionary element or `null`.
-	 */
-	Value* get(std::string_view property){
-		return dict.get(property);
-	}
-	
 	/**
 	 * @brief Retrieve entry value of the underlying dictionary.
 	 * @param property Dictionary key.
@@ -250,10 +344,7 @@ public:
 	 * @param value Element.
 	 */
 	Value& insert(size_t index, Value&& el){
-		if (index >= arr.size())
-			return arr.emplace_back(std::move(el));
-		else
-			return *arr.insert(arr.begin() + index, std::move(el));
+		return arr.insert(index, std::move(el));
 	}
 	
 	/**
@@ -271,10 +362,7 @@ public:
 	 * @param count Amount of elements to remove after `index`.
 	 */
 	void remove(size_t index, size_t count = 1){
-		if (index < arr.size()){
-			size_t e = std::min(arr.size(), index + count);
-			arr.erase(arr.begin() + index, arr.begin() + e);
-		}
+		arr.erase(index, count);
 	}
 	
 	/**
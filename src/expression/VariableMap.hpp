@@ -0,0 +1,143 @@
+#pragma once
+#include <vector>
+#include "Value.hpp"
+#include "Symbol.hpp"
+
+
+/**
+ * @brief Expression variables, indexed by interned `Symbol` of the variable name.
+ *        Lookup by symbol is a plain array access. Lookup by name first resolves the symbol.
+ * @note Inserting a variable may invalidate pointers returned by `get()`.
+ */
+class VariableMap {
+// ----------------------------------- [ Structures ] --------------------------------------- //
+private:
+	struct Slot {
+		Value value;
+		bool defined = false;
+	};
+
+public:
+	/**
+	 * @brief Variables read while the trace is attached to the map.
+	 *        Only the first read of each variable is recorded, together with its value at that time.
+	 */
+	struct Trace {
+		struct Read {
+			Symbol sym;
+			bool defined;
+			Value value;
+		};
+		
+		std::vector<Read> reads;
+		std::vector<bool> seen;		// Indexed by symbol.
+		bool valid = true;			// Cleared by readers which can't be traced, such as unknown names.
+	};
+
+// ------------------------------------[ Properties ] --------------------------------------- //
+private:
+	std::vector<Slot> slots;
+	size_t defined = 0;		// Number of defined variables.
+
+public:
+	Trace* trace = nullptr;	// Records reads by `get()` while not `nullptr`.
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	Value* get(Symbol sym) noexcept {
+		Value* val = (sym < slots.size() && slots[sym].defined) ? &slots[sym].value : nullptr;
+		if (trace != nullptr) [[unlikely]]
+			record(sym, val);
+		return val;
+	}
+	
+	const Value* get(Symbol sym) const noexcept {
+		const Value* val = (sym < slots.size() && slots[sym].defined) ? &slots[sym].value : nullptr;
+		if (trace != nullptr) [[unlikely]]
+			record(sym, val);
+		return val;
+	}
+	
+	Value* get(std::string_view name) noexcept {
+		return get(Symbols::find(name));
+	}
+	
+	const Value* get(std::string_view name) const noexcept {
+		return get(Symbols::find(name));
+	}
+
+public:
+	template<typename ...ARG>
+	Value& insert(Symbol sym, ARG&& ...args){
+		assert(sym != Symbols::NONE);
+		if (sym >= slots.size()){
+			slots.resize(std::max(size_t(sym) + 1, Symbols::count()));
+		}
+		
+		Slot& slot = slots[sym];
+		slot.value = Value(std::forward<ARG>(args)...);
+		
+		if (!slot.defined){
+			slot.defined = true;
+			defined++;
+		}
+		
+		return slot.value;
+	}
+	
+	template<typename ...ARG>
+	Value& insert(std::string_view name, ARG&& ...args){
+		return insert(Symbols::intern(name), std::forward<ARG>(args)...);
+	}
+	
+	bool remove(Symbol sym){
+		if (sym >= slots.size() || !slots[sym].defined){
+			return false;
+		}
+		
+		slots[sym].value = Value();
+		slots[sym].defined = false;
+		defined--;
+		return true;
+	}
+	
+	bool remove(std::string_view name){
+		return remove(Symbols::find(name));
+	}
+
+public:
+	bool empty() const noexcept {
+		return defined == 0;
+	}
+	
+	size_t size() const noexcept {
+		return defined;
+	}
+	
+	void clear(){
+		slots.clear();
+		defined = 0;
+	}
+
+private:
+	void record(Symbol sym, const Value* val) const {
+		if (sym == Symbols::NONE){
+			trace->valid = false;
+			return;
+		}
+		
+		if (sym >= trace->seen.size()){
+			trace->seen.resize(std::max(size_t(sym) + 1, Symbols::count()));
+		} else if (trace->seen[sym]){
+			return;
+		}
+		
+		trace->seen[sym] = true;
+		if (val != nullptr)
+			trace->reads.emplace_back(sym, true, *val);
+		else
+			trace->reads.emplace_back(sym, false, Value());
+	}
+
+// ------------------------------------------------------------------------------------------ //
+};
@@ -12,7 +12,9 @@ using namespace std;
 bool fs::readStream(istream& in, string& buff){
 	array<char,4096> _buff;
 	
-	while (in.read(_buff.data(), _buff.size())){
+	// Last read hits the end of stream and fails, but still reads the remaining part.
+	while (true){
+		in.read(_buff.data(), _buff.size());
 		const streamsize n = in.gcount();
 		
 		if (n < 0){
@@ -24,7 +26,7 @@ bool fs::readStream(istream& in, string& buff){
 		buff.append(_buff.data(), size_t(n));
 	}
 	
-	return true;
+	return !in.bad();
 }
 
 
@@ -79,8 +79,9 @@ public:
 		}
 		
 		else if (pages == nullptr || pages->size >= pages->capacity){
-			const size_t cap = (pages != nullptr) ? pages->capacity*2 : MIN_PAGE;
-			const size_t mem = (cap < MAX_PAGE ? cap : MAX_PAGE) * sizeof(T);
+			size_t cap = (pages != nullptr) ? pages->capacity*2 : MIN_PAGE;
+			cap = (cap < MAX_PAGE) ? cap : MAX_PAGE;
+			const size_t mem = cap * sizeof(T);
 			
 			Page* page = reinterpret_cast<Page*>(operator new(sizeof(Page) + mem, std::align_val_t(alignof(Page))));
 			page->capacity = cap;
@@ -26,7 +26,8 @@ enum class html::NodeType : uint8_t {
 	DIRECTIVE,	// <! ... >
 	COMMENT,	// <!-- ... -->
 	TEXT,		// <...>text</...>
-	ROOT		// Internal for marking root.
+	ROOT,		// Internal for marking root.
+	BORROWED	// Internal reference to a node of another document, written in its place together with its subtree.
 };
 
 
@@ -39,6 +40,7 @@ enum class html::NodeOptions : uint8_t {
 	SELF_CLOSE    = 1 << 4, // <tag/>
 	SPACE_BEFORE  = 1 << 5, // Node is prefixed (before opening tag) with whitespace.
 	SPACE_AFTER   = 1 << 6, // Node is suffixed (after closing tag) with whitespace.
+	STATIC        = 1 << 7, // Node and its subtree are copied unchanged by the document user, and can be borrowed.
 };
 ENUM_OPERATORS(html::NodeOptions);
 
@@ -91,9 +93,13 @@ struct html::Node {
 public:
 	NodeType type = NodeType::TAG;
 	NodeOptions options = NodeOptions::NONE;
+	uint8_t op = 0;					// Opcode resolved from the name by the document user, 0 if unresolved.
 	
 	uint32_t value_len = 0;			// Length of `value_p`.
-	const char* value_p = nullptr;	// Unterminated name/value string.
+	union {
+		const char* value_p = nullptr;	// Unterminated name/value string.
+		const Node* borrowed;			// Source node of `NodeType::BORROWED`, owned by another document.
+	};
 	
 	Node* parent = nullptr;
 	Node* child = nullptr;			// First/last child in linked list.
@@ -190,6 +196,7 @@ struct html::Attr {
 // ------------------------------------[ Properties ] --------------------------------------- //
 public:
 	NodeOptions options = NodeOptions::NONE;
+	uint8_t op = 0;			// Opcode resolved from the name by the document user, 0 if unresolved.
 	
 	uint16_t name_len = 0;
 	uint32_t value_len = 0;
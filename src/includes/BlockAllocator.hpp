@@ -2,8 +2,13 @@
 #include <cassert>
 #include <cstdint>
 #include <algorithm>
+#include <new>
 
 
+/**
+ * @brief Pool of fixed size blocks, carved from pages of up to `MAX_PAGE_SIZE` bytes.
+ *        Freed blocks are kept in a free list and reused before taking new blocks from a page.
+ */
 template<size_t BLOCK_SIZE, size_t BLOCK_ALIGN>
 struct BlockAllocator {
 // ----------------------------------- [ Constants ] ---------------------------------------- //
@@ -36,18 +41,34 @@ public:
 	Page* pages = nullptr;			// Linked list of pages.
 	Block* emptyBlocks = nullptr;	// Linked list of empty blocks.
 	
+	size_t used = 0;				// Number of blocks currently allocated.
+	size_t peak = 0;				// Maximum of `used`.
+	size_t capacity = 0;			// Number of blocks in all pages.
+	
 public:
-	static BlockAllocator heap;		// Global heap of a specific allocator.
+	static thread_local BlockAllocator heap;	// Heap of a specific allocator for the current thread.
 	
 // ---------------------------------- [ Constructors ] -------------------------------------- //
 public:
+	constexpr BlockAllocator() = default;
+	BlockAllocator(const BlockAllocator&) = delete;
+	
 	~BlockAllocator(){
+		// Blocks may still be owned by objects destroyed later during static destruction.
+		if (used > 0){
+			return;
+		}
+		
 		Page* p = pages;
 		while (p != nullptr){
 			Page* next = p->next;
-			delete p;
+			::operator delete(p, std::align_val_t(alignof(Page)));
 			p = next;
 		}
+		
+		pages = nullptr;
+		emptyBlocks = nullptr;
+		capacity = 0;
 	}
 	
 // ----------------------------------- [ Functions ] ---------------------------------------- //
@@ -57,6 +78,7 @@ public:
 		if (emptyBlocks != nullptr){
 			Block* b = emptyBlocks;
 			emptyBlocks = emptyBlocks->next;
+			track();
 			return &b->obj;
 		}
 		
@@ -67,10 +89,12 @@ public:
 				return nullptr;
 			newPage->next = pages;
 			pages = newPage;
+			capacity += newPage->size;
 		}
 		
 		// Take from last page
 		Block& b = pages->memory[pages->count++];
+		track();
 		return &b.obj;
 	}
 	
@@ -78,9 +102,11 @@ public:
 	void deallocate(void* p) noexcept {
 		assert(p != nullptr);
 		assert(contains(p) && "Allocation not found.");
+		assert(used > 0);
 		Block* b = reinterpret_cast<Block*>(p);
 		b->next = emptyBlocks;
 		emptyBlocks = b;
+		used--;
 	}
 	
 public:
@@ -101,12 +127,17 @@ public:
 	
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 private:
+	void track() noexcept {
+		used++;
+		peak = std::max(peak, used);
+	}
+	
 	Page* createPage() const noexcept {
-		constexpr size_t mem_available = std::max(MAX_PAGE_SIZE - sizeof(Page), MIN_ELEMENTS_PER_PAGE * BLOCK_SIZE);
-		constexpr size_t count = mem_available / BLOCK_SIZE;
-		constexpr size_t mem_size = sizeof(Page) + (count *BLOCK_SIZE);
+		constexpr size_t mem_available = std::max(MAX_PAGE_SIZE - sizeof(Page), MIN_ELEMENTS_PER_PAGE * sizeof(Block));
+		constexpr size_t count = mem_available / sizeof(Block);
+		constexpr size_t mem_size = sizeof(Page) + (count * sizeof(Block));
 		
-		Page* p = (Page*)::operator new(mem_size, std::align_val_t(BLOCK_ALIGN), std::nothrow_t());
+		Page* p = (Page*)::operator new(mem_size, std::align_val_t(alignof(Page)), std::nothrow_t());
 		if (p != nullptr){
 			p->size = count;
 			p->count = 0;
@@ -117,3 +148,7 @@ private:
 
 // ------------------------------------------------------------------------------------------ //
 };
+
+
+template<size_t BLOCK_SIZE, size_t BLOCK_ALIGN>
+constinit thread_local BlockAllocator<BLOCK_SIZE,BLOCK_ALIGN> BlockAllocator<BLOCK_SIZE,BLOCK_ALIGN>::heap;
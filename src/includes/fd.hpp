@@ -1,4 +1,6 @@
+#pragma once
 #include <unistd.h>
+#include <fcntl.h>
 
 
 namespace fs {
@@ -61,9 +63,10 @@ namespace fs {
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 	
 
+// Closed on exec, so pipes don't leak into processes started by other threads.
 inline bool pipe(FileDesc& fd0, FileDesc& fd1) noexcept {
 	int fd[2];
-	if (::pipe(fd) == 0){
+	if (::pipe2(fd, O_CLOEXEC) == 0){
 		fd0 = FileDesc(fd[0]);
 		fd1 = FileDesc(fd[1]);
 		return true;
@@ -0,0 +1,539 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <bit>
+#include <new>
+#include <string_view>
+#include <utility>
+
+
+/**
+ * @brief Persistent string keyed hash map with structural sharing (hash array mapped trie).
+ *        Each level of the trie consumes 5 bits of the key hash, and nodes store only the occupied slots.
+ *        Copying the map is O(1), nodes and entries are shared and reference counted.
+ *        Modifications copy only the nodes on the path to the modified entry, and only if they are shared.
+ */
+template<typename T>
+class persistent_map {
+// ----------------------------------- [ Constants ] ---------------------------------------- //
+public:
+	static constexpr uint32_t BITS = 5;
+	static constexpr uint32_t MASK = (1 << BITS) - 1;
+	static constexpr uint32_t MAX_SHIFT = 64;		// Entries with equal hashes are stored in collision nodes.
+
+// ----------------------------------- [ Structures ] --------------------------------------- //
+public:
+	struct Entry {
+		uint32_t refs = 1;
+		uint32_t len = 0;		// Length of `key`.
+		size_t hash = 0;
+		T value;
+		char key[];				// c-string
+		
+		std::string_view name() const noexcept {
+			return std::string_view(key, len);
+		}
+	};
+
+private:
+	struct Node;
+	
+	union Slot {
+		Entry* entry;
+		Node* node;
+	};
+	
+	/**
+	 * @brief Trie node. Slots hold entries first, followed by child nodes.
+	 */
+	struct Node {
+		uint32_t refs = 1;
+		uint32_t datamap = 0;	// Bitmap of slots holding entries.
+		uint32_t nodemap = 0;	// Bitmap of slots holding child nodes.
+		uint32_t ndata = 0;		// Number of entries.
+		uint32_t nnode = 0;		// Number of child nodes.
+		Slot slots[];
+	};
+
+public:
+	class const_iterator;
+
+// ------------------------------------[ Properties ] --------------------------------------- //
+private:
+	Node* root = nullptr;
+	size_t count = 0;
+
+// ---------------------------------- [ Constructors ] -------------------------------------- //
+public:
+	persistent_map() = default;
+	
+	persistent_map(const persistent_map& o) : root{o.root}, count{o.count} {
+		if (root != nullptr)
+			root->refs++;
+	}
+	
+	persistent_map(persistent_map&& o) noexcept {
+		swap(o);
+	}
+	
+	~persistent_map(){
+		release(root);
+	}
+	
+	persistent_map& operator=(const persistent_map& o){
+		persistent_map tmp = o;
+		swap(tmp);
+		return *this;
+	}
+	
+	persistent_map& operator=(persistent_map&& o) noexcept {
+		swap(o);
+		return *this;
+	}
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	size_t size() const noexcept {
+		return count;
+	}
+	
+	bool empty() const noexcept {
+		return count == 0;
+	}
+	
+	const T* get(std::string_view key) const noexcept {
+		const size_t hash = std::hash<std::string_view>()(key);
+		const Node* node = root;
+		
+		for (uint32_t shift = 0 ; node != nullptr ; shift += BITS){
+			if (shift >= MAX_SHIFT){
+				for (uint32_t i = 0 ; i < node->ndata ; i++){
+					const Entry* e = node->slots[i].entry;
+					if (e->hash == hash && e->name() == key)
+						return &e->value;
+				}
+				return nullptr;
+			}
+			
+			const uint32_t bit = 1u << ((hash >> shift) & MASK);
+			if (node->datamap & bit){
+				const Entry* e = node->slots[index(node->datamap, bit)].entry;
+				if (e->hash == hash && e->name() == key)
+					return &e->value;
+				return nullptr;
+			} else if (node->nodemap & bit){
+				node = node->slots[node->ndata + index(node->nodemap, bit)].node;
+			} else {
+				return nullptr;
+			}
+		
+		}
+		
+		return nullptr;
+	}
+	
+	const_iterator begin() const noexcept {
+		return const_iterator(root);
+	}
+	
+	const_iterator end() const noexcept {
+		return const_iterator(nullptr);
+	}
+	
+	void swap(persistent_map& o) noexcept {
+		std::swap(root, o.root);
+		std::swap(count, o.count);
+	}
+
+public:
+	/**
+	 * @brief Insert or replace entry.
+	 * @return Reference to the value of the entry.
+	 */
+	template<typename ...ARG>
+	T& insert(std::string_view key, ARG&& ...args){
+		const size_t hash = std::hash<std::string_view>()(key);
+		Entry* e = createEntry(key, hash, std::forward<ARG>(args)...);
+		
+		if (root == nullptr){
+			root = createNode(0, 0);
+		}
+		
+		root = insert(root, e, 0);
+		return e->value;
+	}
+	
+	/**
+	 * @brief Remove entry.
+	 * @return `true` if entry was found and removed.
+	 */
+	bool remove(std::string_view key){
+		if (root == nullptr || get(key) == nullptr){
+			return false;
+		}
+		
+		const size_t hash = std::hash<std::string_view>()(key);
+		root = remove(root, key, hash, 0);
+		count--;
+		return true;
+	}
+	
+	void clear(){
+		persistent_map tmp;
+		swap(tmp);
+	}
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+private:
+	static uint32_t index(uint32_t bitmap, uint32_t bit) noexcept {
+		return uint32_t(std::popcount(bitmap & (bit - 1)));
+	}
+	
+	template<typename ...ARG>
+	static Entry* createEntry(std::string_view key, size_t hash, ARG&& ...args){
+		void* mem = ::operator new(sizeof(Entry) + key.length() + 1, std::align_val_t(alignof(Entry)));
+		Entry* e = static_cast<Entry*>(mem);
+		
+		e->refs = 1;
+		e->len = uint32_t(key.length());
+		e->hash = hash;
+		new (&e->value) T(std::forward<ARG>(args)...);
+		
+		memcpy(e->key, key.data(), key.length());
+		e->key[key.length()] = 0;
+		return e;
+	}
+	
+	static void release(Entry* e) noexcept {
+		if (--e->refs > 0){
+			return;
+		}
+		e->value.~T();
+		::operator delete(e, std::align_val_t(alignof(Entry)));
+	}
+	
+	static Node* createNode(uint32_t ndata, uint32_t nnode){
+		void* mem = ::operator new(sizeof(Node) + sizeof(Slot)*(ndata + nnode), std::align_val_t(alignof(Node)));
+		Node* node = new (mem) Node();
+		node->ndata = ndata;
+		node->nnode = nnode;
+		return node;
+	}
+	
+	static void destroyNode(Node* node) noexcept {
+		node->~Node();
+		::operator delete(node, std::align_val_t(alignof(Node)));
+	}
+	
+	static void release(Node* node) noexcept {
+		if (node == nullptr || --node->refs > 0){
+			return;
+		}
+		
+		for (uint32_t i = 0 ; i < node->ndata ; i++)
+			release(node->slots[i].entry);
+		for (uint32_t i = 0 ; i < node->nnode ; i++)
+			release(node->slots[node->ndata + i].node);
+		destroyNode(node);
+	}
+	
+	/**
+	 * @brief Copy node with a different number of slots. Slots are copied by `copy(src, dst)`.
+	 *        The new node takes over references of all slots of `node`, callers must release the slots they drop.
+	 */
+	template<typename F>
+	static Node* resize(Node* node, uint32_t ndata, uint32_t nnode, F&& copy){
+		Node* res = createNode(ndata, nnode);
+		res->datamap = node->datamap;
+		res->nodemap = node->nodemap;
+		copy(node->slots, res->slots);
+		
+		// Acquire references of slots still held by the shared original node.
+		if (node->refs > 1){
+			for (uint32_t i = 0 ; i < node->ndata ; i++)
+				node->slots[i].entry->refs++;
+			for (uint32_t i = 0 ; i < node->nnode ; i++)
+				node->slots[node->ndata + i].node->refs++;
+			node->refs--;
+		} else {
+			destroyNode(node);
+		}
+		
+		return res;
+	}
+	
+	/**
+	 * @brief Get node which can be modified. Shared nodes are copied.
+	 */
+	static Node* unique(Node* node){
+		if (node->refs <= 1){
+			return node;
+		}
+		
+		const uint32_t n = node->ndata + node->nnode;
+		return resize(node, node->ndata, node->nnode, [n](const Slot* src, Slot* dst){
+			std::copy(src, src + n, dst);
+		});
+	}
+	
+	/**
+	 * @brief Create node holding two entries with different keys.
+	 */
+	static Node* merge(Entry* a, Entry* b, uint32_t shift){
+		if (shift >= MAX_SHIFT){
+			Node* node = createNode(2, 0);
+			node->slots[0].entry = a;
+			node->slots[1].entry = b;
+			return node;
+		}
+		
+		const uint32_t bit_a = 1u << ((a->hash >> shift) & MASK);
+		const uint32_t bit_b = 1u << ((b->hash >> shift) & MASK);
+		
+		if (bit_a == bit_b){
+			Node* node = createNode(0, 1);
+			node->nodemap = bit_a;
+			node->slots[0].node = merge(a, b, shift + BITS);
+			return node;
+		}
+		
+		Node* node = createNode(2, 0);
+		node->datamap = bit_a | bit_b;
+		node->slots[(bit_a < bit_b) ? 0 : 1].entry = a;
+		node->slots[(bit_a < bit_b) ? 1 : 0].entry = b;
+		return node;
+	}
+	
+	/**
+	 * @brief Insert entry `e` into `node` at level `shift`.
+	 * @return Modified node which replaces `node`.
+	 */
+	Node* insert(Node* node, Entry* e, uint32_t shift){
+	
+		// Collision node
+		if (shift >= MAX_SHIFT){
+			for (uint32_t i = 0 ; i < node->ndata ; i++){
+				if (node->slots[i].entry->name() == e->name()){
+					node = unique(node);
+					release(node->slots[i].entry);
+					node->slots[i].entry = e;
+					return node;
+				}
+			}
+			
+			count++;
+			const uint32_t n = node->ndata;
+			node = resize(node, n + 1, 0, [n](const Slot* src, Slot* dst){
+				std::copy(src, src + n, dst);
+			});
+			node->slots[n].entry = e;
+			return node;
+		}
+		
+		const uint32_t bit = 1u << ((e->hash >> shift) & MASK);
+		
+		// Replace or push down existing entry
+		if (node->datamap & bit){
+			const uint32_t i = index(node->datamap, bit);
+			Entry* old = node->slots[i].entry;
+			
+			if (old->hash == e->hash && old->name() == e->name()){
+				node = unique(node);
+				release(old);
+				node->slots[i].entry = e;
+				return node;
+			}
+			
+			// Move entry into a new child node.
+			count++;
+			const uint32_t nd = node->ndata;
+			const uint32_t nn = node->nnode;
+			const uint32_t j = index(node->nodemap, bit);
+			
+			Node* child = merge(old, e, shift + BITS);
+			node = resize(node, nd - 1, nn + 1, [=](const Slot* src, Slot* dst){
+				std::copy(src, src + i, dst);
+				std::copy(src + i + 1, src + nd + j, dst + i);
+				std::copy(src + nd + j, src + nd + nn, dst + nd + j);
+			});
+			
+			node->datamap &= ~bit;
+			node->nodemap |= bit;
+			node->slots[nd - 1 + j].node = child;
+			return node;
+		}
+		
+		// Insert into child node
+		else if (node->nodemap & bit){
+			node = unique(node);
+			Slot& slot = node->slots[node->ndata + index(node->nodemap, bit)];
+			slot.node = insert(slot.node, e, shift + BITS);
+			return node;
+		}
+		
+		// Insert new entry
+		count++;
+		const uint32_t nd = node->ndata;
+		const uint32_t nn = node->nnode;
+		const uint32_t i = index(node->datamap, bit);
+		
+		node = resize(node, nd + 1, nn, [=](const Slot* src, Slot* dst){
+			std::copy(src, src + i, dst);
+			std::copy(src + i, src + nd + nn, dst + i + 1);
+		});
+		
+		node->datamap |= bit;
+		node->slots[i].entry = e;
+		return node;
+	}
+	
+	/**
+	 * @brief Remove existing entry from `node` at level `shift`.
+	 * @return Modified node which replaces `node`, or `nullptr` if the node is left empty.
+	 */
+	Node* remove(Node* node, std::string_view key, size_t hash, uint32_t shift){
+		const uint32_t nd = node->ndata;
+		const uint32_t nn = node->nnode;
+		
+		// Collision node
+		if (shift >= MAX_SHIFT){
+			uint32_t i = 0;
+			while (node->slots[i].entry->name() != key){
+				i++;
+				assert(i < nd);
+			}
+			
+			Entry* old = node->slots[i].entry;
+			node = resize(node, nd - 1, 0, [=](const Slot* src, Slot* dst){
+				std::copy(src, src + i, dst);
+				std::copy(src + i + 1, src + nd, dst + i);
+			});
+			
+			release(old);
+			return (nd > 1) ? node : (destroyNode(node), nullptr);
+		}
+		
+		const uint32_t bit = 1u << ((hash >> shift) & MASK);
+		
+		if (node->datamap & bit){
+			const uint32_t i = index(node->datamap, bit);
+			
+			Entry* old = node->slots[i].entry;
+			node = resize(node, nd - 1, nn, [=](const Slot* src, Slot* dst){
+				std::copy(src, src + i, dst);
+				std::copy(src + i + 1, src + nd + nn, dst + i);
+			});
+			
+			release(old);
+			node->datamap &= ~bit;
+		}
+		
+		else {
+			assert(node->nodemap & bit);
+			node = unique(node);
+			
+			const uint32_t j = index(node->nodemap, bit);
+			Node* child = remove(node->slots[nd + j].node, key, hash, shift + BITS);
+			
+			if (child != nullptr){
+				node->slots[nd + j].node = child;
+				return node;
+			}
+			
+			// Drop empty child node, its reference was released by `remove()`.
+			node = resize(node, nd, nn - 1, [=](const Slot* src, Slot* dst){
+				std::copy(src, src + nd + j, dst);
+				std::copy(src + nd + j + 1, src + nd + nn, dst + nd + j);
+			});
+			node->nodemap &= ~bit;
+		}
+		
+		if (node->ndata + node->nnode == 0){
+			destroyNode(node);
+			return nullptr;
+		}
+		
+		return node;
+	}
+
+// ------------------------------------------------------------------------------------------ //
+};
+
+
+
+template<typename T>
+class persistent_map<T>::const_iterator {
+// ---------------------------------------------------------------- //
+public:
+	struct Pair {
+		std::string_view key;
+		const T& value;
+	};
+
+private:
+	static constexpr uint32_t MAX_DEPTH = MAX_SHIFT / BITS + 2;
+	
+	struct Frame {
+		const Node* node;
+		uint32_t i;		// Index of the next slot.
+	};
+	
+	Frame stack[MAX_DEPTH];
+	uint32_t depth = 0;
+	const Entry* entry = nullptr;
+
+// ---------------------------------------------------------------- //
+public:
+	const_iterator(const Node* root){
+		if (root != nullptr){
+			stack[depth++] = Frame{ root, 0 };
+			next();
+		}
+	}
+
+// ---------------------------------------------------------------- //
+public:
+	Pair operator*() const noexcept {
+		return Pair { .key = entry->name(), .value = entry->value };
+	}
+	
+	const_iterator& operator++() noexcept {
+		next();
+		return *this;
+	}
+	
+	bool operator==(const const_iterator& o) const noexcept {
+		return entry == o.entry;
+	}
+	
+	bool operator!=(const const_iterator& o) const noexcept {
+		return entry != o.entry;
+	}
+
+// ---------------------------------------------------------------- //
+private:
+	/**
+	 * @brief Advance to the next entry in depth first order.
+	 */
+	void next() noexcept {
+		while (depth > 0){
+			Frame& f = stack[depth - 1];
+			
+			if (f.i < f.node->ndata){
+				entry = f.node->slots[f.i++].entry;
+				return;
+			} else if (f.i < f.node->ndata + f.node->nnode){
+				const Node* child = f.node->slots[f.i++].node;
+				assert(depth < MAX_DEPTH);
+				stack[depth++] = Frame{ child, 0 };
+			} else {
+				depth--;
+			}
+		
+		}
+		entry = nullptr;
+	}
+
+// ---------------------------------------------------------------- //
+};
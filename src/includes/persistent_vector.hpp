@@ -0,0 +1,471 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+
+/**
+ * @brief Persistent vector with structural sharing.
+ *        Elements are stored in leaves of a 32-way trie, with the last partial leaf kept aside as the `tail`.
+ *        Copying the vector is O(1), nodes are shared and reference counted.
+ *        Modifications copy only the nodes on the path to the modified element, and only if they are shared.
+ * @note Inserting or erasing in the middle rebuilds the vector in O(n).
+ */
+template<typename T>
+class persistent_vector {
+// ----------------------------------- [ Constants ] ---------------------------------------- //
+public:
+	static constexpr uint32_t BITS = 5;
+	static constexpr size_t WIDTH = size_t(1) << BITS;
+	static constexpr size_t MASK = WIDTH - 1;
+
+// ----------------------------------- [ Structures ] --------------------------------------- //
+private:
+	struct Node {
+		uint32_t refs = 1;
+		uint32_t count = 0;		// Number of children or constructed elements.
+	};
+	
+	struct Branch : Node {
+		Node* child[WIDTH];
+	};
+	
+	struct Leaf : Node {
+		alignas(T)
+		std::byte mem[WIDTH * sizeof(T)];
+		
+		T* items() noexcept {
+			return std::launder(reinterpret_cast<T*>(mem));
+		}
+		
+		const T* items() const noexcept {
+			return std::launder(reinterpret_cast<const T*>(mem));
+		}
+		
+		~Leaf(){
+			T* p = items();
+			for (uint32_t i = 0 ; i < this->count ; i++)
+				p[i].~T();
+		}
+	};
+
+public:
+	class const_iterator;
+
+// ------------------------------------[ Properties ] --------------------------------------- //
+private:
+	Node* root = nullptr;	// Trie of full leaves.
+	Leaf* tail = nullptr;	// Last partial leaf.
+	size_t len = 0;
+	uint32_t shift = 0;		// Level of `root`. Leaves are at level 0.
+
+// ---------------------------------- [ Constructors ] -------------------------------------- //
+public:
+	persistent_vector() = default;
+	
+	persistent_vector(const persistent_vector& o) : root{o.root}, tail{o.tail}, len{o.len}, shift{o.shift} {
+		if (root != nullptr)
+			root->refs++;
+		if (tail != nullptr)
+			tail->refs++;
+	}
+	
+	persistent_vector(persistent_vector&& o) noexcept {
+		swap(o);
+	}
+	
+	~persistent_vector(){
+		release(root, shift);
+		release(tail, 0);
+	}
+	
+	persistent_vector& operator=(const persistent_vector& o){
+		persistent_vector tmp = o;
+		swap(tmp);
+		return *this;
+	}
+	
+	persistent_vector& operator=(persistent_vector&& o) noexcept {
+		swap(o);
+		return *this;
+	}
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	size_t size() const noexcept {
+		return len;
+	}
+	
+	bool empty() const noexcept {
+		return len == 0;
+	}
+	
+	const T& operator[](size_t i) const noexcept {
+		assert(i < len);
+		return leaf(i)[i & MASK];
+	}
+	
+	const T& back() const noexcept {
+		return (*this)[len - 1];
+	}
+	
+	const_iterator begin() const noexcept {
+		return const_iterator(*this, 0);
+	}
+	
+	const_iterator end() const noexcept {
+		return const_iterator(*this, len);
+	}
+	
+	void swap(persistent_vector& o) noexcept {
+		std::swap(root, o.root);
+		std::swap(tail, o.tail);
+		std::swap(len, o.len);
+		std::swap(shift, o.shift);
+	}
+
+public:
+	/**
+	 * @brief Get modifiable element, copying the path to it if shared.
+	 */
+	T& mut(size_t i){
+		assert(i < len);
+		const size_t off = tailOffset();
+		if (i >= off){
+			tail = unique(tail);
+			return tail->items()[i - off];
+		}
+		return mut(root, shift, i);
+	}
+	
+	template<typename ...ARG>
+	T& emplace_back(ARG&& ...args){
+		if (tail != nullptr && tail->count >= WIDTH){
+			pushTail();
+		}
+		
+		if (tail == nullptr){
+			tail = new Leaf();
+		} else {
+			tail = unique(tail);
+		}
+		
+		T* p = new (&tail->items()[tail->count]) T(std::forward<ARG>(args)...);
+		tail->count++;
+		len++;
+		return *p;
+	}
+	
+	T& push_back(const T& val){
+		return emplace_back(val);
+	}
+	
+	T& push_back(T&& val){
+		return emplace_back(std::move(val));
+	}
+	
+	void pop_back(){
+		assert(len > 0);
+		
+		if (tail == nullptr || tail->count == 0){
+			popTail();
+		}
+		
+		tail = unique(tail);
+		tail->count--;
+		tail->items()[tail->count].~T();
+		len--;
+	}
+	
+	/**
+	 * @brief Insert element before index `i`.
+	 * @note O(1) at the end, otherwise O(n).
+	 */
+	T& insert(size_t i, T&& val){
+		if (i >= len){
+			return emplace_back(std::move(val));
+		}
+		
+		persistent_vector res;
+		for (size_t j = 0 ; j < i ; j++)
+			res.emplace_back((*this)[j]);
+		res.emplace_back(std::move(val));
+		for (size_t j = i ; j < len ; j++)
+			res.emplace_back((*this)[j]);
+		
+		swap(res);
+		return mut(i);
+	}
+	
+	/**
+	 * @brief Remove `count` elements starting at index `i`.
+	 * @note O(count) at the end, otherwise O(n).
+	 */
+	void erase(size_t i, size_t count = 1){
+		if (i >= len){
+			return;
+		}
+		
+		const size_t e = (count < len - i) ? i + count : len;
+		if (e == len){
+			while (len > i)
+				pop_back();
+			return;
+		}
+		
+		persistent_vector res;
+		for (size_t j = 0 ; j < i ; j++)
+			res.emplace_back((*this)[j]);
+		for (size_t j = e ; j < len ; j++)
+			res.emplace_back((*this)[j]);
+		swap(res);
+	}
+	
+	void clear(){
+		persistent_vector tmp;
+		swap(tmp);
+	}
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+private:
+	size_t tailOffset() const noexcept {
+		return len - ((tail != nullptr) ? tail->count : 0);
+	}
+	
+	/**
+	 * @brief Get elements of the leaf containing index `i`.
+	 */
+	const T* leaf(size_t i) const noexcept {
+		const size_t off = tailOffset();
+		if (i >= off){
+			return tail->items();
+		}
+		
+		const Node* node = root;
+		for (uint32_t level = shift ; level > 0 ; level -= BITS){
+			node = static_cast<const Branch*>(node)->child[(i >> level) & MASK];
+		}
+		return static_cast<const Leaf*>(node)->items();
+	}
+	
+	T& mut(Node*& node, uint32_t level, size_t i){
+		if (level == 0){
+			Leaf* l = unique(static_cast<Leaf*>(node));
+			node = l;
+			return l->items()[i & MASK];
+		}
+		
+		Branch* b = unique(static_cast<Branch*>(node));
+		node = b;
+		return mut(b->child[(i >> level) & MASK], level - BITS, i);
+	}
+	
+	/**
+	 * @brief Move full `tail` into the trie.
+	 */
+	void pushTail(){
+		assert(tail != nullptr && tail->count == WIDTH);
+		const size_t i = tailOffset();
+		
+		if (root == nullptr){
+			root = tail;
+			shift = 0;
+		} else if ((i >> shift) >= WIDTH){
+			Branch* b = new Branch();
+			b->child[0] = root;
+			b->child[1] = path(shift, tail);
+			b->count = 2;
+			root = b;
+			shift += BITS;
+		} else {
+			root = pushTail(root, shift, i, tail);
+		}
+		
+		tail = nullptr;
+	}
+	
+	Node* pushTail(Node* node, uint32_t level, size_t i, Leaf* leaf){
+		assert(level > 0);
+		Branch* b = unique(static_cast<Branch*>(node));
+		const size_t sub = (i >> level) & MASK;
+		
+		if (level == BITS){
+			b->child[sub] = leaf;
+			b->count = uint32_t(sub + 1);
+		} else if (sub < b->count){
+			b->child[sub] = pushTail(b->child[sub], level - BITS, i, leaf);
+		} else {
+			b->child[sub] = path(level - BITS, leaf);
+			b->count = uint32_t(sub + 1);
+		}
+		
+		return b;
+	}
+	
+	/**
+	 * @brief Create chain of single child branches from `level` down to `leaf`.
+	 */
+	static Node* path(uint32_t level, Leaf* leaf){
+		if (level == 0){
+			return leaf;
+		}
+		Branch* b = new Branch();
+		b->child[0] = path(level - BITS, leaf);
+		b->count = 1;
+		return b;
+	}
+	
+	/**
+	 * @brief Take last leaf of the trie as the new `tail`.
+	 */
+	void popTail(){
+		assert(root != nullptr);
+		release(tail, 0);
+		
+		if (shift == 0){
+			tail = static_cast<Leaf*>(root);
+			root = nullptr;
+			return;
+		}
+		
+		root = popTail(root, shift, tail);
+		if (root == nullptr){
+			shift = 0;
+			return;
+		}
+		
+		// Collapse root with a single child.
+		while (shift > 0 && root->count == 1){
+			Branch* b = static_cast<Branch*>(root);
+			Node* child = b->child[0];
+			child->refs++;
+			release(b, shift);
+			root = child;
+			shift -= BITS;
+		}
+	
+	}
+	
+	Node* popTail(Node* node, uint32_t level, Leaf*& out){
+		if (level == 0){
+			out = static_cast<Leaf*>(node);
+			return nullptr;
+		}
+		
+		Branch* b = unique(static_cast<Branch*>(node));
+		const uint32_t last = b->count - 1;
+		b->child[last] = popTail(b->child[last], level - BITS, out);
+		
+		if (b->child[last] == nullptr){
+			b->count--;
+		}
+		
+		if (b->count == 0){
+			delete b;
+			return nullptr;
+		}
+		
+		return b;
+	}
+	
+	/**
+	 * @brief Get node which can be modified. Shared nodes are copied.
+	 */
+	static Branch* unique(Branch* b){
+		if (b->refs <= 1){
+			return b;
+		}
+		
+		Branch* c = new Branch();
+		c->count = b->count;
+		for (uint32_t i = 0 ; i < b->count ; i++){
+			c->child[i] = b->child[i];
+			c->child[i]->refs++;
+		}
+		
+		b->refs--;
+		return c;
+	}
+	
+	static Leaf* unique(Leaf* l){
+		if (l->refs <= 1){
+			return l;
+		}
+		
+		Leaf* c = new Leaf();
+		const T* src = l->items();
+		T* dst = c->items();
+		for (uint32_t i = 0 ; i < l->count ; i++){
+			new (&dst[i]) T(src[i]);
+			c->count++;
+		}
+		
+		l->refs--;
+		return c;
+	}
+	
+	static void release(Node* node, uint32_t level){
+		if (node == nullptr || --node->refs > 0){
+			return;
+		}
+		
+		if (level == 0){
+			delete static_cast<Leaf*>(node);
+			return;
+		}
+		
+		Branch* b = static_cast<Branch*>(node);
+		for (uint32_t i = 0 ; i < b->count ; i++){
+			release(b->child[i], level - BITS);
+		}
+		delete b;
+	}
+
+// ------------------------------------------------------------------------------------------ //
+};
+
+
+
+template<typename T>
+class persistent_vector<T>::const_iterator {
+// ---------------------------------------------------------------- //
+private:
+	const persistent_vector* vec;
+	size_t i;
+	const T* items;		// Leaf containing element `i`.
+
+// ---------------------------------------------------------------- //
+public:
+	const_iterator(const persistent_vector& vec, size_t i) : vec{&vec}, i{i} {
+		items = (i < vec.len) ? vec.leaf(i) : nullptr;
+	}
+
+// ---------------------------------------------------------------- //
+public:
+	const T& operator*() const noexcept {
+		return items[i & MASK];
+	}
+	
+	const T* operator->() const noexcept {
+		return &items[i & MASK];
+	}
+	
+	const_iterator& operator++() noexcept {
+		i++;
+		if ((i & MASK) == 0 && i < vec->len)
+			items = vec->leaf(i);
+		return *this;
+	}
+	
+	bool operator==(const const_iterator& o) const noexcept {
+		return i == o.i;
+	}
+	
+	bool operator!=(const const_iterator& o) const noexcept {
+		return i != o.i;
+	}
+
+// ---------------------------------------------------------------- //
+};
@@ -26,6 +26,12 @@ private:
 	inline std::vector<T>& vec(){
 		return reinterpret_cast<std::vector<T>&>(memory.vec);
 	}
+	inline const T* arr() const {
+		return reinterpret_cast<const T*>(memory.arr);
+	}
+	inline const std::vector<T>& vec() const {
+		return reinterpret_cast<const std::vector<T>&>(memory.vec);
+	}
 	
 // ---------------------------------- [ Constructors ] -------------------------------------- //
 public:
@@ -1,231 +1,505 @@
 #pragma once
 #include <cassert>
-#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <bit>
+#include <new>
 #include <string_view>
-#include <unordered_map>
+#include <utility>
 
 
+/**
+ * @brief Flat open addressing hash map with string keys.
+ *        Entries are stored inline in one array together with their precomputed hash.
+ *        A separate array of control bytes holds 7 bits of each hash and is probed 8 slots at a time,
+ *        so most lookups compare keys only once.
+ *        Short keys are stored inline in the entry, longer keys are allocated separately.
+ * @note Inserting or removing entries may invalidate pointers to values.
+ */
 template<typename T>
 class str_map {
+// ----------------------------------- [ Constants ] ---------------------------------------- //
+public:
+	static constexpr size_t SMALL_KEY = 15;			// Maximum length of inline keys.
+	static constexpr size_t GROUP = 8;				// Control bytes probed at once.
+	static constexpr size_t MIN_CAPACITY = GROUP;
+
+private:
+	static constexpr int8_t EMPTY = -128;			// 0b10000000
+	static constexpr int8_t DELETED = -2;			// 0b11111110
+	static constexpr uint64_t LSB = 0x0101010101010101ull;
+	static constexpr uint64_t MSB = 0x8080808080808080ull;
+	static_assert(GROUP == sizeof(uint64_t));
+
 // ----------------------------------- [ Structures ] --------------------------------------- //
 public:
 	using key_type = std::string_view;
 	using value_type = T;
 	
 	struct entry {
+		size_t hash;
+		uint32_t len;
+		union {
+			char small[SMALL_KEY + 1];
+			char* large;
+		};
 		value_type value;
-		const char key[];	// c-string
+		
+		const char* c_str() const noexcept {
+			return (len <= SMALL_KEY) ? small : large;
+		}
+		
+		key_type key() const noexcept {
+			return key_type(c_str(), len);
+		}
 	};
 	
-	using mapped_type = std::unique_ptr<entry>;
-	using map_type = std::unordered_map<key_type,mapped_type>;
-	
 	struct iterator;
 	struct const_iterator;
-	
+
 // ------------------------------------[ Properties ] --------------------------------------- //
 private:
-	map_type map;
+	int8_t* ctrl = nullptr;		// Control byte of each entry: `EMPTY`, `DELETED` or 7 bits of the hash.
+	entry* slots = nullptr;
+	size_t capacity = 0;		// Power of 2, multiple of `GROUP`.
+	size_t count = 0;			// Number of entries.
+	size_t deleted = 0;			// Number of `DELETED` control bytes.
+
+// ---------------------------------- [ Constructors ] -------------------------------------- //
+public:
+	str_map() = default;
+	str_map(const str_map&) = delete;
+	
+	str_map(str_map&& o) noexcept {
+		swap(o);
+	}
+	
+	str_map& operator=(str_map&& o) noexcept {
+		swap(o);
+		return *this;
+	}
 	
+	~str_map(){
+		destroy();
+	}
+
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 public:
 	template<typename ...ARG>
 	value_type& insert(const key_type& key, ARG&& ...args){
-		auto p = map.try_emplace(key);
-		const key_type& rKey = p.first->first;
-		mapped_type& rEntry = p.first->second;
-		
-		// Created, create key-value pair
-		if (p.second){
-			rEntry = makeEntry(key);
-			const_cast<key_type&>(rKey) = key_type(rEntry->key, key.length());
-			new (&rEntry->value) value_type(std::forward<ARG>(args)...);
-		} else {
-			rEntry->value = value_type(std::forward<ARG>(args)...);
+		const size_t hash = hashOf(key);
+		const size_t i = findIndex(key, hash);
+		
+		if (i != SIZE_MAX){
+			slots[i].value = value_type(std::forward<ARG>(args)...);
+			return slots[i].value;
 		}
 		
-		assert(rEntry != nullptr);
-		return rEntry->value;
+		entry& e = emplace(key, hash);
+		new (&e.value) value_type(std::forward<ARG>(args)...);
+		return e.value;
 	}
 	
 	value_type& operator[](const key_type& key){
-		auto p = map.try_emplace(key);
-		const key_type& rKey = p.first->first;
-		mapped_type& rEntry = p.first->second;
-		
-		// Created, create key-value pair
-		if (p.second){
-			rEntry = makeEntry(key);
-			const_cast<key_type&>(rKey) = key_type(rEntry->key, key.length());
-			new (&rEntry->value) value_type();
+		const size_t hash = hashOf(key);
+		const size_t i = findIndex(key, hash);
+		
+		if (i != SIZE_MAX){
+			return slots[i].value;
 		}
 		
-		assert(rEntry != nullptr);
-		return rEntry->value;
+		entry& e = emplace(key, hash);
+		new (&e.value) value_type();
+		return e.value;
 	}
-	
+
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 public:
 	bool empty() const noexcept {
-		return map.empty();
+		return count == 0;
 	}
 	
 	size_t size() const noexcept {
-		return map.size();
+		return count;
 	}
 	
 	entry* find(const key_type& key){
-		auto p = map.find(key);
-		if (p != nullptr)
-			return p->second.get();
-		return nullptr;
+		const size_t i = findIndex(key, hashOf(key));
+		return (i != SIZE_MAX) ? &slots[i] : nullptr;
 	}
 	
 	const entry* find(const key_type& key) const {
-		auto p = map.find(key);
-		if (p != nullptr)
-			return p->second.get();
-		return nullptr;
+		const size_t i = findIndex(key, hashOf(key));
+		return (i != SIZE_MAX) ? &slots[i] : nullptr;
 	}
 	
 	value_type* get(const key_type& key){
-		auto p = map.find(key);
-		if (p != nullptr)
-			return &p->second->value;
-		return nullptr;
+		const size_t i = findIndex(key, hashOf(key));
+		return (i != SIZE_MAX) ? &slots[i].value : nullptr;
 	}
 	
 	const value_type* get(const key_type& key) const {
-		auto p = map.find(key);
-		if (p != nullptr)
-			return &p->second->value;
-		return nullptr;
+		const size_t i = findIndex(key, hashOf(key));
+		return (i != SIZE_MAX) ? &slots[i].value : nullptr;
 	}
-	
+
 public:
 	bool remove(const key_type& key){
-		return map.erase(key) != 0;
+		const size_t i = findIndex(key, hashOf(key));
+		if (i == SIZE_MAX){
+			return false;
+		}
+		
+		destroyEntry(slots[i]);
+		ctrl[i] = DELETED;
+		count--;
+		deleted++;
+		return true;
 	}
-	
+
 public:
 	void clear(){
-		map.clear();
+		destroy();
+		ctrl = nullptr;
+		slots = nullptr;
+		capacity = 0;
+		count = 0;
+		deleted = 0;
 	}
 	
+	void swap(str_map& o) noexcept {
+		std::swap(ctrl, o.ctrl);
+		std::swap(slots, o.slots);
+		std::swap(capacity, o.capacity);
+		std::swap(count, o.count);
+		std::swap(deleted, o.deleted);
+	}
+
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 public:
-	void copy(str_map<T>& dst){
-		for (const auto& p : map){
-			assert(p.second != nullptr);
-			dst.insert(p.first, p.second->value);
+	void copy(str_map<T>& dst) const {
+		for (size_t i = 0 ; i < capacity ; i++){
+			if (ctrl[i] >= 0)
+				dst.insert(slots[i].key(), slots[i].value);
 		}
 	}
 	
 	iterator begin(){
-		return iterator(map.begin());
+		return iterator(this, 0);
 	}
 	
 	const_iterator begin() const {
-		return const_iterator(map.begin());
+		return const_iterator(this, 0);
 	}
 	
 	iterator end(){
-		return iterator(map.end());
+		return iterator(this, capacity);
 	}
 	
 	const_iterator end() const {
-		return const_iterator(map.end());
+		return const_iterator(this, capacity);
 	}
-	
+
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 private:
-	mapped_type makeEntry(const key_type& key){
-		const size_t size = sizeof(entry) + sizeof(char)*(key.length() + 1);
-		entry* e = (entry*)::operator new(size, std::align_val_t(alignof(entry::value)));
+	static size_t hashOf(const key_type& key) noexcept {
+		return std::hash<key_type>()(key);
+	}
+	
+	static int8_t h2(size_t hash) noexcept {
+		return int8_t(hash & 0x7F);
+	}
+	
+	uint64_t group(size_t i) const noexcept {
+		uint64_t g;
+		memcpy(&g, ctrl + i, sizeof(g));
+		return g;
+	}
+	
+	/**
+	 * @brief Convert bitmask with the highest bit set in matching bytes into index of the first match.
+	 */
+	static size_t first(uint64_t mask) noexcept {
+		if constexpr (std::endian::native == std::endian::little)
+			return size_t(std::countr_zero(mask)) / 8;
+		else
+			return size_t(std::countl_zero(mask)) / 8;
+	}
+	
+	static uint64_t next(uint64_t mask) noexcept {
+		if constexpr (std::endian::native == std::endian::little)
+			return mask & (mask - 1);
+		else
+			return mask & ~(uint64_t(1) << (63 - std::countl_zero(mask)));
+	}
+	
+	static uint64_t matchByte(uint64_t g, int8_t b) noexcept {
+		const uint64_t x = g ^ (LSB * uint8_t(b));
+		return (x - LSB) & ~x & MSB;
+	}
+	
+	static uint64_t matchEmpty(uint64_t g) noexcept {
+		return g & (~g << 6) & MSB;
+	}
+	
+	static uint64_t matchEmptyOrDeleted(uint64_t g) noexcept {
+		return g & ~(g << 7) & MSB;
+	}
+	
+	/**
+	 * @brief Find entry with matching key.
+	 * @return Index of the entry or `SIZE_MAX`.
+	 */
+	size_t findIndex(const key_type& key, size_t hash) const noexcept {
+		if (capacity == 0){
+			return SIZE_MAX;
+		}
+		
+		const size_t groups = capacity / GROUP;
+		size_t g = (hash >> 7) & (groups - 1);
+		
+		for (size_t step = 1 ; step <= groups ; step++){
+			const size_t base = g * GROUP;
+			const uint64_t ctl = group(base);
+			
+			for (uint64_t m = matchByte(ctl, h2(hash)) ; m != 0 ; m = next(m)){
+				const size_t i = base + first(m);
+				if (ctrl[i] != h2(hash))
+					continue;
+				
+				const entry& e = slots[i];
+				if (e.hash == hash && e.key() == key)
+					return i;
+			}
+			
+			if (matchEmpty(ctl) != 0){
+				return SIZE_MAX;
+			}
+			
+			g = (g + step) & (groups - 1);
+		}
+		
+		return SIZE_MAX;
+	}
+	
+	/**
+	 * @brief Find slot for a new entry.
+	 */
+	size_t findFree(size_t hash) const noexcept {
+		const size_t groups = capacity / GROUP;
+		size_t g = (hash >> 7) & (groups - 1);
+		
+		for (size_t step = 1 ; ; step++){
+			const size_t base = g * GROUP;
+			const uint64_t m = matchEmptyOrDeleted(group(base));
+			if (m != 0)
+				return base + first(m);
+			g = (g + step) & (groups - 1);
+		}
+	
+	}
+	
+	/**
+	 * @brief Create entry with key `key`. Value is left unconstructed.
+	 */
+	entry& emplace(const key_type& key, size_t hash){
+		if ((count + deleted + 1) * 8 > capacity * 7){
+			const size_t cap = (capacity == 0) ? MIN_CAPACITY : ((count + 1) * 8 > capacity * 4) ? capacity * 2 : capacity;
+			rehash(cap);
+		}
 		
-		// Copy key
-		char* key_buff = const_cast<char*>(e->key);
-		std::copy(key.data(), key.data() + key.length(), key_buff);
-		key_buff[key.length()] = 0;
+		const size_t i = findFree(hash);
+		if (ctrl[i] == DELETED)
+			deleted--;
+		ctrl[i] = h2(hash);
+		count++;
 		
-		return std::unique_ptr<entry>(e);
+		entry& e = slots[i];
+		e.hash = hash;
+		e.len = uint32_t(key.length());
+		
+		char* buff = e.small;
+		if (key.length() > SMALL_KEY){
+			buff = new char[key.length() + 1];
+			e.large = buff;
+		}
+		
+		memcpy(buff, key.data(), key.length());
+		buff[key.length()] = 0;
+		return e;
+	}
+	
+	void rehash(size_t cap){
+		int8_t* old_ctrl = ctrl;
+		entry* old_slots = slots;
+		const size_t old_cap = capacity;
+		
+		ctrl = static_cast<int8_t*>(::operator new(cap));
+		slots = static_cast<entry*>(::operator new(cap * sizeof(entry), std::align_val_t(alignof(entry))));
+		capacity = cap;
+		deleted = 0;
+		memset(ctrl, EMPTY, cap);
+		
+		for (size_t i = 0 ; i < old_cap ; i++){
+			if (old_ctrl[i] < 0)
+				continue;
+			
+			entry& src = old_slots[i];
+			const size_t j = findFree(src.hash);
+			ctrl[j] = h2(src.hash);
+			
+			entry& dst = slots[j];
+			dst.hash = src.hash;
+			dst.len = src.len;
+			if (src.len <= SMALL_KEY)
+				memcpy(dst.small, src.small, sizeof(src.small));
+			else
+				dst.large = src.large;
+			
+			new (&dst.value) value_type(std::move(src.value));
+			src.value.~value_type();
+		}
+		
+		if (old_ctrl != nullptr){
+			::operator delete(old_ctrl);
+			::operator delete(old_slots, std::align_val_t(alignof(entry)));
+		}
+	
 	}
 	
+	static void destroyEntry(entry& e) noexcept {
+		if (e.len > SMALL_KEY)
+			delete[] e.large;
+		e.value.~value_type();
+	}
+	
+	void destroy() noexcept {
+		if (ctrl == nullptr){
+			return;
+		}
+		
+		for (size_t i = 0 ; i < capacity ; i++){
+			if (ctrl[i] >= 0)
+				destroyEntry(slots[i]);
+		}
+		
+		::operator delete(ctrl);
+		::operator delete(slots, std::align_val_t(alignof(entry)));
+	}
+
 // ------------------------------------------------------------------------------------------ //
 };
 
 
 
 template<typename T>
-struct str_map<T>::iterator : public str_map<T>::map_type::iterator {
+struct str_map<T>::iterator {
 // ---------------------------------------------------------------- //
 public:
-	using map_iterator = str_map<T>::map_type::iterator;
-	
 	struct Pair {
 		std::string_view key;
 		T& value;
 	};
-	
+
+private:
+	str_map* map;
+	size_t i;
+
 // ---------------------------------------------------------------- //
 public:
-	iterator() = default;
-	iterator(const auto& p) : map_iterator(p) {}
-	iterator(auto&& p) : map_iterator(std::move(p)) {}
-	
+	iterator(str_map* map, size_t i) : map{map}, i{i} {
+		skip();
+	}
+
 // ---------------------------------------------------------------- //
 public:
 	T* operator->() const {
-		auto entry = static_cast<const map_iterator&>(*this).operator->();
-		return entry->second->value;
-		
+		return &map->slots[i].value;
 	}
 	
 	Pair operator*() const {
-		auto entry = static_cast<const map_iterator&>(*this).operator->();
 		return Pair {
-			.key = entry->first,
-			.value = entry->second->value
+			.key = map->slots[i].key(),
+			.value = map->slots[i].value
 		};
 	}
 	
+	iterator& operator++(){
+		i++;
+		skip();
+		return *this;
+	}
+	
+	bool operator==(const iterator& o) const {
+		return i == o.i;
+	}
+	
+	bool operator!=(const iterator& o) const {
+		return i != o.i;
+	}
+
+private:
+	void skip(){
+		while (i < map->capacity && map->ctrl[i] < 0)
+			i++;
+	}
+
 // ---------------------------------------------------------------- //
 };
 
 
 
 template<typename T>
-struct str_map<T>::const_iterator : public str_map<T>::map_type::const_iterator {
+struct str_map<T>::const_iterator {
 // ---------------------------------------------------------------- //
 public:
-	using map_iterator = str_map<T>::map_type::const_iterator;
-	
 	struct Pair {
 		std::string_view key;
 		const T& value;
 	};
-	
+
+private:
+	const str_map* map;
+	size_t i;
+
 // ---------------------------------------------------------------- //
 public:
-	const_iterator() = default;
-	const_iterator(const auto& p) : str_map<T>::map_type::const_iterator(p) {}
-	const_iterator(auto&& p) : str_map<T>::map_type::const_iterator(std::move(p)) {}
-	
+	const_iterator(const str_map* map, size_t i) : map{map}, i{i} {
+		skip();
+	}
+
 // ---------------------------------------------------------------- //
 public:
 	const T* operator->() const {
-		auto entry = static_cast<const map_iterator&>(*this).operator->();
-		return entry->second->value;
-		
+		return &map->slots[i].value;
 	}
 	
 	Pair operator*() const {
-		auto entry = static_cast<const map_iterator&>(*this).operator->();
 		return Pair {
-			.key = entry->first,
-			.value = entry->second->value
+			.key = map->slots[i].key(),
+			.value = map->slots[i].value
 		};
 	}
 	
+	const_iterator& operator++(){
+		i++;
+		skip();
+		return *this;
+	}
+	
+	bool operator==(const const_iterator& o) const {
+		return i == o.i;
+	}
+	
+	bool operator!=(const const_iterator& o) const {
+		return i != o.i;
+	}
+
+private:
+	void skip(){
+		while (i < map->capacity && map->ctrl[i] < 0)
+			i++;
+	}
+
 // ---------------------------------------------------------------- //
 };
@@ -1,11 +1,24 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+#include <cstring>
 
 #include "fs.hpp"
 #include "cli.hpp"
 #include "MacroEngine.hpp"
 #include "Paths.hpp"
+#include "Stats.hpp"
 #include "output/Write.hpp"
+#include "Dependencies.hpp"
+#include "OutputCache.hpp"
+#include "ShellCache.hpp"
+#include "Watch.hpp"
 #include "Debug.hpp"
 
 using namespace std;
@@ -14,7 +27,6 @@ using namespace std;
 // ----------------------------------- [ Prototypes ] --------------------------------------- //
 
 
-bool printDependencies(const char* path);
 
 
 // ----------------------------------- [ Functions ] ---------------------------------------- //
@@ -34,6 +46,7 @@ bool printDependencies(const char* path);
 void help(){
 	LOG_STDOUT(B("html-macro: ") Y(VERSION) ", by " ANSI_CYAN "Hurkus" ANSI_RESET ".\n");
 	LOG_STDOUT(B("Usage:") " %s [options] [<variable>=<value>] <file>\n", opt.program);
+	LOG_STDOUT(B("       ") " %s [options] [<variable>=<value>] --batch <manifest>\n", opt.program);
 	
 	LOG_STDOUT("\n");
 	LOG_STDOUT(B("Variables:\n"));
@@ -54,6 +67,19 @@ void help(){
 	LOG_STDOUT("  " Y("--dependencies") ", " Y("-d")  " ............ Print list of file paths on which the input file depens on.\n");
 	LOG_STDOUT("                                   The paths are extracted from " PURPLE("<INCLUDE/>") " macros.\n");
 	LOG_STDOUT("                                   Only non-expression attribute values are considered.\n");
+	LOG_STDOUT("  " Y("--depfile <path>") ", " Y("-M <path>") " ... Write make rule of the output file with files it depends on, recorded while rendering.\n");
+	LOG_STDOUT("                                   Unlike " Y("--dependencies") ", also finds files included by expressions.\n");
+	LOG_STDOUT("  " Y("--cache <dir>") ", " Y("-C <dir>") " ....... Reuse output of previous runs stored in " Y("<dir>") " if none of the files changed.\n");
+	LOG_STDOUT("                                   Also stores output of " PURPLE("<SHELL CACHE=\"seconds\">") " commands.\n");
+	LOG_STDOUT("  " Y("--stats") " ....................... Print cache and memory statistics to stderr.\n");
+	LOG_STDOUT("  " Y("--stream") ", " Y("-s") " .................. Write output while it is evaluated and free written parts.\n");
+	LOG_STDOUT("                                   Elements can't be changed by " PURPLE("<SET-ATTR/>") " or " PURPLE("<SET-TAG/>") " after their content.\n");
+	LOG_STDOUT("  " Y("--batch <path>") ", " Y("-b <path>") " ..... Render all files listed in the manifest in one process, sharing parsed includes.\n");
+	LOG_STDOUT("                                   Each line holds an input file and optionally an output file (default: stdout).\n");
+	LOG_STDOUT("                                   Manifest " C("-") " is read from stdin.\n");
+	LOG_STDOUT("  " Y("--jobs <n>") ", " Y("-j <n>") " ............ Render files of the batch on " Y("<n>") " threads, " C("0") " uses all cores.\n");
+	LOG_STDOUT("                                   (default: " C("1") ")\n");
+	LOG_STDOUT("  " Y("--watch") ", " Y("-w") " ................... Keep running and render files again when files they include change.\n");
 	LOG_STDOUT("\n");
 }
 
@@ -116,6 +142,15 @@ static bool execMacro(shared_ptr<Macro>&& macro, ostream* out){
 			}
 			
 			html::Document doc = {};
+			
+			// Write completed parts of the output during evaluation
+			if (opt.stream && out != nullptr){
+				HtmlWriter writer = HtmlWriter(*out, doc, opt.compress);
+				engine.exec(macro, doc, writer);
+				writer.finish();
+				return true;
+			}
+			
 			engine.exec(macro, doc);
 			
 			if (out != nullptr){
@@ -163,41 +198,425 @@ static bool execMacro(shared_ptr<Macro>&& macro, ostream* out){
 }
 
 
+static bool render(const char* inFilePath, ostream* out){
+	filepath src_path = inFilePath;
+	if (!fs::exists(src_path)){
+		ERROR("Input file not found: " PURPLE("`%s`"), src_path.c_str());
+		return false;
+	}
+	
+	// Load input file
+	shared_ptr<Macro> root_macro = MacroCache::load(src_path);
+	if (root_macro == nullptr){
+		ERROR("Failed to read file: " PURPLE("`%s`"), src_path.c_str());
+		return false;
+	}
+	
+	bool ret = execMacro(shared_ptr(root_macro), out);
+	if (out != nullptr){
+		out->flush();
+	}
+	
+	// Shared files stay cached for other inputs, the input itself is rarely used again unless watched.
+	if (!opt.watch){
+		MacroCache::unload(*root_macro);
+	}
+	
+	return ret;
+}
+
+
+static bool render(const char* inFilePath, const char* outFilePath){
+	if (outFilePath == nullptr){
+		return render(inFilePath, (ostream*)nullptr);
+	} else if (outFilePath == "-"sv){
+		return render(inFilePath, &cout);
+	}
+	
+	// Open output file
+	ofstream outf = ofstream(outFilePath);
+	if (!outf.is_open()){
+		ERROR("Failed to open output file: " PURPLE("`%s`"), outFilePath);
+		return false;
+	}
+	
+	return render(inFilePath, &outf);
+}
+
+
+/**
+ * @brief Write output which was already rendered, see `render(const char*, const char*)`.
+ */
+static bool writeOutput(string_view output, const char* outFilePath){
+	if (outFilePath == "-"sv){
+		cout << output;
+		return bool(cout.flush());
+	}
+	
+	ofstream outf = ofstream(outFilePath);
+	if (!outf.is_open()){
+		ERROR("Failed to open output file: " PURPLE("`%s`"), outFilePath);
+		return false;
+	}
+	
+	outf << output;
+	return bool(outf);
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+static unique_ptr<OutputCache> outputCache;	// Outputs of previous runs, see `--cache`.
+
+
+/**
+ * @brief Options which affect the rendered output. Outputs are cached separately for each.
+ */
+static string cacheSettings(){
+	string s = VERSION "\n";
+	s += to_string(int(opt.compress)) + " " + to_string(int(opt.inFileType)) + " " + to_string(opt.stream) + "\n";
+	
+	for (const filepath& dir : Paths::includeDirs){
+		s += "include " + dir.native() + "\n";
+	}
+	
+	for (const char* def : opt.defines){
+		s += "define " + string(def) + "\n";
+	}
+	
+	return s;
+}
+
+
+struct BatchFile {
+	const char* inFilePath = nullptr;
+	const char* outFilePath = nullptr;
+	string buffer = {};			// Output for stdout, held until all previous files are written.
+	bool done = false;
+	Dependencies deps = {};		// Recorded while rendering for `--watch`, `--depfile` and `--cache`.
+};
+
+
+/**
+ * @brief Copy output of an unchanged input file from `outputCache`, or render it and store the output.
+ * @param out Output stream, or `nullptr` to write to `BatchFile::outFilePath`.
+ */
+static bool renderCached(BatchFile& file, ostream* out){
+	assert(outputCache != nullptr);
+	string output;
+	bool ret = true;
+	
+	if (!outputCache->find(file.inFilePath, output, file.deps)){
+		ostringstream buff;
+		const size_t reported = diagnostics;
+		
+		Dependencies::record(&file.deps);
+		ret = render(file.inFilePath, &buff);
+		Dependencies::record(nullptr);
+		output = move(buff).str();
+		
+		// Later runs wouldn't report the warnings, and commands may output something else.
+		if (ret && diagnostics == reported && file.deps.commands.empty())
+			outputCache->store(file.inFilePath, file.deps, output);
+	}
+	
+	if (out != nullptr){
+		*out << output;
+		return ret && bool(out->flush());
+	}
+	
+	return writeOutput(output, file.outFilePath) && ret;
+}
+
+
+/**
+ * @brief Render file of a batch in a new macro scope.
+ * @param out Output stream, or `nullptr` to write to `BatchFile::outFilePath`.
+ */
+static bool render(BatchFile& file, ostream* out = nullptr){
+	MacroCache::reset();
+	file.deps.clear();
+	
+	if (outputCache != nullptr && file.outFilePath != nullptr){
+		return renderCached(file, out);
+	}
+	
+	Dependencies::record((opt.watch || opt.depFilePath != nullptr) ? &file.deps : nullptr);
+	
+	bool ret = (out != nullptr) ? render(file.inFilePath, out) : render(file.inFilePath, file.outFilePath);
+	Dependencies::record(nullptr);
+	return ret;
+}
+
+
+/**
+ * @brief Write make rules of rendered files to `opt.depFilePath`.
+ *        Files written to stdout have no target and are skipped.
+ */
+static bool writeDepfile(const vector<BatchFile>& files){
+	ofstream out = ofstream(opt.depFilePath);
+	if (!out.is_open()){
+		ERROR("Failed to open dependency file: " PURPLE("`%s`"), opt.depFilePath);
+		return false;
+	}
+	
+	// Make can't track variables, they are listed for other build tools.
+	for (const char* def : opt.defines){
+		out << "# Variable: " << def << '\n';
+	}
+	
+	for (const BatchFile& file : files){
+		if (file.outFilePath != nullptr && file.outFilePath != "-"sv)
+			file.deps.writeRule(out, file.outFilePath, file.inFilePath);
+	}
+	
+	return bool(out);
+}
+
+
+/**
+ * @brief Render files again whenever any of the files they loaded change.
+ *        Files stay cached in between, only changed files are parsed again.
+ * @return Only returns `false` if watching failed.
+ */
+static bool watch(vector<BatchFile>& files){
+	FileWatcher watcher;
+	if (!watcher.open()){
+		ERROR("Failed to watch files: %s", strerror(errno));
+		return false;
+	}
+	
+	// Directories which failed to be watched, reported only once.
+	unordered_set<string> failed;
+	
+	auto add = [&](const BatchFile& file){
+		for (const vector<filepath>* paths : { &file.deps.files, &file.deps.missing }){
+			for (const filepath& dep : *paths){
+				if (watcher.add(dep))
+					continue;
+				if (failed.emplace(dep.parent_path().string()).second)
+					WARN("Failed to watch directory of " PURPLE("`%s`") ".", dep.c_str());
+			}
+		}
+	};
+	
+	for (const BatchFile& file : files){
+		add(file);
+	}
+	
+	// Output of files rendered to stdout is visible before blocking.
+	cout.flush();
+	INFO("Watching for changes ...");
+	vector<filepath> changed;
+	
+	while (watcher.wait(changed)){
+		const auto t0 = chrono::steady_clock::now();
+		for (const filepath& path : changed){
+			MacroCache::unload(path);
+		}
+		
+		// Each rebuild executes commands again, as a new build would.
+		ShellCache::reset();
+		
+		// Render files which loaded any changed file
+		size_t n = 0;
+		for (BatchFile& file : files){
+			auto isDependency = [&](const filepath& path){
+				return file.deps.contains(path);
+			};
+			
+			if (any_of(changed.begin(), changed.end(), isDependency)){
+				render(file);
+				add(file);
+				n++;
+			}
+		
+		}
+		
+		cout.flush();
+		if (n > 0){
+			if (opt.depFilePath != nullptr)
+				writeDepfile(files);
+			
+			const chrono::duration<double,milli> t = chrono::steady_clock::now() - t0;
+			INFO("Rendered %zu file(s) in %.1f ms.", n, t.count());
+		}
+		
+		changed.clear();
+	}
+	
+	ERROR("Failed to watch files: %s", strerror(errno));
+	return false;
+}
+
+
 static bool run(){
 	MacroCache::clear();
 	Paths::cwd = make_unique<filepath>(fs::cwd());
 	
-	ostream* out = (opt.outFilePath != nullptr && opt.outFilePath == "-"sv ? &cout : nullptr);
-	ofstream outf;
+	vector<BatchFile> files = { BatchFile { .inFilePath = opt.inFilePath, .outFilePath = opt.outFilePath } };
+	bool ret = render(files[0]);
 	
-	// Open output file
-	if (opt.outFilePath != nullptr && out == nullptr){
-		outf = ofstream(opt.outFilePath);
-		out = &outf;
+	if (opt.depFilePath != nullptr){
+		ret &= writeDepfile(files);
+	}
+	
+	if (opt.watch){
+		ret = watch(files);
+	}
+	
+	// Cleanup
+	MacroCache::clear();
+	return ret;
+}
+
+
+/**
+ * @brief Parse lines of the batch manifest.
+ *        Each line holds an input file and an optional output file (default: stdout), separated by spaces.
+ *        Empty lines and lines starting with `#` are skipped.
+ * @param manifest Content of the manifest, split in place into file paths.
+ */
+static bool parseBatch(string& manifest, vector<BatchFile>& files){
+	bool ret = true;
+	char* s = manifest.data();
+	
+	for (int line = 1 ; *s != 0 ; line++){
+		char* end = s;
+		while (*end != 0 && *end != '\n')
+			end++;
 		
-		if (!outf.is_open()){
-			ERROR("Failed to open output file: " PURPLE("`%s`"), opt.outFilePath);
-			return false;
+		const bool last = (*end == 0);
+		*end = 0;
+		
+		// Split line into words
+		char* words[3] = {};
+		int n = 0;
+		for (char* w = s ; *w != 0 ; ){
+			if (isspace(*w)){
+				*w++ = 0;
+				continue;
+			}
+			
+			if (n < 3)
+				words[n] = w;
+			n++;
+			
+			while (*w != 0 && !isspace(*w))
+				w++;
 		}
 		
+		s = last ? end : end + 1;
+		
+		if (n == 0 || words[0][0] == '#'){
+			continue;
+		} else if (n > 2){
+			ERROR("%s:%d: Expected an input and output file, got " PURPLE("`%s`") ".", opt.batchFilePath, line, words[2]);
+			ret = false;
+			continue;
+		}
+		
+		const char* outFilePath = (opt.outFilePath == nullptr) ? nullptr : (n > 1) ? words[1] : "-";
+		files.push_back(BatchFile { .inFilePath = words[0], .outFilePath = outFilePath });
 	}
 	
-	filepath src_path = opt.inFilePath;
-	if (!fs::exists(src_path)){
-		ERROR("Input file not found: " PURPLE("`%s`"), src_path.c_str());
-		return false;
+	return ret;
+}
+
+
+/**
+ * @brief Render files of the batch on `opt.jobs` threads.
+ *        Threads take the next file from a shared counter, so slow files don't hold up the others.
+ *        Each thread has its own macro cache, output for stdout is written in the order of the manifest.
+ */
+static bool renderParallel(vector<BatchFile>& files){
+	atomic<size_t> next = 0;
+	atomic<bool> ret = true;
+	
+	mutex stdoutMutex;
+	size_t written = 0;		// Files written to stdout or skipped.
+	
+	const shared_ptr<const filepath> cwd = Paths::cwd;
+	
+	auto worker = [&](){
+		Paths::cwd = cwd;
+		
+		for (size_t i = next++ ; i < files.size() ; i = next++){
+			BatchFile& file = files[i];
+			
+			if (file.outFilePath != nullptr && file.outFilePath == "-"sv){
+				ostringstream out;
+				if (!render(file, &out))
+					ret = false;
+				file.buffer = move(out).str();
+			} else if (!render(file)){
+				ret = false;
+			}
+			
+			// Write all completed files which are next in order
+			lock_guard _lock = lock_guard(stdoutMutex);
+			file.done = true;
+			
+			while (written < files.size() && files[written].done){
+				cout << files[written].buffer;
+				files[written].buffer = {};
+				written++;
+			}
+			
+			cout.flush();
+		}
+		
+		MacroCache::clear();
+		Stats::collect();
+	};
+	
+	vector<thread> threads;
+	const size_t n = min(size_t(opt.jobs), files.size());
+	for (size_t i = 0 ; i < n ; i++){
+		threads.emplace_back(worker);
 	}
 	
-	// Load input file
-	shared_ptr<Macro> root_macro = MacroCache::load(src_path);
-	if (root_macro == nullptr){
-		ERROR("Failed to read file: " PURPLE("`%s`"), src_path.c_str());
+	for (thread& t : threads){
+		t.join();
+	}
+	
+	return ret;
+}
+
+
+/**
+ * @brief Render all files listed in the batch manifest within a single process.
+ *        Files are parsed once and shared between inputs, but each input has its own variables and named macros.
+ */
+static bool runBatch(){
+	MacroCache::clear();
+	Paths::cwd = make_unique<filepath>(fs::cwd());
+	
+	// Read manifest
+	string manifest;
+	if (opt.batchFilePath == "-"sv ? !fs::readStream(cin, manifest) : !fs::readFile(opt.batchFilePath, manifest)){
+		ERROR("Failed to read batch file: " PURPLE("`%s`"), opt.batchFilePath);
 		return false;
 	}
 	
-	bool ret = execMacro(move(root_macro), out);
-	if (out != nullptr){
-		out->flush();
+	vector<BatchFile> files;
+	bool ret = parseBatch(manifest, files);
+	
+	if (opt.jobs > 1 && files.size() > 1){
+		ret &= renderParallel(files);
+	} else {
+		for (BatchFile& file : files){
+			ret &= render(file);
+		}
+	}
+	
+	if (opt.depFilePath != nullptr){
+		ret &= writeDepfile(files);
+	}
+	
+	if (opt.watch){
+		ret = watch(files);
 	}
 	
 	// Cleanup
@@ -237,9 +656,20 @@ int main(int argc, char const* const* argv){
 	if (opt.help){
 		help();
 		return 0;
+	} else if (opt.batchFilePath != nullptr){
+		if (opt.inFilePath != nullptr){
+			ERROR("Input file " PURPLE("`%s`") " can't be combined with a batch file.", opt.inFilePath);
+			return 1;
+		} else if (opt.printDependencies){
+			ERROR("Dependencies can't be printed for a batch file.");
+			return 1;
+		}
 	} else if (opt.inFilePath == nullptr){
 		ERROR("No input files.");
 		return 1;
+	} else if (opt.depFilePath != nullptr && (opt.outFilePath == nullptr || opt.outFilePath == "-"sv)){
+		ERROR("Dependency file requires an output file, see " YELLOW("`--output`") ".");
+		return 1;
 	}
 	
 	for (const char* file : opt.includes){
@@ -248,14 +678,30 @@ int main(int argc, char const* const* argv){
 			Paths::includeDirs.pop_back();
 	}
 	
+	if (opt.cacheDir != nullptr){
+		outputCache = make_unique<OutputCache>();
+		if (!outputCache->open(opt.cacheDir, cacheSettings())){
+			ERROR("Failed to open cache directory: " PURPLE("`%s`"), opt.cacheDir);
+			return 1;
+		}
+		ShellCache::dir = filepath(opt.cacheDir) / "shell";
+	}
+	
 	// Run
 	if (opt.printDependencies){
 		if (!printDependencies(opt.inFilePath))
 			return 2;
+	} else if (opt.batchFilePath != nullptr){
+		if (!runBatch())
+			return 2;
 	} else if (!run()){
 		return 2;
 	}
 	
+	if (opt.printStats){
+		Stats::print();
+	}
+	
 	return 0;
 }
 
@@ -1,12 +1,14 @@
 #include "Write.hpp"
 #include <vector>
 #include <cstring>
+#include <algorithm>
 
 #include "html/html.hpp"
 #include "Debug.hpp"
 
 using namespace std;
 using namespace html;
+using Item = HtmlWriter::Item;
 
 
 // ---------------------------------- [ Definitions ] --------------------------------------- //
@@ -53,13 +55,53 @@ constexpr string_view tabs(int tab){
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
-static void writeAttributes(ostream& out, const Node& node, vector<const Attr*>& stack){
+/**
+ * @brief Get node which is written in place of `node`.
+ */
+static const Node& source(const Node& node){
+	return (node.type == NodeType::BORROWED) ? *node.borrowed : node;
+}
+
+
+static Item item(const Node& child, const Node& parent, bool borrowed){
+	if (child.type == NodeType::BORROWED)
+		return Item{child.borrowed, &parent, &child, true, false};
+	else
+		return Item{&child, &parent, &child, borrowed, false};
+}
+
+
+/**
+ * @brief Push children of `parent` to the stack, so that the first child is at the back.
+ * @param borrowed `parent` is part of a borrowed subtree.
+ */
+static void pushChildren(vector<Item>& stack, const Node& parent, bool borrowed){
+	const size_t n = stack.size();
+	
+	for (const Node* child = parent.child ; child != nullptr ; child = child->next){
+		stack.push_back(item(*child, parent, borrowed));
+	}
+	
+	// Output child lists are reversed, source child lists are not.
+	if (borrowed){
+		reverse(stack.begin() + n, stack.end());
+	}
+	
+}
+
+
+static void writeAttributes(ostream& out, const Node& node, bool borrowed, vector<const Attr*>& stack){
 	assert(stack.empty());
 	
 	for (const Attr* attr = node.attribute ; attr != nullptr ; attr = attr->next){
 		stack.emplace_back(attr);
 	}
 	
+	// Output attribute lists are reversed, source attribute lists are not.
+	if (borrowed){
+		reverse(stack.begin(), stack.end());
+	}
+	
 	while (!stack.empty()){
 		const Attr& a = *stack.back();
 		stack.pop_back();
@@ -132,13 +174,14 @@ static void writeIndentedText(ostream& out, string_view text, const int depth){
 
 static bool writeCompressedStyleElement(ostream& out, const Node& style){
 	for (const Node* child = style.child ; child != nullptr ; child = child->next){
-		if (child->type != NodeType::TEXT){
+		const Node& txt = source(*child);
+		if (txt.type != NodeType::TEXT){
 			out.flush();
 			ERROR("Invalid child element type. Element " PURPLE("<style>") " can only have text child elements.");
 			return false;
 		}
 		
-		string_view css = child->value();
+		string_view css = txt.value();
 		if (css.empty()){
 			continue;
 		}
@@ -147,175 +190,12 @@ static bool writeCompressedStyleElement(ostream& out, const Node& style){
 		
 		// Preserve whitespace between text chunks
 		if (child->next != nullptr){
-			if (isWhitespace(css.back()) || (child->next->value_len > 0 && isWhitespace(child->next->value_p[0])))
-				out << '\n';
-		}
-		
-	}
-	return true;
-}
-
-
-// ----------------------------------- [ Functions ] ---------------------------------------- //
-
-
-static bool writeUncompressedHTML(ostream& out, const Document& doc, WriteOptions options){
-	vector<const Node*> node_stack = {};	// Child node list is reversed.
-	vector<const Attr*> attr_stack = {};	// Attr list is reversed.
-	node_stack.reserve(64);
-	attr_stack.reserve(16);
-	
-	int depth = 0;
-	bool add_space = false;
-	bool skip_space = false;
-	
-	// Push children of root element (reverse list)
-	for (const Node* child = doc.child ; child != nullptr ; child = child->next){
-		node_stack.emplace_back(child);
-	}
-	
-	while (!node_stack.empty()){
-		const Node* node = node_stack.back();
-		
-		switch (node->type){
-			case NodeType::TEXT:
-				goto text;
-			case NodeType::TAG:
-				goto tag;
-			case NodeType::DIRECTIVE:
-				goto directive;
-			default:
-				goto pop;
-		}
-		
-		
-		text: {
-			// Raw unmodified text
-			if (node->parent != nullptr && node->parent->name() == "pre"sv){
-				out << node->value();
-				skip_space = true;
-				add_space = false;
-			}
-			
-			// Stack text nodes
-			else if (node_stack.size() >= 2 && node_stack.end()[-2]->type == NodeType::TEXT){
-				writeIndentedText(out, node->value(), depth);
-			}
-			
-			// Single text node
-			else {
-				string_view text = trim_nl_suffix(node->value());
-				bool trimmed = (text.length() != size_t(node->value_len));
-				trimmed |= (node->options % NodeOptions::SPACE_AFTER);
-				
-				// Prefix with whitespace
-				if (node->options % NodeOptions::SPACE_BEFORE){ [[unlikely]]
-					if (!text.empty() && !isWhitespace(text[0]))
-						out << '\n' << tabs(depth);
-				}
-				
-				writeIndentedText(out, text, depth);
-				
-				skip_space = !trimmed;
-				add_space = trimmed;
-			}
-			
-			goto pop;
-		}
-		
-		
-		directive: {
-			if (!skip_space && (add_space || node->options % NodeOptions::SPACE_BEFORE)){
-				out << '\n' << tabs(depth);
-			}
-			
-			out << '<' << node->value() << '>';
-			
-			skip_space = false;
-			add_space = node->options % NodeOptions::SPACE_AFTER;
-			goto pop;
-		}
-		
-		
-		tag: {
-			if (!skip_space && (add_space || node->options % NodeOptions::SPACE_BEFORE)){
+			const Node& next = source(*child->next);
+			if (isWhitespace(css.back()) || (next.value_len > 0 && isWhitespace(next.value_p[0])))
 				out << '\n';
-				out << tabs(depth);
-			}
-			
-			add_space = false;
-			skip_space = false;
-			
-			// Tag name
-			out << '<' << node->name();
-			writeAttributes(out, *node, attr_stack);
-			
-			if (node->child == nullptr && node->options % NodeOptions::SELF_CLOSE){
-				out << "/>";
-				add_space = node->options % NodeOptions::SPACE_AFTER;
-				goto pop;
-			} else {
-				out << '>';
-			}
-			
-			// Enqueue children
-			if (node->child != nullptr){
-				
-				// Directly compress CSS
-				if (node->name() == "style"sv && options % WriteOptions::COMPRESS_CSS){
-					if (!writeCompressedStyleElement(out, *node))
-						return false;
-					goto close;
-				}
-				
-				for (const Node* child = node->child ; child != nullptr ; child = child->next){
-					node_stack.emplace_back(child);
-				}
-				
-				depth++;
-				continue;
-			}
-			
-			// Empty
-			else { close:
-				out << "</" << node->name() << ">";
-				add_space = node->options % NodeOptions::SPACE_AFTER;
-				goto pop;
-			}
-			
-			continue;
-		}
-		
-		
-		pop: {
-			node_stack.pop_back();
-			
-			// Check if node is last of the siblings
-			while (!node_stack.empty() && node_stack.back() == node->parent){
-				node = node_stack.back();
-				node_stack.pop_back();
-				
-				depth--;
-				if (!skip_space && add_space){
-					out << '\n' << tabs(depth);
-				}
-				
-				out << "</" << node->name() << ">";
-				
-				skip_space = false;
-				add_space = node->options % NodeOptions::SPACE_AFTER;
-			}
-			
-			continue;
 		}
 		
-		continue;
 	}
-	
-	if (add_space){
-		out << '\n';
-	}
-	
 	return true;
 }
 
@@ -376,103 +256,370 @@ static void writeCompressedText(ostream& out, string_view txt){
 }
 
 
-static bool writeCompressedHTML(ostream& out, const Document& doc, WriteOptions options){
-	vector<const Node*> node_stack = {};	// Child node list is reversed.
-	vector<const Attr*> attr_stack = {};	// Attr list is reversed.
+// ---------------------------------- [ Constructors ] -------------------------------------- //
+
+
+HtmlWriter::HtmlWriter(ostream& out, const Document& doc, WriteOptions options) : out{out}, options{options} {
 	node_stack.reserve(64);
 	attr_stack.reserve(16);
+	parents.reserve(16);
+	
+	elements.push_back(Element{&doc, 0, nullptr});
+	parents.push_back(&doc);
+}
+	
+	
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+		
+			
+void HtmlWriter::stepUncompressedHTML(){
+	const Item item = node_stack.back();
+	const Node* node = item.node;
 	
-	const Node* parent = &doc;
-	int preserveSpaceIdx = 0;
+	if (item.open){
+		goto end;
+	}
 	
-	// Push children of root element (reverse list)
-	for (const Node* child = doc.child ; child != nullptr ; child = child->next){
-		node_stack.emplace_back(child);
+	switch (node->type){
+		case NodeType::TEXT:
+			goto text;
+		case NodeType::TAG:
+			goto tag;
+		case NodeType::DIRECTIVE:
+			goto directive;
+		default:
+			goto pop;
 	}
 	
-	while (!node_stack.empty()){
-		const Node* node = node_stack.back();
-		node_stack.pop_back();
+	
+	text: {
+		// Raw unmodified text
+		if (item.parent != nullptr && item.parent->name() == "pre"sv){
+			out << node->value();
+			skip_space = true;
+			add_space = false;
+		}
+		
+		// Stack text nodes
+		else if (node_stack.size() >= 2 && node_stack.end()[-2].node->type == NodeType::TEXT){
+			writeIndentedText(out, node->value(), depth);
+		}
 		
-		// Close previous element child groups
-		while (parent != node->parent){
-			assert(parent != nullptr && parent != &doc);
+		// Single text node
+		else {
+			string_view text = trim_nl_suffix(node->value());
+			bool trimmed = (text.length() != size_t(node->value_len));
+			trimmed |= (item.self->options % NodeOptions::SPACE_AFTER);
 			
-			if (shouldPreserveWhitespace(parent->name())){
-				preserveSpaceIdx--;
+			// Prefix with whitespace
+			if (item.self->options % NodeOptions::SPACE_BEFORE){ [[unlikely]]
+				if (!text.empty() && !isWhitespace(text[0]))
+					out << '\n' << tabs(depth);
 			}
 			
-			out << "</" << parent->name() << '>';
-			parent = parent->parent;
+			writeIndentedText(out, text, depth);
+			
+			skip_space = !trimmed;
+			add_space = trimmed;
 		}
 		
-		switch (node->type){
-			case NodeType::TEXT:
-				goto text;
-			case NodeType::TAG:
-				goto tag;
-			case NodeType::DIRECTIVE:
-				goto directive;
-			default:
-				continue;
+		goto pop;
+	}
+	
+	
+	directive: {
+		if (!skip_space && (add_space || item.self->options % NodeOptions::SPACE_BEFORE)){
+			out << '\n' << tabs(depth);
 		}
 		
-		tag: {
-			if (preserveSpaceIdx > 0 && node->options % NodeOptions::SPACE_BEFORE){
-				out << ' ';
-			}
+		out << '<' << node->value() << '>';
 			
-			out << '<' << node->name();
-			writeAttributes(out, *node, attr_stack);
+		skip_space = false;
+		add_space = item.self->options % NodeOptions::SPACE_AFTER;
+		goto pop;
+	}
 			
-			// Close tag or whole element
-			if (node->child == nullptr){
-				if (node->options % NodeOptions::SELF_CLOSE)
-					out << "/>";
-				else
-					out << "></" << node->name() << '>';
-				continue;
-			} else {
-				out << '>';
-			}
+	
+	tag: {
+		if (!skip_space && (add_space || item.self->options % NodeOptions::SPACE_BEFORE)){
+			out << '\n';
+			out << tabs(depth);
+		}
+		
+		add_space = false;
+		skip_space = false;
+		
+		// Tag name
+		out << '<' << node->name();
+		writeAttributes(out, *node, item.borrowed, attr_stack);
+		
+		if (node->child == nullptr && item.self->options % NodeOptions::SELF_CLOSE){
+			out << "/>";
+			add_space = item.self->options % NodeOptions::SPACE_AFTER;
+			goto pop;
+		} else {
+			out << '>';
+		}
+		
+		// Enqueue children
+		if (node->child != nullptr){
 			
 			// Directly compress CSS
 			if (node->name() == "style"sv && options % WriteOptions::COMPRESS_CSS){
-				if (!writeCompressedStyleElement(out, *node))
-					return false;
-				out << "</" << node->name() << '>';
-				continue;
-			}
-			
-			// Enqueue children
-			for (const Node* child = node->child ; child != nullptr ; child = child->next){
-				node_stack.emplace_back(child);
+				if (!writeCompressedStyleElement(out, *node)){
+					failed = true;
+					return;
+				}
+				goto close;
 			}
 			
-			if (shouldPreserveWhitespace(node->name())){
-				preserveSpaceIdx++;
-			}
+			node_stack.back().open = true;
+			pushChildren(node_stack, *node, item.borrowed);
+			depth++;
+			return;
+		}
 			
-			parent = node;
-		} continue;
+		// Empty
+		else { close:
+			out << "</" << node->name() << ">";
+			add_space = item.self->options % NodeOptions::SPACE_AFTER;
+			goto pop;
+		}
+		
+	}
+	
+	
+	// All children are written
+	end: {
+		depth--;
+		if (!skip_space && add_space){
+			out << '\n' << tabs(depth);
+		}
+		
+		out << "</" << node->name() << ">";
+		
+		skip_space = false;
+		add_space = item.self->options % NodeOptions::SPACE_AFTER;
+		goto pop;
+	}
+	
+	
+	pop:
+	node_stack.pop_back();
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+void HtmlWriter::closeCompressedHTML(const Node* parent){
+	while (parents.back() != parent){
+		const Node* p = parents.back();
+		assert(p != nullptr && parents.size() > 1);
+		
+		if (shouldPreserveWhitespace(p->name())){
+			preserveSpaceIdx--;
+		}
+		
+		out << "</" << p->name() << '>';
+		parents.pop_back();
+	}
+}
+
+
+void HtmlWriter::stepCompressedHTML(){
+	const Item item = node_stack.back();
+	const Node* node = item.node;
+	node_stack.pop_back();
+	
+	// Close previous element child groups
+	closeCompressedHTML(item.parent);
+	
+	switch (node->type){
+		case NodeType::TEXT:
+			goto text;
+		case NodeType::TAG:
+			goto tag;
+		case NodeType::DIRECTIVE:
+			goto directive;
+		default:
+			return;
+	}
+	
+	tag: {
+		if (preserveSpaceIdx > 0 && item.self->options % NodeOptions::SPACE_BEFORE){
+			out << ' ';
+		}
+		
+		out << '<' << node->name();
+		writeAttributes(out, *node, item.borrowed, attr_stack);
 		
+		// Close tag or whole element
+		if (node->child == nullptr){
+			if (item.self->options % NodeOptions::SELF_CLOSE)
+				out << "/>";
+			else
+				out << "></" << node->name() << '>';
+			return;
+		} else {
+			out << '>';
+		}
 		
-		text: {
-			writeCompressedText(out, node->value());
-		} continue;
+		// Directly compress CSS
+		if (node->name() == "style"sv && options % WriteOptions::COMPRESS_CSS){
+			if (!writeCompressedStyleElement(out, *node))
+				failed = true;
+			else
+				out << "</" << node->name() << '>';
+			return;
+		}
 		
+		// Enqueue children
+		pushChildren(node_stack, *node, item.borrowed);
 		
-		directive: {
-			out << '<' << node->value() << ">\n";
-		} continue;
+		if (shouldPreserveWhitespace(node->name())){
+			preserveSpaceIdx++;
+		}
 		
+		parents.push_back(node);
+	} return;
+	
+	
+	text: {
+		writeCompressedText(out, node->value());
+	} return;
+	
+	
+	directive: {
+		out << '<' << node->value() << ">\n";
+	} return;
+
+}
+
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+
+
+/**
+ * @brief Queue children added to an open element since it was last queued.
+ *        They are inserted below the children queued before, which are written first.
+ */
+void HtmlWriter::queue(Element& element){
+	const Node* head = element.node->child;
+	if (head == element.last){
+		return;
+	}
+	
+	size_t n = 0;
+	for (const Node* child = head ; child != element.last ; child = child->next){
+		n++;
+	}
+	
+	auto it = node_stack.insert(node_stack.begin() + element.base, n, Item{});
+	for (const Node* child = head ; child != element.last ; child = child->next){
+		*it++ = item(*child, *element.node, false);
+	}
+	
+	element.last = head;
+}
+
+
+/**
+ * @brief Write queued nodes until only `stop` items remain.
+ */
+void HtmlWriter::run(size_t stop){
+	while (node_stack.size() > stop && !failed){
+		if (options % WriteOptions::COMPRESS_HTML)
+			stepCompressedHTML();
+		else
+			stepUncompressedHTML();
+	}
+}
+
+
+bool HtmlWriter::isOpen(const Node& node) const noexcept {
+	for (auto it = elements.rbegin() ; it != elements.rend() ; it++){
+		if (it->node == &node)
+			return true;
+	}
+	return false;
+}
+
+
+bool HtmlWriter::open(const Node& node){
+	if (failed || node_stack.empty()){
+		return false;
+	}
+	
+	const Item& item = node_stack.back();
+	if (item.node != &node || item.open || node.type != NodeType::TAG || node.child == nullptr){
+		return false;
+	}
+	
+	// Compressed CSS is written from all text of the element at once.
+	if (node.name() == "style"sv && options % WriteOptions::COMPRESS_CSS){
+		return false;
+	}
+	
+	// Compressed writer pops the element, uncompressed keeps it below its children.
+	size_t base;
+	if (options % WriteOptions::COMPRESS_HTML){
+		base = node_stack.size() - 1;
+		stepCompressedHTML();
+	} else {
+		base = node_stack.size();
+		stepUncompressedHTML();
+	}
+	
+	elements.push_back(Element{&node, base, node.child});
+	return !failed;
+}
+
+
+void HtmlWriter::write(const Node& parent){
+	assert(isOpen(parent));
+	
+	while (elements.back().node != &parent){
+		queue(elements.back());
+		elements.pop_back();
+	}
+	
+	Element& element = elements.back();
+	queue(element);
+	run(element.base + 1);
+	
+	// Close completed children before they are freed.
+	if (options % WriteOptions::COMPRESS_HTML && !failed){
+		if (node_stack.size() == element.base + 1 && node_stack.back().parent == &parent)
+			closeCompressedHTML(&parent);
+	}
+
+}
+
+
+bool HtmlWriter::finish(){
+	while (elements.size() > 1){
+		queue(elements.back());
+		elements.pop_back();
+	}
+	
+	queue(elements.back());
+	run(0);
+	
+	if (failed){
+		return false;
 	}
 	
 	// Write missing tail elements
-	while (parent != &doc){
-		assert(parent != nullptr);
-		out << "</" << parent->name() << '>';
-		parent = parent->parent;
+	if (options % WriteOptions::COMPRESS_HTML){
+		while (parents.size() > 1){
+			out << "</" << parents.back()->name() << '>';
+			parents.pop_back();
+		}
+	}
+	
+	else if (add_space){
+		out << '\n';
 	}
 	
 	return true;
@@ -488,11 +635,8 @@ bool write(ostream& out, const Document& doc, WriteOptions options){
 		out << std::unitbuf;
 	#endif
 	
-	if (options % WriteOptions::COMPRESS_HTML)
-		writeCompressedHTML(out, doc, options);
-	else
-		writeUncompressedHTML(out, doc, options);
-	
+	HtmlWriter writer = HtmlWriter(out, doc, options);
+	writer.finish();
 	return true;
 }
 
@@ -1,9 +1,12 @@
 #pragma once
 #include <ostream>
+#include <vector>
 #include "EnumOperators.hpp"
 
 
 namespace html {
+	struct Node;
+	struct Attr;
 	class Document;
 };
 
@@ -16,5 +19,100 @@ enum class WriteOptions {
 ENUM_OPERATORS(WriteOptions);
 
 
+/**
+ * @brief Writes a document in parts, while it is still being built.
+ *        Start tags of elements are written with `open()` and their completed children with `write()`.
+ *        The last child of each open element is held back, since it may still change
+ *        and whitespace around text depends on the following sibling.
+ *        Remaining nodes and end tags are written by `finish()`.
+ */
+class HtmlWriter {
+// ----------------------------------- [ Structures ] --------------------------------------- //
+public:
+	/**
+	 * @brief Node queued for writing.
+	 *        Nodes of borrowed subtrees belong to the macro source, so their child lists are in document order
+	 *        and the root of the subtree takes its parent and options from the `NodeType::BORROWED` node.
+	 */
+	struct Item {
+		const html::Node* node;
+		const html::Node* parent;
+		const html::Node* self;		// Node in the child list of `parent`, holds the options of `node`.
+		bool borrowed;				// Node is part of a borrowed subtree.
+		bool open;					// Start tag is written, children are queued above the item.
+	};
+	
+	/**
+	 * @brief Element whose start tag is written while its children are still being created.
+	 */
+	struct Element {
+		const html::Node* node;
+		size_t base;				// Index of the first queued child in `node_stack`.
+		const html::Node* last;		// Newest child queued for writing.
+	};
+
+// ------------------------------------[ Properties ] --------------------------------------- //
+private:
+	std::ostream& out;
+	WriteOptions options;
+	bool failed = false;
+	
+	std::vector<Item> node_stack;
+	std::vector<const html::Attr*> attr_stack;
+	std::vector<Element> elements;		// Open elements, the document first.
+	
+	// Uncompressed HTML
+	int depth = 0;
+	bool add_space = false;
+	bool skip_space = false;
+	
+	// Compressed HTML
+	std::vector<const html::Node*> parents;	// Elements without end tags.
+	int preserveSpaceIdx = 0;
+
+// ---------------------------------- [ Constructors ] -------------------------------------- //
+public:
+	HtmlWriter(std::ostream& out, const html::Document& doc, WriteOptions options = WriteOptions::NONE);
+
+// ----------------------------------- [ Functions ] ---------------------------------------- //
+public:
+	/**
+	 * @brief Check if start tag of `node` has been written and its end tag has not.
+	 *        The document is always open.
+	 */
+	bool isOpen(const html::Node& node) const noexcept;
+	
+	/**
+	 * @brief Write start tag of an element. Its name and attributes must not change afterwards.
+	 * @param node Last child of an open element, whose previous siblings have been written with `write()`.
+	 * @return `false` if the element can not be written in parts, such as `<style>` with compressed CSS.
+	 */
+	bool open(const html::Node& node);
+	
+	/**
+	 * @brief Write all children of an open element except the last one.
+	 *        Open elements within earlier children are considered complete.
+	 *        Written nodes are not accessed again and can be freed.
+	 * @param parent Open element.
+	 */
+	void write(const html::Node& parent);
+	
+	/**
+	 * @brief Write all remaining nodes and close open elements.
+	 * @return `false` if the document could not be written.
+	 */
+	bool finish();
+
+private:
+	void queue(Element& element);
+	void run(size_t stop);
+	void stepUncompressedHTML();
+	void stepCompressedHTML();
+	void closeCompressedHTML(const html::Node* parent);
+
+// ------------------------------------------------------------------------------------------ //
+};
+
+
 bool write(std::ostream& out, const html::Document& doc, WriteOptions options = WriteOptions::NONE);
 bool compressCSS(std::ostream& out, const char* beg, const char* end);
@@ -115,6 +115,63 @@ Result test_element_macro_MACRO_nested(){
 }
 
 
+REGISTER2(element_macro_static);
+Result test_element_macro_static(){
+	TmpFile in = TmpFile("element_macro_static.html",
+		"<MACRO NAME=\"ICON\">" NL
+		"	<svg width=\"8\" height=\"8\"><path d=\"M0 0L8 8\" fill=\"red\"/></svg>" NL
+		"</MACRO>" NL
+		"<div>" NL
+		"	<ICON/>" NL
+		"	<IF TRUE='1'><p>a <b>b</b> c</p></IF>" NL
+		"	<pre>  x" NL
+		"  y</pre>" NL
+		"</div>" NL
+	);
+	string_view out = (
+		NL
+		"<div>" NL
+		"	<svg width=\"8\" height=\"8\"><path d=\"M0 0L8 8\" fill=\"red\"/></svg>" NL
+		"	<p>a <b>b</b> c</p>" NL
+		"	<pre>  x" NL
+		"  y</pre>" NL
+		"</div>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
+REGISTER2(element_macro_memo);
+Result test_element_macro_memo(){
+	TmpFile in = TmpFile("element_macro_memo.html",
+		"<MACRO NAME=\"LABEL\" text=\"\">" NL
+		"	<b class=\"{kind}\">{text}</b>" NL
+		"</MACRO>" NL
+		"<MACRO NAME=\"COUNT\"><SET n='n + 1'/>{n}</MACRO>" NL
+		"<MACRO NAME=\"WRAP\"><i><COUNT/></i></MACRO>" NL
+		"<SET kind=\"a\" n='0'/>" NL
+		"<p>" NL
+		"	<LABEL text=\"x\"/>" NL
+		"	<LABEL text=\"x\"/>" NL
+		"	<SET kind=\"b\"/>" NL
+		"	<LABEL text=\"x\"/>" NL
+		"	<LABEL text=\"y\"/>" NL
+		"	<WRAP/><WRAP/>" NL
+		"</p>" NL
+	);
+	string_view out = (
+		NL
+		"<p>" NL
+		"	<b class=\"a\">x</b>" NL
+		"	<b class=\"a\">x</b>" NL
+		"	<b class=\"b\">x</b>" NL
+		"	<b class=\"b\">y</b>" NL
+		"	<i>1</i><i>2</i></p>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
@@ -329,6 +386,27 @@ Result test_element_macro_INCLUDE_header(){
 }
 
 
+REGISTER2(element_macro_INCLUDE_shadow);
+Result test_element_macro_INCLUDE_shadow(){
+	TmpFile othr = TmpFile("element_macro_INCLUDE_shadow-othr.html",
+		"<MACRO NAME=\"ITEM\"><i>b</i></MACRO>" NL
+	);
+	TmpFile in = TmpFile("element_macro_INCLUDE_shadow.html",
+		"<MACRO NAME=\"ITEM\"><b>a</b></MACRO>" NL
+		"<FOR i='0' TRUE='i < 2' i='i + 1'>" NL
+		"	<ITEM/>" NL
+		"	<INCLUDE HEADER SRC=\"element_macro_INCLUDE_shadow-othr.html\"/>" NL
+		"</FOR>" NL
+		"<p ITEM>x</p>" NL
+	);
+	string_view out = (
+		"<b>a</b><i>b</i>" NL
+		"<p><i>b</i>x</p>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
@@ -422,4 +500,70 @@ Result test_element_macro_ELSE(){
 }
 
 
+REGISTER2(element_macro_SHELL_CACHE);
+Result test_element_macro_SHELL_CACHE(){
+	TmpFile in = TmpFile("element_macro_SHELL_CACHE.html",
+		R"(
+			<SHELL CACHE STDOUT="a">date +%N</SHELL>
+			<SHELL CACHE STDOUT="b">date +%N</SHELL>
+			<p IF='a == b'>SAME</p>
+			<SET n='1'/>
+			<p><SHELL CACHE VARS="n">echo $n</SHELL></p>
+			<SET n='2'/>
+			<p><SHELL CACHE="BUILD" VARS="n">echo $n</SHELL></p>
+		)"
+	);
+	string_view out = (
+		NL
+		"<p>SAME</p>" NL
+		"<p>1</p>" NL
+		"<p>2</p>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
+REGISTER2(element_macro_SHELL_CACHE_ASYNC);
+Result test_element_macro_SHELL_CACHE_ASYNC(){
+	TmpFile count = TmpFile("SHELL_CACHE_ASYNC.count", "");
+	TmpFile in = TmpFile("element_macro_SHELL_CACHE_ASYNC.html",
+		R"(
+			<ul><FOR i='0' TRUE='i<3' i='i+1'><li><SHELL CACHE="60">echo x >> SHELL_CACHE_ASYNC.count; echo y</SHELL></li></FOR></ul>
+			<SHELL CACHE STDOUT="v">echo x >> SHELL_CACHE_ASYNC.count; echo y</SHELL>
+			<SHELL STDOUT="n">wc -l < SHELL_CACHE_ASYNC.count</SHELL>
+			<p>{v} {n}</p>
+		)"
+	);
+	string_view out = (
+		NL
+		"<ul><li>y</li><li>y</li><li>y</li></ul>" NL
+		"<p>y 1</p>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
+REGISTER2(element_macro_SHELL_ASYNC);
+Result test_element_macro_SHELL_ASYNC(){
+	TmpFile in = TmpFile("element_macro_SHELL_ASYNC.html",
+		R"(
+			<SHELL STDOUT="VOID">rm -f SHELL_ASYNC.fifo SHELL_ASYNC.flag; mkfifo SHELL_ASYNC.fifo</SHELL>
+			<p><SHELL>timeout 5 cat SHELL_ASYNC.fifo</SHELL></p>
+			<p><SHELL>timeout 5 bash -c 'echo concurrent > SHELL_ASYNC.fifo'; touch SHELL_ASYNC.flag; echo created</SHELL></p>
+			<p><SHELL>true</SHELL></p>
+			<SHELL STDOUT="v">[ -f SHELL_ASYNC.flag ] && echo ordered; rm -f SHELL_ASYNC.fifo SHELL_ASYNC.flag</SHELL>
+			<p>{v}</p>
+		)"
+	);
+	string_view out = (
+		NL
+		"<p>concurrent</p>" NL
+		"<p>created</p>" NL
+		"<p></p>" NL
+		"<p>ordered</p>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
 // ------------------------------------------------------------------------------------------ //
\ No newline at end of file
@@ -119,4 +119,188 @@ Result test_expression_slice(){
 }
 
 
+REGISTER2(expression_interpolate_loop);
+Result test_expression_interpolate_loop(){
+	TmpFile in = TmpFile("expression_interpolate_loop.html",
+		R"(
+			<FOR i='0' TRUE='i < 3' i='i + 1'>
+				<p class="c{i}">{i * 2} \{i} \\{i} {}</p>
+			</FOR>
+		)"
+	);
+	string_view out = (
+		NL
+		"<p class=\"c0\">0 {i} \\0 {}</p>" NL
+		"<p class=\"c1\">2 {i} \\1 {}</p>" NL
+		"<p class=\"c2\">4 {i} \\2 {}</p>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
+REGISTER2(expression_function_arity);
+Result test_expression_function_arity(){
+	TmpFile in = TmpFile("expression_function_arity.html",
+		"<p>{foo(1)}|{len()}</p>" NL
+		"<p>{len('abc', 1)}</p>" NL
+		"<a b=\"{foo(1)}\"/>" NL
+		"<SET x='foo(1)'/><p>{defined(x)}</p>" NL
+	);
+	string_view out = (
+		"<p>|</p>" NL
+		"<p>3</p>" NL
+		"<a b=\"\"/>" NL
+		"<p>0</p>" NL
+	);
+	string_view err = (
+		"/tmp/html-macro-test/expression_function_arity.html:1:5: error: Undefined function: 'foo()'" NL
+		"    1 | <p>{foo(1)}|{len()}</p>" NL
+		"      |     ^~~" NL
+		"/tmp/html-macro-test/expression_function_arity.html:1:14: error: Missing arguments (0/1) in function len(e)." NL
+		"    1 | <p>{foo(1)}|{len()}</p>" NL
+		"      |              ^~~~~" NL
+		"/tmp/html-macro-test/expression_function_arity.html:2:16: warn: Too many arguments (2/1) in function len(e)." NL
+		"    2 | <p>{len('abc', 1)}</p>" NL
+		"      |                ^" NL
+		"/tmp/html-macro-test/expression_function_arity.html:3:8: error: Undefined function: 'foo()'" NL
+		"    3 | <a b=\"{foo(1)}\"/>" NL
+		"      |        ^~~" NL
+		"/tmp/html-macro-test/expression_function_arity.html:4:9: error: Undefined function: 'foo()'" NL
+		"    4 | <SET x='foo(1)'/><p>{defined(x)}</p>" NL
+		"      |         ^~~" NL
+	);
+	return run({in}, out, err, 0);
+}
+
+
+REGISTER2(expression_integer_division);
+Result test_expression_integer_division(){
+	TmpFile in = TmpFile("expression_integer_division.html",
+		"<SET a='0' b='-1' m='-9223372036854775807 - 1'/>" NL
+		"<p>{7 / a} {7 % a} {7.5 / a > 1} {7 / 2}</p>" NL
+		"<p>{m / b} {m % b}</p>" NL
+	);
+	string_view out = (
+		"" NL
+		"<p>  1 3</p>" NL
+		"<p> </p>" NL
+	);
+	string_view err = (
+		"/tmp/html-macro-test/expression_integer_division.html:2:5: warn: Integer division by zero." NL
+		"    2 | <p>{7 / a} {7 % a} {7.5 / a > 1} {7 / 2}</p>" NL
+		"      |     ^~~~~" NL
+		"/tmp/html-macro-test/expression_integer_division.html:2:13: warn: Integer division by zero." NL
+		"    2 | <p>{7 / a} {7 % a} {7.5 / a > 1} {7 / 2}</p>" NL
+		"      |             ^~~~~" NL
+		"/tmp/html-macro-test/expression_integer_division.html:3:5: warn: Integer division overflows." NL
+		"    3 | <p>{m / b} {m % b}</p>" NL
+		"      |     ^~~~~" NL
+		"/tmp/html-macro-test/expression_integer_division.html:3:13: warn: Integer division overflows." NL
+		"    3 | <p>{m / b} {m % b}</p>" NL
+		"      |             ^~~~~" NL
+	);
+	return run({in}, out, err, 0);
+}
+
+
+REGISTER2(expression_regex_loop);
+Result test_expression_regex_loop(){
+	TmpFile in = TmpFile("expression_regex_loop.html",
+		R"(
+			<FOR i='0' TRUE='i < 3' i='i + 1'>
+				<p>{replace('a-' + i, '[0-9]', '#')} {match(str(i), '[12]')} {split('x' + i + 'y', '[0-9]')}</p>
+			</FOR>
+		)"
+	);
+	string_view out = (
+		NL
+		"<p>a-# 0 [\"x\",\"y\"]</p>" NL
+		"<p>a-# 1 [\"x\",\"y\"]</p>" NL
+		"<p>a-# 1 [\"x\",\"y\"]</p>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
+REGISTER2(expression_constant_folding);
+Result test_expression_constant_folding(){
+	TmpFile in = TmpFile("expression_constant_folding.html",
+		R"(
+			<SET x='3' a='2*60*60' b='upper("nav")' c='"a" + "b"' d='-len("abc") + 1.5'/>
+			<p>{a} {b} {c} {d} {if(1, "x", "y") + str(3)} {min(3, 1, 2) + 10 % 3} {!0 && 2 > 1}</p>
+			<p>{lower('ABC') + a} {1 + 2 * x} {x / 0.0 > 1}</p>
+		)"
+	);
+	string_view out = (
+		NL
+		"<p>7200 NAV ab -1.5 x3 2 1</p>" NL
+		"<p>abc7200 7 1</p>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
+REGISTER2(expression_short_strings);
+Result test_expression_short_strings(){
+	TmpFile in = TmpFile("expression_short_strings.html",
+		R"(
+			<SET a='"abcdefghijklm"' b='a + "n"' c='b - 1' d='b - 20' e='upper(a)' f='a * 2 - 13'/>
+			<p>{a} {len(a)} {b} {len(b)} {c == a} {len(d)} {e} {a} {f} {len(f)}</p>
+			<p>{str(1234567890123)} {str(-12345678901234)} {str(123456.25)}</p>
+		)"
+	);
+	string_view out = (
+		NL
+		"<p>abcdefghijklm 13 abcdefghijklmn 14 1 0 ABCDEFGHIJKLM abcdefghijklm abcdefghijklm 13</p>" NL
+		"<p>1234567890123 -12345678901234 123456.25</p>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
+REGISTER2(expression_string_append);
+Result test_expression_string_append(){
+	TmpFile in = TmpFile("expression_string_append.html",
+		R"(
+			<SET s="0123456789abcdef" html=""/>
+			<FOR i='0' TRUE='i < 3' i='i + 1'>
+				<SET copy='s' s='s + "-" + i' t='s + s' html='html + "<li>" + i + "</li>"'/>
+				<p>{copy} {s} {len(t)}</p>
+			</FOR>
+			<p>{html}</p>
+		)"
+	);
+	string_view out = (
+		NL
+		"<p>0123456789abcdef 0123456789abcdef-0 36</p>" NL
+		"<p>0123456789abcdef-0 0123456789abcdef-0-1 40</p>" NL
+		"<p>0123456789abcdef-0-1 0123456789abcdef-0-1-2 44</p>" NL
+		"<p><li>0</li><li>1</li><li>2</li></p>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
+REGISTER2(expression_shared_objects);
+Result test_expression_shared_objects(){
+	TmpFile in = TmpFile("expression_shared_objects.html",
+		R"(
+			<SET a='[]' d='[]'/>
+			<FOR i='0' TRUE='i < 2000' i='i + 1'>
+				<SET b='a' a='a + i' d='d + ["k" + i: i]'/>
+			</FOR>
+			<p>{len(a)} {len(b)} {a[1500]} {a[-1]} {b[-1]} {len(d)} {join(slice(a, 1020, 5), ",")}</p>
+			<SET c='a - 1500'/>
+			<p>{len(a)} {len(c)} {c[1500]} {a[1500]}</p>
+		)"
+	);
+	string_view out = (
+		NL
+		"<p>2000 1999 1500 1999 1998 2000 1020,1021,1022,1023,1024</p>" NL
+		"<p>2000 1999 1501 1500</p>" NL
+	);
+	return run({in}, out, "", 0);
+}
+
+
 // ------------------------------------------------------------------------------------------ //
\ No newline at end of file
@@ -77,4 +77,133 @@ Result test_file_8(){
 }
 
 
+REGISTER("file_batch", test_file_batch);
+Result test_file_batch(){
+	const int files[] = {1, 2, 3, 4, 5, 7, 8, 1};
+	string manifest;
+	string out;
+	
+	for (int i : files){
+		manifest += "test/test-" + to_string(i) + ".in.html -\n";
+		out += slurp("test/test-" + to_string(i) + ".out.html");
+	}
+	
+	TmpFile in = TmpFile("file_batch.txt", manifest);
+	string err = "";
+	return run({"--batch", in, "definedVariable=hello defined world"}, out, err);
+}
+
+
+REGISTER("file_batch_stdin", test_file_batch_stdin);
+Result test_file_batch_stdin(){
+	const int files[] = {1, 2, 3, 4, 5, 7, 8, 1};
+	string manifest;
+	string out;
+	
+	// Manifest shorter than a single read of the stream.
+	for (int i : files){
+		manifest += "test/test-" + to_string(i) + ".in.html -\n";
+		out += slurp("test/test-" + to_string(i) + ".out.html");
+	}
+	
+	string err = "";
+	return run({"--batch", "-", "definedVariable=hello defined world"}, out, err, 0, manifest);
+}
+
+
+REGISTER("file_batch_jobs", test_file_batch_jobs);
+Result test_file_batch_jobs(){
+	const int files[] = {1, 2, 3, 4, 5, 7, 8, 1, 2, 3, 4, 5, 7, 8};
+	string manifest;
+	string out;
+	
+	for (int i : files){
+		manifest += "test/test-" + to_string(i) + ".in.html\n";
+		out += slurp("test/test-" + to_string(i) + ".out.html");
+	}
+	
+	// Output of all threads is written in order of the manifest.
+	TmpFile in = TmpFile("file_batch_jobs.txt", manifest);
+	string err = "";
+	return run({"--batch", in, "-j", "4", "definedVariable=hello defined world"}, out, err);
+}
+
+
+REGISTER("file_batch_scope", test_file_batch_scope);
+Result test_file_batch_scope(){
+	TmpFile h1 = TmpFile("file_batch_scope/h1.html", R"(<MACRO NAME="CARD"><p>1 {t}</p></MACRO>)");
+	TmpFile h2 = TmpFile("file_batch_scope/h2.html", R"(<MACRO NAME="CARD"><p>2 {t}</p></MACRO>)");
+	TmpFile a = TmpFile("file_batch_scope/a.html", R"(<INCLUDE HEADER SRC="h1.html"/><SET t='"a"'/><CARD/>)");
+	TmpFile b = TmpFile("file_batch_scope/b.html", R"(<INCLUDE HEADER SRC="h2.html"/><SET t='"b"'/><CARD/>)");
+	TmpFile c = TmpFile("file_batch_scope/c.html", R"(<INCLUDE HEADER SRC="h1.html"/><SET t='"c"'/><CARD/>)");
+	
+	// Each input sees only the macros it included.
+	TmpFile in = TmpFile("file_batch_scope.txt",
+		string(a) + "\n" +
+		"# comment\n" +
+		string(b) + " -\n" +
+		"\n" +
+		string(c) + "\n"
+	);
+	string out = "<p>1 a</p><p>2 b</p><p>1 c</p>";
+	string err = "";
+	return run({"--batch", in}, out, err);
+}
+
+
+REGISTER("file_depfile", test_file_depfile);
+Result test_file_depfile(){
+	TmpFile h = TmpFile("file_depfile/head.html", R"(<MACRO NAME="CARD"><p>{t}</p></MACRO>)");
+	TmpFile in = TmpFile("file_depfile/in.html", R"(<SET f='"head" + ".html"'/><INCLUDE HEADER SRC='f'/><SET t='"a"'/><CARD/>)");
+	TmpFile out = TmpFile("file_depfile/out.html", "");
+	TmpFile dep = TmpFile("file_depfile/out.d", "");
+	
+	// Files included by expressions are recorded while rendering.
+	const string head = filesystem::relative(h.path).string();
+	const string rules =
+		string(out) + ": \\\n" +
+		"  " + string(in) + " \\\n" +
+		"  " + head + "\n" +
+		head + ":\n" +
+		"\n";
+	
+	Result res = run({in, "-o", out, "--depfile", dep}, "", "");
+	const string recieved = slurp(dep.path);
+	if (recieved != rules){
+		res.expectedStdout = rules;
+		res.recievedStdout = recieved;
+	}
+	
+	return res;
+}
+
+
+REGISTER("file_cache", test_file_cache);
+Result test_file_cache(){
+	const filepath dir = "/tmp/html-macro-test/file_cache.d";
+	filesystem::remove_all(dir);
+	
+	TmpFile h = TmpFile("file_cache/head.html", R"(<MACRO NAME="CARD"><p>1 {t}</p></MACRO>)");
+	TmpFile in = TmpFile("file_cache/in.html", R"(<INCLUDE HEADER SRC="head.html"/><CARD/>)");
+	
+	Result res = run({in, "--cache", dir, "t=a"}, "<p>1 a</p>", "");
+	if (res){
+		res = run({in, "--cache", dir, "t=a"}, "<p>1 a</p>", "");
+	}
+	
+	// Variables and included files are part of the key.
+	if (res){
+		res = run({in, "--cache", dir, "t=b"}, "<p>1 b</p>", "");
+	}
+	
+	if (res){
+		TmpFile h2 = TmpFile("file_cache/head.html", R"(<MACRO NAME="CARD"><p>2 {t}</p></MACRO>)");
+		res = run({in, "--cache", dir, "t=a"}, "<p>2 a</p>", "");
+	}
+	
+	filesystem::remove_all(dir);
+	return res;
+}
+
+
 // ------------------------------------------------------------------------------------------ //
\ No newline at end of file
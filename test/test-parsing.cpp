@@ -75,4 +75,55 @@ Result test_parse_output_compress_css_2(){
 }
 
 
+REGISTER2(parse_output_stream);
+Result test_parse_output_stream(){
+	TmpFile in = TmpFile("parse_output_stream.html",
+		R"(
+			<ul>
+				<FOR i='0' TRUE='i < 2000' i='i+1'>
+					<li>{i}</li>
+				</FOR>
+			</ul>
+			<div>
+				<FOR i='0' TRUE='i < 2000' i='i+1'>
+					<p>{i}</p>
+				</FOR>
+				<SET-ATTR id='"last"'/>
+			</div>
+		)"
+	);
+	
+	string out = NL "<ul>" NL;
+	for (int i = 0 ; i < 2000 ; i++)
+		out += "\t<li>" + to_string(i) + "</li>" NL;
+	out += "</ul>" NL "<div id=\"last\">" NL;
+	for (int i = 0 ; i < 2000 ; i++)
+		out += "\t<p>" + to_string(i) + "</p>" NL;
+	out += "</div>" NL;
+	
+	return run({in, "--stream"}, out, "", 0);
+}
+
+
+REGISTER2(parse_output_stream_compress);
+Result test_parse_output_stream_compress(){
+	TmpFile in = TmpFile("parse_output_stream_compress.html",
+		R"(
+			<ul>
+				<FOR i='0' TRUE='i < 2000' i='i+1'>
+					<li>{i}</li>
+				</FOR>
+			</ul>
+		)"
+	);
+	
+	string out = "<ul>";
+	for (int i = 0 ; i < 2000 ; i++)
+		out += "<li>" + to_string(i) + "</li>";
+	out += "</ul>";
+	
+	return run({in, "--stream", "--compress=html"}, out, "", 0);
+}
+
+
 // ------------------------------------------------------------------------------------------ //
\ No newline at end of file
@@ -92,13 +92,15 @@ TmpFile::~TmpFile(){
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
-int exe(const vector<string>& args, string& out, string& err){
+int exe(const vector<string>& args, string& out, string& err, string_view in){
+	fs::FileDesc in0;
+	fs::FileDesc in1;
 	fs::FileDesc out0;
 	fs::FileDesc out1;
 	fs::FileDesc err0;
 	fs::FileDesc err1;
 	
-	if (!fs::pipe(out0, out1) || !fs::pipe(err0, err1)){
+	if (!fs::pipe(in0, in1) || !fs::pipe(out0, out1) || !fs::pipe(err0, err1)){
 		ERROR("Internal error when creating a pipe.");
 		return 100;
 	}
@@ -107,8 +109,11 @@ int exe(const vector<string>& args, string& out, string& err){
 	
 	// Child
 	if (pid == 0){
+		dup2(in0, 0);
 		dup2(out1, 1);
 		dup2(err1, 2);
+		in0.close();
+		in1.close();
 		out0.close();
 		out1.close();
 		err0.close();
@@ -127,9 +132,19 @@ int exe(const vector<string>& args, string& out, string& err){
 	
 	// Parent
 	else if (pid > 0){
+		in0.close();
 		out1.close();
 		err1.close();
 		
+		future writer = async(launch::async, [&](){
+			for (size_t n = 0 ; n < in.size() ; ){
+				const ssize_t w = write(in1, in.data() + n, in.size() - n);
+				if (w <= 0)
+					break;
+				n += size_t(w);
+			}
+			in1.close();
+		});
 		future reader1 = async(launch::async, [&](){
 			slurp(out0, out);
 		});
@@ -140,6 +155,7 @@ int exe(const vector<string>& args, string& out, string& err){
 		bool ok = true;
 		ok &= (reader1.wait_for(1s) == future_status::ready);
 		ok &= (reader2.wait_for(1s) == future_status::ready);
+		ok &= (writer.wait_for(1s) == future_status::ready);
 		out0.close();
 		out1.close();
 			
@@ -162,13 +178,13 @@ int exe(const vector<string>& args, string& out, string& err){
 // ----------------------------------- [ Functions ] ---------------------------------------- //
 
 
-Result run(const vector<string>& args, string_view out, string_view err, int status){
+Result run(const vector<string>& args, string_view out, string_view err, int status, string_view in){
 	Result res;
 	string out_buff;
 	string err_buff;
 	
 	res.expectedStatus = status;
-	res.recievedStatus = exe(args, out_buff, err_buff);
+	res.recievedStatus = exe(args, out_buff, err_buff, in);
 	
 	if (out_buff != out){
 		res.expectedStdout = string(out);
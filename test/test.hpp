@@ -82,8 +82,8 @@ bool slurp(int fd, std::string& buff);
 bool slurp(const filepath& path, std::string& buff);
 std::string slurp(const filepath& path);
 
-int exe(const std::vector<std::string>& args, std::string& out, std::string& err);
-Result run(const std::vector<std::string>& args, std::string_view out, std::string_view err, int status = 0);
+int exe(const std::vector<std::string>& args, std::string& out, std::string& err, std::string_view in = {});
+Result run(const std::vector<std::string>& args, std::string_view out, std::string_view err, int status = 0, std::string_view in = {});
 
 
 // ------------------------------------------------------------------------------------------ //
\ No newline at end of file